@@ -1,148 +1,675 @@
 #include "algorithm.h"
 #include "transport_system.h"
 #include "exceptions.h"
+#include "query_context.h"
+#include "thread_pool.h"
 #include <queue>
 #include <algorithm>
+#include <limits>
+#include <memory_resource>
+#include <optional>
+
+// Ключ сравнения маршрутов по критерию: {основной показатель, время в пути}
+// Для частичного пути ключ является нижней границей ключа любого его продолжения,
+// так как количество пересадок и время в пути вдоль пути не убывают
+static std::pair<int, int> journeyKey(int transfers, int duration, JourneyCriterion criterion) {
+    if (criterion == JourneyCriterion::Transfers) {
+        return {transfers, duration};
+    }
+    return {0, duration};
+}
+
+// Базовая реализация top-K: сортирует все найденные маршруты и оставляет первые k
+List<Journey> PathFindingAlgorithm::findTopK(const std::string& start,
+                                             const std::string& end,
+                                             const Time& departureTime,
+                                             size_t k,
+                                             JourneyCriterion criterion) {
+    auto journeys = findPath(start, end, departureTime);
+
+    // Сортировка устойчивая, поэтому маршруты с равным ключом сохраняют исходный порядок
+    journeys.sort([criterion](const Journey& a, const Journey& b) {
+        return journeyKey(a.getTransferCount(), a.getTotalDuration(), criterion) <
+               journeyKey(b.getTransferCount(), b.getTotalDuration(), criterion);
+    });
+
+    List<Journey> result;
+    for (const auto& journey : journeys) {
+        if (result.size() >= k) {
+            break;
+        }
+        result.push_back(journey);
+    }
+    return result;
+}
 
 // Поиск маршрутов с использованием алгоритма BFS (поиск в ширину)
 // Находит все возможные маршруты между остановками с учетом ограничения на количество пересадок
 List<Journey> BFSAlgorithm::findPath(const std::string& start,
                                            const std::string& end,
                                            const Time& departureTime) {
-    List<Journey> journeys;
+    // Без ограничения на k: результат совпадает с полным перебором,
+    // отсортированным по времени в пути
+    return findTopK(start, end, departureTime,
+                    std::numeric_limits<size_t>::max(), JourneyCriterion::Duration);
+}
 
-    // Узел поиска: содержит текущую остановку, время, пройденный путь и пересадки
-    struct SearchNode {
-        std::string currentStop;              // Текущая остановка
-        Time currentTime;                     // Текущее время
-        List<std::shared_ptr<Trip>> pathTrips; // Рейсы, использованные в пути
-        List<std::string> transferPoints;     // Остановки, где были пересадки
-        int transfers;                        // Количество пересадок
-    };
+void BFSAlgorithm::setThreadCount(size_t threads) {
+    threadCount = threads == 0 ? ThreadPool::shared().getThreadCount() + 1 : threads;
+}
 
-    std::queue<SearchNode> q;
-    // Начинаем поиск с начальной остановки
-    q.push({start, departureTime, {}, {}, 0});
+// Поиск k лучших маршрутов алгоритмом BFS
+// Найденные маршруты хранятся в ограниченной куче (max-heap по ключу критерия),
+// на вершине которой находится текущий k-й лучший маршрут. Как только куча заполнена,
+// узлы, ключ которых не меньше ключа вершины, отбрасываются: ни одно их продолжение
+// не может попасть в top-K. Память и время зависят от k, а не от числа всех маршрутов.
+// Узлы поиска хранятся в арене контекста запроса и ссылаются на родителя по номеру,
+// поэтому путь не копируется в каждый узел; объекты Journey создаются только для результата
+List<Journey> BFSAlgorithm::findTopK(const std::string& start,
+                                     const std::string& end,
+                                     const Time& departureTime,
+                                     size_t k,
+                                     JourneyCriterion criterion) {
+    List<Journey> journeys;
+    truncated = false;
+    if (k == 0) {
+        return journeys;
+    }
 
-    while (!q.empty()) {
-        auto node = q.front();
-        q.pop();
+    auto index = system->getJourneyPlanner().getTimetableIndex();
+    int startStop = index->getStopIndex(start);
+    int endStop = index->getStopIndex(end);
+    if (startStop < 0 || endStop < 0) {
+        return journeys;
+    }
+    int departureMinutes = departureTime.getTotalMinutes();
 
-        // Если достигли конечной остановки - сохраняем найденный маршрут
-        if (node.currentStop == end) {
-            journeys.push_back(Journey(node.pathTrips, node.transferPoints,
-                                 departureTime, node.currentTime));
-            continue;
-        }
+    // Узел поиска: текущая остановка, время и ссылка на родительский узел
+    // Каждый узел, кроме начального, соответствует одному участку пути на рейсе trip
+    struct SearchNode {
+        int stop;        // Номер текущей остановки
+        int time;        // Текущее время (минуты от начала суток)
+        int trip;        // Номер рейса последнего участка (-1 для начального узла)
+        int parent;      // Номер родительского узла (-1 для начального узла)
+        int transfers;   // Количество пересадок
+    };
 
-        // Пропускаем узлы с превышением лимита пересадок
-        if (node.transfers >= maxTransfers) {
-            continue;
+    // Элемент кучи найденных маршрутов
+    // Порядковый номер находки разрешает равенство ключей в пользу ранее найденного
+    // маршрута, как это делала устойчивая сортировка полного списка
+    struct FoundJourney {
+        std::pair<int, int> key;
+        size_t sequence;
+        int node;
+
+        bool operator<(const FoundJourney& other) const {
+            if (key != other.key) {
+                return key < other.key;
+            }
+            return sequence < other.sequence;
         }
+    };
 
-        // Получаем все рейсы, проходящие через текущую остановку
-        auto trips = system->getTripsThroughStop(node.currentStop);
-
-        for (const auto& trip : trips) {
-            // Проверяем, что время прибытия рассчитано для текущей остановки
-            if (!trip->hasStop(node.currentStop)) {
-                continue;
-            }
+    QueryContextLease context;
+    context->beginQuery(0, index->getStopCount(), 0);
+    std::pmr::memory_resource* arena = &context->arena;
+
+    // Все созданные узлы; узлы добавляются в порядке BFS, поэтому массив служит и очередью
+    std::pmr::vector<SearchNode> nodes(arena);
+    nodes.reserve(1024);
+    std::priority_queue<FoundJourney, std::pmr::vector<FoundJourney>> best{
+        std::less<FoundJourney>{}, std::pmr::vector<FoundJourney>(arena)};
+    size_t foundCount = 0;
+
+    // Проверка, может ли путь с данным ключом (или его продолжение) попасть в top-K
+    // Новый маршрут всегда найден позже имеющихся, поэтому при равенстве ключей он хуже
+    auto canImprove = [&](const std::pair<int, int>& key) {
+        return best.size() < k || key < best.top().key;
+    };
 
-            Time arrivalAtStop = trip->getArrivalTime(node.currentStop);
+    // Начинаем поиск с начальной остановки
+    nodes.push_back({startStop, departureMinutes, -1, -1, 0});
 
+    // Раскрытие узла: добавляет в out узлы для всех остановок, куда можно доехать
+    // одним рейсом от остановки узла; allowed - проверка границы отсечения
+    auto expand = [&](const SearchNode& node, int nodeIndex, auto&& allowed, auto& out) {
+        // Перебираем все рейсы, проходящие через текущую остановку
+        for (const auto& visit : index->getStopVisits(node.stop)) {
             // Пропускаем рейсы, которые уже прошли (время прибытия раньше текущего)
-            if (arrivalAtStop < node.currentTime) {
+            if (visit.time < node.time) {
                 continue;
             }
 
             // Пропускаем, если это тот же рейс, что и предыдущий (избегаем циклов)
-            if (!node.pathTrips.empty() && node.pathTrips.back() == trip) {
+            if (node.trip >= 0 && index->getTrip(node.trip) == index->getTrip(visit.trip)) {
                 continue;
             }
 
-            // Получаем список остановок маршрута и позицию текущей остановки
-            const auto& routeStops = trip->getRoute()->getAllStops();
-            int currentPos = trip->getRoute()->getStopPosition(node.currentStop);
+            if (visit.position == -1) continue;  // Остановка не найдена в маршруте
 
-            if (currentPos == -1) continue;  // Остановка не найдена в маршруте
+            // Пересадка считается только если мы переходим на другой рейс
+            int nextTransfers = node.transfers + (node.trip >= 0 ? 1 : 0);
 
             // Проверяем все последующие остановки на этом маршруте
-            for (int i = currentPos + 1; i < routeStops.size(); ++i) {
-                std::string nextStop = routeStops[i];
-
+            auto tripStops = index->getTripStops(visit.trip);
+            auto tripTimes = index->getTripTimes(visit.trip);
+            for (size_t i = visit.position + 1; i < tripStops.size(); ++i) {
                 // Проверяем, что время прибытия рассчитано для следующей остановки
-                if (!trip->hasStop(nextStop)) {
+                if (tripTimes[i] == TimetableIndex::NO_TIME) {
+                    continue;
+                }
+
+                // Выходить имеет смысл только на конечной остановке или в пересадочном узле
+                if (tripStops[i] != endStop && !index->isInterchange(tripStops[i])) {
                     continue;
                 }
 
-                Time arrivalAtNext = trip->getArrivalTime(nextStop);
+                // Отсекаем продолжения, которые не могут обойти текущий k-й лучший маршрут
+                if (!allowed(journeyKey(nextTransfers, tripTimes[i] - departureMinutes, criterion))) {
+                    continue;
+                }
 
-                // Создаем новый узел для следующей остановки
-                SearchNode nextNode = node;
-                nextNode.currentStop = nextStop;
-                nextNode.currentTime = arrivalAtNext;
-                nextNode.pathTrips.push_back(trip);
+                out.push_back({tripStops[i], tripTimes[i], visit.trip, nodeIndex, nextTransfers});
+            }
+        }
+    };
+
+    // Контроль крайнего срока, бюджета узлов и отмены запроса
+    QueryGuard guard(queryOptions);
+    bool stopped = false;
+
+    // Обработка извлеченного из очереди узла: отсечение по границе и проверка цели
+    // Возвращает true, если узел нужно раскрыть; при срабатывании ограничений ставит stopped
+    auto visitNode = [&](size_t head) {
+        const SearchNode& node = nodes[head];
+
+        // Граница могла улучшиться с момента постановки узла в очередь
+        auto key = journeyKey(node.transfers, node.time - departureMinutes, criterion);
+        if (!canImprove(key)) {
+            return false;
+        }
 
-                // Пересадка считается только если мы переходим на другой рейс
-                if (!node.pathTrips.empty() && node.pathTrips.back() != trip) {
-                    nextNode.transferPoints.push_back(node.currentStop);
-                    nextNode.transfers++;
+        // Бюджет расходуют только узлы, прошедшие отсечение: последовательный режим ставит
+        // в очередь и узлы, которые параллельный отсекает при раскрытии, и без этого режимы
+        // прерывались бы на разных узлах
+        if (!guard.step()) {
+            stopped = true;
+            return false;
+        }
+
+        // Если достигли конечной остановки - запоминаем найденный маршрут
+        if (node.stop == endStop) {
+            best.push({key, foundCount++, static_cast<int>(head)});
+            if (best.size() > k) {
+                best.pop();
+            }
+            return false;
+        }
+
+        // Пропускаем узлы с превышением лимита пересадок и неизвестные остановки
+        return node.transfers < maxTransfers && node.stop >= 0;
+    };
+
+    if (threadCount <= 1) {
+        // При срабатывании ограничений возвращаем лучшие маршруты, найденные к этому моменту
+        for (size_t head = 0; head < nodes.size() && !stopped; ++head) {
+            if (visitNode(head)) {
+                // Копия узла: массив может перераспределиться при добавлении потомков
+                const SearchNode node = nodes[head];
+                expand(node, static_cast<int>(head), canImprove, nodes);
+            }
+        }
+    } else {
+        // Параллельный режим: поиск идет по уровням (узлы с одинаковым числом рейсов)
+        // Сначала узлы уровня последовательно проверяются в порядке очереди, как в обычном BFS,
+        // затем раскрываются параллельно: каждая часть уровня пишет потомков в свой буфер,
+        // а буферы присоединяются к очереди в порядке частей. Узлы, прошедшие отсечение,
+        // идут в том же порядке, что и в последовательном режиме, поэтому найденные маршруты,
+        // их порядок и место прерывания по бюджету узлов совпадают
+        std::vector<int> expandable;
+        std::vector<std::vector<SearchNode>> buffers;
+        size_t levelBegin = 0;
+
+        while (levelBegin < nodes.size() && !stopped) {
+            size_t levelEnd = nodes.size();
+            expandable.clear();
+            for (size_t head = levelBegin; head < levelEnd && !stopped; ++head) {
+                if (visitNode(head)) {
+                    expandable.push_back(static_cast<int>(head));
+                }
+            }
+            // Потомки узлов, раскрытых до прерывания, уже не были бы извлечены из очереди
+            if (stopped || expandable.empty()) {
+                break;
+            }
+
+            // Граница на конец проверки уровня: в последовательном режиме потомки этого уровня
+            // будут проверены по ней же (или по более строгой) при извлечении из очереди
+            bool full = best.size() >= k;
+            std::pair<int, int> bound = full ? best.top().key : std::pair<int, int>{};
+            auto allowed = [full, bound](const std::pair<int, int>& key) {
+                return !full || key < bound;
+            };
+
+            size_t chunkCount = expandable.size() < PARALLEL_MIN_LEVEL_SIZE
+                ? 1
+                : std::min(expandable.size(), threadCount * PARALLEL_CHUNKS_PER_THREAD);
+            if (buffers.size() < chunkCount) {
+                buffers.resize(chunkCount);
+            }
+
+            ThreadPool::shared().parallelFor(chunkCount, [&](size_t chunk) {
+                size_t first = expandable.size() * chunk / chunkCount;
+                size_t last = expandable.size() * (chunk + 1) / chunkCount;
+                auto& out = buffers[chunk];
+                out.clear();
+                for (size_t j = first; j < last; ++j) {
+                    expand(nodes[expandable[j]], expandable[j], allowed, out);
                 }
+            }, threadCount);
 
-                // Добавляем новый узел в очередь для дальнейшего поиска
-                q.push(nextNode);
+            for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+                nodes.insert(nodes.end(), buffers[chunk].begin(), buffers[chunk].end());
             }
+            levelBegin = levelEnd;
         }
     }
 
-    // Сортируем найденные маршруты по времени в пути (от быстрых к медленным)
-    journeys.sort([](const Journey& a, const Journey& b) {
-        return a.getTotalDuration() < b.getTotalDuration();
-    });
+    truncated = guard.isTruncated();
+
+    // Извлекаем маршруты из кучи (от худшего к лучшему)
+    std::pmr::vector<int> resultNodes(arena);
+    while (!best.empty()) {
+        resultNodes.push_back(best.top().node);
+        best.pop();
+    }
+
+    // Восстанавливаем пути по ссылкам на родителей и создаем результат от лучшего к худшему
+    std::pmr::vector<int> chain(arena);
+    for (auto it = resultNodes.rbegin(); it != resultNodes.rend(); ++it) {
+        chain.clear();
+        for (int n = *it; nodes[n].parent >= 0; n = nodes[n].parent) {
+            chain.push_back(n);
+        }
+
+        List<std::shared_ptr<Trip>> pathTrips;
+        List<std::string> transferPoints;
+        for (auto step = chain.rbegin(); step != chain.rend(); ++step) {
+            const SearchNode& legEnd = nodes[*step];
+            const SearchNode& legStart = nodes[legEnd.parent];
+            pathTrips.push_back(index->getTrip(legEnd.trip));
+            if (legStart.trip >= 0) {
+                transferPoints.push_back(index->getStopName(legStart.stop));
+            }
+        }
+        journeys.push_back(Journey(pathTrips, transferPoints, departureTime, Time(0, nodes[*it].time)));
+    }
 
     return journeys;
 }
 
 // Поиск самого быстрого маршрута
-// Использует BFS для поиска всех маршрутов, затем выбирает самый быстрый
+// Использует BFS в режиме top-1: пути медленнее уже найденного отбрасываются
 List<Journey> FastestPathAlgorithm::findPath(const std::string& start,
                                                    const std::string& end,
                                                    const Time& departureTime) {
     BFSAlgorithm bfs(system, 2);
-    auto journeys = bfs.findPath(start, end, departureTime);
+    bfs.setQueryOptions(queryOptions);
+    // Нужен только самый быстрый маршрут: top-1 с отсечением по текущему лучшему времени
+    auto journeys = bfs.findTopK(start, end, departureTime, 1, JourneyCriterion::Duration);
+    truncated = bfs.wasTruncated();
 
     if (journeys.empty()) {
         throw ContainerException("Маршрут не найден");
     }
 
-    List<Journey> result;
-    // BFS уже отсортировал маршруты по времени, берем первый (самый быстрый)
-    result.push_back(journeys[0]);
-    return result;
+    return journeys;
+}
+
+// Поиск самого быстрого маршрута с нижними оценками (A*)
+// Состояние поиска - остановка и количество использованных рейсов. Из очереди извлекается
+// состояние с наименьшей суммой "время прибытия + нижняя оценка до цели"; так как оценка
+// не превосходит реального времени оставшегося пути, первое извлеченное состояние
+// на конечной остановке дает самое раннее прибытие
+List<Journey> GoalDirectedFastestPathAlgorithm::findPath(const std::string& start,
+                                                         const std::string& end,
+                                                         const Time& departureTime) {
+    truncated = false;
+    auto index = system->getJourneyPlanner().getTimetableIndex();
+    int startStop = index->getStopIndex(start);
+    int endStop = index->getStopIndex(end);
+
+    // Нижние оценки считаются один раз для цели и переиспользуются, пока индекс не изменится
+    if (boundsIndex != index || boundsTarget != endStop) {
+        index->computeLowerBounds(endStop, lowerBounds);
+        boundsIndex = index;
+        boundsTarget = endStop;
+    }
+
+    if (startStop < 0 || endStop < 0 || lowerBounds[startStop] == TimetableIndex::UNREACHABLE) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    struct SearchNode {
+        int stop;     // Номер текущей остановки
+        int time;     // Время прибытия (минуты от начала суток)
+        int trip;     // Номер рейса последнего участка (-1 для начального узла)
+        int parent;   // Номер родительского узла (-1 для начального узла)
+        int legs;     // Количество использованных рейсов
+    };
+
+    // Элемент очереди: оценка прибытия на цель, число рейсов, узел
+    // При равной оценке раньше извлекаются пути с меньшим числом рейсов
+    struct QueueEntry {
+        int estimate;
+        int legs;
+        int node;
+
+        bool operator>(const QueueEntry& other) const {
+            if (estimate != other.estimate) {
+                return estimate > other.estimate;
+            }
+            if (legs != other.legs) {
+                return legs > other.legs;
+            }
+            return node > other.node;
+        }
+    };
+
+    int maxLegs = maxTransfers + 1;
+    size_t layers = static_cast<size_t>(maxLegs) + 1;
+    size_t stopCount = index->getStopCount();
+
+    QueryContextLease context;
+    // Метки: лучшее время прибытия на остановку для каждого количества рейсов
+    context->beginQuery(stopCount * layers, stopCount, TimetableIndex::UNREACHABLE);
+    std::pmr::memory_resource* arena = &context->arena;
+
+    std::pmr::vector<SearchNode> nodes(arena);
+    std::priority_queue<QueueEntry, std::pmr::vector<QueueEntry>, std::greater<QueueEntry>> open{
+        std::greater<QueueEntry>{}, std::pmr::vector<QueueEntry>(arena)};
+
+    int departure = departureTime.getTotalMinutes();
+    nodes.push_back({startStop, departure, -1, -1, 0});
+    context->labels.set(static_cast<size_t>(startStop) * layers, departure);
+    open.push({departure + lowerBounds[startStop], 0, 0});
+
+    // Лучшее найденное прибытие на цель и соответствующий узел
+    int bestArrival = TimetableIndex::UNREACHABLE;
+    int bestNode = -1;
+
+    // Доминирование: метка не нужна, если на остановку уже можно прибыть
+    // не позже и не большим числом рейсов
+    auto isDominated = [&](int stop, int legs, int time) {
+        for (int l = 0; l <= legs; ++l) {
+            if (context->labels.get(static_cast<size_t>(stop) * layers + l) <= time) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QueryGuard guard(queryOptions);
+    bool finished = false;
+
+    while (!open.empty()) {
+        if (!guard.step()) {
+            break;
+        }
+
+        QueueEntry entry = open.top();
+        open.pop();
+        const SearchNode node = nodes[entry.node];
+
+        // Первое извлеченное состояние на цели - оптимальное
+        if (node.stop == endStop) {
+            bestNode = entry.node;
+            finished = true;
+            break;
+        }
+
+        // Метка устарела: остановка достигнута раньше тем же или меньшим числом рейсов
+        if (context->labels.get(static_cast<size_t>(node.stop) * layers + node.legs) < node.time ||
+            node.legs >= maxLegs) {
+            continue;
+        }
+
+        for (const auto& visit : index->getStopVisits(node.stop)) {
+            // Пропускаем ушедшие рейсы и повторную посадку на тот же рейс
+            if (visit.time < node.time || visit.position == -1) {
+                continue;
+            }
+            if (node.trip >= 0 && index->getTrip(node.trip) == index->getTrip(visit.trip)) {
+                continue;
+            }
+
+            int legs = node.legs + 1;
+            auto tripStops = index->getTripStops(visit.trip);
+            auto tripTimes = index->getTripTimes(visit.trip);
+            for (size_t i = visit.position + 1; i < tripStops.size(); ++i) {
+                int arrival = tripTimes[i];
+                if (arrival == TimetableIndex::NO_TIME) {
+                    continue;
+                }
+                int next = tripStops[i];
+                // Выходить имеет смысл только на конечной остановке или в пересадочном узле
+                if (next != endStop && !index->isInterchange(next)) {
+                    continue;
+                }
+                int bound = lowerBounds[next];
+
+                // Отсечение: даже по самым быстрым перегонам не успеть раньше лучшего прибытия
+                if (bound == TimetableIndex::UNREACHABLE ||
+                    static_cast<long long>(arrival) + bound >= bestArrival) {
+                    continue;
+                }
+                if (isDominated(next, legs, arrival)) {
+                    continue;
+                }
+
+                context->labels.set(static_cast<size_t>(next) * layers + legs, arrival);
+                nodes.push_back({next, arrival, visit.trip, entry.node, legs});
+                open.push({arrival + bound, legs, static_cast<int>(nodes.size() - 1)});
+
+                if (next == endStop) {
+                    bestArrival = arrival;
+                    bestNode = static_cast<int>(nodes.size() - 1);
+                }
+            }
+        }
+    }
+
+    // При срабатывании ограничений возвращается лучший маршрут, найденный к этому моменту
+    truncated = !finished && guard.isTruncated();
+    if (bestNode == -1) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    // Восстанавливаем путь по ссылкам на родителей
+    std::pmr::vector<int> chain(arena);
+    for (int n = bestNode; nodes[n].parent >= 0; n = nodes[n].parent) {
+        chain.push_back(n);
+    }
+
+    List<std::shared_ptr<Trip>> pathTrips;
+    List<std::string> transferPoints;
+    for (auto step = chain.rbegin(); step != chain.rend(); ++step) {
+        const SearchNode& legEnd = nodes[*step];
+        const SearchNode& legStart = nodes[legEnd.parent];
+        pathTrips.push_back(index->getTrip(legEnd.trip));
+        if (legStart.trip >= 0) {
+            transferPoints.push_back(index->getStopName(legStart.stop));
+        }
+    }
+
+    List<Journey> journeys;
+    journeys.push_back(Journey(pathTrips, transferPoints, departureTime, Time(0, nodes[bestNode].time)));
+    return journeys;
+}
+
+// Восстановление пути поиска сканированием соединений от цели к началу:
+// соединение прибытия -> рейс -> соединение посадки на этот рейс
+template<typename InConnection, typename TripBoarding>
+static Journey connectionScanJourney(const TimetableIndex& index, int startStop, int endStop,
+                                    const Time& departureTime, int arrival,
+                                    InConnection inConnection, TripBoarding tripBoarding) {
+    const ConnectionTable& connections = index.getConnections();
+    auto depStops = connections.getDepStops();
+    auto tripIds = connections.getTrips();
+    std::vector<int> legTrips;
+    std::vector<int> legBoardStops;
+    for (int stop = endStop; stop != startStop;) {
+        int trip = tripIds[inConnection(stop)];
+        int boardStop = depStops[tripBoarding(trip)];
+        legTrips.push_back(trip);
+        legBoardStops.push_back(boardStop);
+        stop = boardStop;
+    }
+
+    List<std::shared_ptr<Trip>> pathTrips;
+    List<std::string> transferPoints;
+    for (size_t i = legTrips.size(); i-- > 0;) {
+        pathTrips.push_back(index.getTrip(legTrips[i]));
+        if (i + 1 < legTrips.size()) {
+            transferPoints.push_back(index.getStopName(legBoardStops[i]));
+        }
+    }
+    return Journey(pathTrips, transferPoints, departureTime, Time(0, arrival));
+}
+
+// Поиск самого раннего прибытия сканированием соединений
+// Сканирование начинается с первого соединения, отправляющегося не раньше заданного времени,
+// и заканчивается, как только соединения отправляются не раньше найденного прибытия на цель.
+// Ограничения запроса проверяются раз в блок соединений; при их срабатывании возвращается
+// прибытие на цель, найденное к этому моменту (оно может быть не самым ранним)
+List<Journey> ConnectionScanAlgorithm::findPath(const std::string& start,
+                                                const std::string& end,
+                                                const Time& departureTime) {
+    truncated = false;
+    auto index = system->getJourneyPlanner().getTimetableIndex();
+    int startStop = index->getStopIndex(start);
+    int endStop = index->getStopIndex(end);
+    if (startStop < 0 || endStop < 0 || startStop == endStop) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    const ConnectionTable& connections = index->getConnections();
+    int departure = departureTime.getTotalMinutes();
+    connections.initState(state, startStop, departure);
+    size_t first = connections.findFirst(departure);
+    QueryGuard guard(queryOptions);
+    if (vectorized) {
+        connections.scanVectorized(state, first, endStop, weekDay, &guard);
+    } else {
+        connections.scanScalar(state, first, endStop, weekDay, &guard);
+    }
+
+    truncated = guard.isTruncated();
+    if (state.inConnection[endStop] < 0) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    List<Journey> journeys;
+    journeys.push_back(connectionScanJourney(
+        *index, startStop, endStop, departureTime, state.arrival[endStop],
+        [&](int stop) { return state.inConnection[stop]; },
+        [&](int trip) { return state.tripBoarding[trip]; }));
+    return journeys;
+}
+
+// Профиль: маршруты для каждого отправления из начальной остановки в окне
+// Самое раннее прибытие меняется только в моменты отправления рейсов из начальной остановки,
+// поэтому поиск выполняется для этих моментов - пачками по PROFILE_LANES за одно сканирование.
+// Маршрут, с которым можно выехать позже и приехать не позже, вытесняет более ранний.
+// Ограничения запроса проверяются внутри сканирования и между пачками; при их срабатывании
+// возвращаются маршруты, найденные к этому моменту (более поздние отправления окна не просмотрены)
+List<Journey> ConnectionScanAlgorithm::findProfile(const std::string& start,
+                                                   const std::string& end,
+                                                   const Time& windowStart,
+                                                   const Time& windowEnd) {
+    truncated = false;
+    auto index = system->getJourneyPlanner().getTimetableIndex();
+    int startStop = index->getStopIndex(start);
+    int endStop = index->getStopIndex(end);
+    List<Journey> journeys;
+    if (startStop < 0 || endStop < 0 || startStop == endStop) {
+        return journeys;
+    }
+
+    int from = windowStart.getTotalMinutes();
+    int to = windowEnd.getTotalMinutes();
+    std::vector<int> departures;
+    for (const auto& visit : index->getStopVisits(startStop)) {
+        if (visit.time >= from && visit.time <= to &&
+            (weekDay == 0 || index->getTripWeekDay(visit.trip) == weekDay)) {
+            departures.push_back(visit.time);
+        }
+    }
+    std::sort(departures.begin(), departures.end());
+    departures.erase(std::unique(departures.begin(), departures.end()), departures.end());
+
+    const ConnectionTable& connections = index->getConnections();
+    const size_t lanes = ConnectionTable::PROFILE_LANES;
+    std::vector<int> arrivals(departures.size(), ConnectionTable::NO_LABEL);
+    std::vector<std::optional<Journey>> found(departures.size());
+    std::vector<int> batch;
+    QueryGuard guard(queryOptions);
+
+    for (size_t offset = 0; offset < departures.size() && !guard.isTruncated(); offset += lanes) {
+        batch.assign(departures.begin() + offset,
+                     departures.begin() + std::min(offset + lanes, departures.size()));
+        connections.initProfileState(profileState, startStop, batch);
+        size_t first = connections.findFirst(batch.front());
+        if (vectorized) {
+            connections.scanProfileVectorized(profileState, first, endStop, weekDay, &guard);
+        } else {
+            connections.scanProfileScalar(profileState, first, endStop, weekDay, &guard);
+        }
+
+        for (size_t lane = 0; lane < batch.size(); ++lane) {
+            size_t slot = static_cast<size_t>(endStop) * lanes + lane;
+            if (profileState.inConnection[slot] < 0) {
+                continue;
+            }
+            arrivals[offset + lane] = profileState.arrival[slot];
+            found[offset + lane] = connectionScanJourney(
+                *index, startStop, endStop, Time(0, batch[lane]), profileState.arrival[slot],
+                [&](int stop) { return profileState.inConnection[static_cast<size_t>(stop) * lanes + lane]; },
+                [&](int trip) { return profileState.tripBoarding[static_cast<size_t>(trip) * lanes + lane]; });
+        }
+    }
+    truncated = guard.isTruncated();
+
+    // Оставляем только недоминируемые маршруты (просмотр от поздних отправлений к ранним)
+    std::vector<size_t> kept;
+    int bestArrival = ConnectionTable::NO_LABEL;
+    for (size_t i = departures.size(); i-- > 0;) {
+        if (arrivals[i] < bestArrival) {
+            bestArrival = arrivals[i];
+            kept.push_back(i);
+        }
+    }
+    for (auto it = kept.rbegin(); it != kept.rend(); ++it) {
+        journeys.push_back(*found[*it]);
+    }
+    return journeys;
 }
 
 // Поиск маршрута с минимальным количеством пересадок
-// Использует BFS для поиска всех маршрутов, затем выбирает маршрут с наименьшим количеством пересадок
+// Использует BFS в режиме top-1 по критерию пересадок (при равенстве - по времени в пути)
 List<Journey> MinimalTransfersAlgorithm::findPath(const std::string& start,
                                                          const std::string& end,
                                                          const Time& departureTime) {
     BFSAlgorithm bfs(system, 2);
-    auto journeys = bfs.findPath(start, end, departureTime);
+    bfs.setQueryOptions(queryOptions);
+    auto journeys = bfs.findTopK(start, end, departureTime, 1, JourneyCriterion::Transfers);
+    truncated = bfs.wasTruncated();
 
     if (journeys.empty()) {
         throw ContainerException("Маршрут не найден");
     }
 
-    // Находим маршрут с минимальным количеством пересадок
-    auto it = std::min_element(journeys.begin(), journeys.end(),
-                               [](const Journey& a, const Journey& b) {
-                                   return a.getTransferCount() < b.getTransferCount();
-                               });
-
-    List<Journey> result;
-    result.push_back(*it);
-    return result;
+    return journeys;
 }
 
 // Расчет времени прибытия на остановки для рейса
@@ -5,14 +5,23 @@
 #include <memory>
 #include <type_traits>
 #include <iterator>
+#include <vector>
 #include "list.h"
 #include "journey.h"
 #include "time.h"
 #include "route.h"
 #include "trip.h"
+#include "query_options.h"
+#include "timetable_index.h"
 
 class TransportSystem;
 
+// Критерий упорядочивания найденных маршрутов
+enum class JourneyCriterion {
+    Duration,   // По времени в пути
+    Transfers   // По количеству пересадок, затем по времени в пути
+};
+
 // Базовый интерфейс для алгоритмов (для полиморфизма)
 class IAlgorithm {
 public:
@@ -160,14 +169,36 @@ public:
 };
 
 // Класс алгоритма поиска пути (Strategy pattern)
+// Каждый алгоритм обязан соблюдать ограничения queryOptions (крайний срок, бюджет узлов,
+// отмена) и при их срабатывании возвращать лучшие найденные маршруты, выставляя флаг truncated
 class PathFindingAlgorithm : public BaseAlgorithm {
+protected:
+    QueryOptions queryOptions;  // Ограничения выполнения запроса
+    bool truncated = false;     // Был ли прерван последний поиск
+
 public:
     explicit PathFindingAlgorithm(TransportSystem* sys) : BaseAlgorithm(sys) {}
 
+    // Установить ограничения для последующих запросов
+    void setQueryOptions(const QueryOptions& options) { queryOptions = options; }
+    const QueryOptions& getQueryOptions() const { return queryOptions; }
+
+    // Был ли последний поиск прерван по ограничениям запроса
+    bool wasTruncated() const { return truncated; }
+
     virtual List<Journey> findPath(const std::string& start,
                                          const std::string& end,
                                          const Time& departureTime) = 0;
 
+    // Поиск не более k лучших маршрутов по заданному критерию (top-K)
+    // Базовая реализация сортирует все маршруты, найденные findPath;
+    // наследники могут переопределить метод и отсекать заведомо худшие пути
+    virtual List<Journey> findTopK(const std::string& start,
+                                   const std::string& end,
+                                   const Time& departureTime,
+                                   size_t k,
+                                   JourneyCriterion criterion = JourneyCriterion::Duration);
+
     void execute() override {}
     
     std::string getDescription() const override {
@@ -179,15 +210,35 @@ public:
 class BFSAlgorithm : public PathFindingAlgorithm {
 private:
     int maxTransfers;
+    size_t threadCount = 1;   // Количество потоков для раскрытия уровней (1 - последовательный поиск)
+
+    // Уровни меньше этого размера раскрываются одним потоком
+    static const size_t PARALLEL_MIN_LEVEL_SIZE = 64;
+    // Частей уровня на поток (для выравнивания нагрузки)
+    static const size_t PARALLEL_CHUNKS_PER_THREAD = 4;
 
 public:
     BFSAlgorithm(TransportSystem* sys, int maxTransfers = 2)
         : PathFindingAlgorithm(sys), maxTransfers(maxTransfers) {}
 
+    // Установить количество потоков поиска (0 - все ядра)
+    // При нескольких потоках уровни BFS раскрываются параллельно на общем пуле потоков,
+    // результат совпадает с последовательным поиском
+    void setThreadCount(size_t threads);
+    size_t getThreadCount() const { return threadCount; }
+
     List<Journey> findPath(const std::string& start,
                                  const std::string& end,
                                  const Time& departureTime) override;
 
+    // Поиск k лучших маршрутов с ограниченной кучей и отсечением по границе:
+    // частичные пути, которые не могут обойти текущий k-й лучший маршрут, отбрасываются
+    List<Journey> findTopK(const std::string& start,
+                           const std::string& end,
+                           const Time& departureTime,
+                           size_t k,
+                           JourneyCriterion criterion = JourneyCriterion::Duration) override;
+
     void execute() override {
         // Реализация может быть добавлена при необходимости
     }
@@ -213,6 +264,76 @@ public:
     }
 };
 
+// Алгоритм поиска самого быстрого маршрута, направленный к цели (A*)
+// Метки упорядочиваются по сумме времени прибытия и нижней оценки времени до цели,
+// а метки, которые даже с этой оценкой не успевают раньше лучшего найденного прибытия,
+// отбрасываются. Поэтому поиск не расходится по всей сети в направлениях от цели
+class GoalDirectedFastestPathAlgorithm : public PathFindingAlgorithm {
+private:
+    int maxTransfers;
+
+    // Нижние оценки для последней цели (пересчитываются при смене цели или индекса)
+    std::shared_ptr<const TimetableIndex> boundsIndex;
+    int boundsTarget = -1;
+    std::vector<int> lowerBounds;
+
+public:
+    GoalDirectedFastestPathAlgorithm(TransportSystem* sys, int maxTransfers = 2)
+        : PathFindingAlgorithm(sys), maxTransfers(maxTransfers) {}
+
+    List<Journey> findPath(const std::string& start,
+                                 const std::string& end,
+                                 const Time& departureTime) override;
+
+    void execute() override {}
+
+    std::string getDescription() const override {
+        return "Алгоритм поиска самого быстрого маршрута с нижними оценками (A*)";
+    }
+};
+
+// Поиск маршрута с самым ранним прибытием сканированием соединений (CSA)
+// Соединения всех рейсов просматриваются один раз в порядке отправления; число пересадок
+// не ограничивается. Профильный поиск обрабатывает несколько времен отправления за одно
+// сканирование. Векторные варианты сканирования можно отключить, чтобы сравнить
+// результат с эталонным скалярным
+class ConnectionScanAlgorithm : public PathFindingAlgorithm {
+private:
+    bool vectorized;
+    int weekDay = 0;
+    ConnectionScanState state;
+    ConnectionProfileState profileState;
+
+public:
+    ConnectionScanAlgorithm(TransportSystem* sys, bool vectorized = true)
+        : PathFindingAlgorithm(sys), vectorized(vectorized) {}
+
+    void setVectorized(bool enabled) { vectorized = enabled; }
+    bool isVectorized() const { return vectorized; }
+
+    // День недели рейсов (0 - все дни)
+    void setWeekDay(int day) { weekDay = day; }
+    int getWeekDay() const { return weekDay; }
+
+    List<Journey> findPath(const std::string& start,
+                                 const std::string& end,
+                                 const Time& departureTime) override;
+
+    // Профиль за окно отправлений [windowStart, windowEnd]: для каждого момента отправления
+    // из start - маршрут с самым ранним прибытием; маршруты, с которыми можно выехать позже
+    // и приехать не позже, вытесняют более ранние. Маршруты упорядочены по отправлению
+    List<Journey> findProfile(const std::string& start,
+                              const std::string& end,
+                              const Time& windowStart,
+                              const Time& windowEnd);
+
+    void execute() override {}
+
+    std::string getDescription() const override {
+        return "Алгоритм поиска самого раннего прибытия сканированием соединений";
+    }
+};
+
 // Алгоритм поиска маршрута с минимальными пересадками
 class MinimalTransfersAlgorithm : public PathFindingAlgorithm {
 public:
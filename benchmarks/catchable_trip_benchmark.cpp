@@ -0,0 +1,70 @@
+// Замер поиска первого рейса, на который можно успеть
+// Сравнивает скалярный линейный, векторный линейный и двоичный поиск в столбце времен
+// шаблона разной длины и показывает, с какой длины двоичный поиск становится выгоднее
+// (по этим замерам выбран RoutePatterns::LINEAR_SEARCH_MAX_SIZE)
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <span>
+#include <vector>
+#include "../route_patterns.h"
+
+namespace {
+
+// Среднее время одного поиска в наносекундах
+template<typename Search>
+double measure(const std::vector<int16_t>& column, const std::vector<int>& queries, Search search) {
+    const int repeats = 200;
+    size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; ++r) {
+        for (int time : queries) {
+            checksum += search(std::span<const int16_t>(column), time);
+        }
+    }
+    auto finish = std::chrono::steady_clock::now();
+    // Контрольная сумма не дает компилятору выбросить поиск
+    if (checksum == static_cast<size_t>(-1)) {
+        std::cout << "";
+    }
+    double total = std::chrono::duration<double, std::nano>(finish - start).count();
+    return total / (static_cast<double>(repeats) * queries.size());
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> minute(0, 24 * 60 - 1);
+
+    std::vector<int> queries(4096);
+    for (auto& query : queries) {
+        query = minute(random);
+    }
+
+    std::cout << std::setw(8) << "trips"
+              << std::setw(14) << "scalar, ns"
+              << std::setw(14) << "simd, ns"
+              << std::setw(14) << "binary, ns" << "\n";
+
+    for (size_t size : {4, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256, 512}) {
+        // Рейсы равномерно распределены по суткам
+        std::vector<int16_t> column(size);
+        for (size_t i = 0; i < size; ++i) {
+            column[i] = static_cast<int16_t>(i * (24 * 60) / size);
+        }
+
+        double scalar = measure(column, queries, RoutePatterns::findFirstTripScalar);
+        double simd = measure(column, queries, RoutePatterns::findFirstTripLinear);
+        double binary = measure(column, queries, RoutePatterns::findFirstTripBinary);
+
+        std::cout << std::setw(8) << size << std::fixed << std::setprecision(2)
+                  << std::setw(14) << scalar
+                  << std::setw(14) << simd
+                  << std::setw(14) << binary << "\n";
+    }
+
+    return 0;
+}
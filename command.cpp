@@ -1,4 +1,11 @@
 #include "command.h"
+#include "command_journal.h"
+
+// Подключает журнал изменений: каждая выполненная, отмененная и повторенная команда
+// дописывается в него после изменения системы
+void CommandHistory::setJournal(CommandJournal* commandJournal) {
+    journal = commandJournal;
+}
 
 // Выполняет команду и добавляет её в историю
 // При выполнении новой команды удаляются все команды после текущей позиции
@@ -12,6 +19,9 @@ void CommandHistory::executeCommand(std::unique_ptr<Command> cmd) {
     
     // Выполняем команду и добавляем в историю
     cmd->execute();
+    if (journal) {
+        journal->append(JournalAction::Execute, cmd->getRecord());
+    }
     history.push_back(std::move(cmd));
     currentIndex = history.size();
 
@@ -34,6 +44,9 @@ void CommandHistory::undo() {
     }
     currentIndex--;
     history[currentIndex]->undo();  // Вызываем метод undo команды
+    if (journal) {
+        journal->append(JournalAction::Undo, history[currentIndex]->getRecord());
+    }
 }
 
 // Проверяет, можно ли повторить отмененное действие
@@ -47,6 +60,9 @@ void CommandHistory::redo() {
         throw ContainerException("Нет действий для повтора");
     }
     history[currentIndex]->execute();  // Выполняем команду снова
+    if (journal) {
+        journal->append(JournalAction::Redo, history[currentIndex]->getRecord());
+    }
     currentIndex++;
 }
 
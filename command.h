@@ -7,6 +7,32 @@
 #include "exceptions.h"
 
 class TransportSystem;
+class CommandJournal;
+
+// Вид изменения, которое команда вносит в систему (запись журнала изменений)
+// Добавление и удаление одного вида объектов - пары, отмена команды записывается
+// как та же запись с действием Undo и воспроизводится обратной операцией
+enum class CommandKind : char {
+    None = 0,            // Команда не записывается в журнал
+    AddStop = 'S',
+    RemoveStop = 's',
+    AddVehicle = 'V',
+    RemoveVehicle = 'v',
+    AddDriver = 'D',
+    RemoveDriver = 'd',
+    AddRoute = 'R',
+    RemoveRoute = 'r',
+    AddTrip = 'T',
+    RemoveTrip = 't',
+    UpdateTrip = 'U',    // Новое расписание рейса (пересчет времени прибытия)
+    AddAdmin = 'A'
+};
+
+// Запись команды: вид изменения и объект в текстовом формате файлов данных
+struct CommandRecord {
+    CommandKind kind = CommandKind::None;
+    std::string payload;
+};
 
 // Базовый класс для команд (реализует паттерн Command)
 // Позволяет инкапсулировать запросы как объекты, что дает возможность
@@ -23,6 +49,9 @@ public:
 
     // Получить описание команды
     virtual std::string getDescription() const = 0;
+
+    // Запись для журнала изменений; вызывается после execute (объекты удаления уже известны)
+    virtual CommandRecord getRecord() const { return {}; }
 };
 
 // Класс для управления историей команд
@@ -33,8 +62,12 @@ private:
     List<std::unique_ptr<Command>> history;  // История команд
     size_t currentIndex = 0;                  // Текущая позиция в истории
     static const size_t MAX_HISTORY_SIZE = 100;  // Максимальный размер истории
+    CommandJournal* journal = nullptr;        // Журнал выполненных, отмененных и повторенных команд
 
 public:
+    // Записывать команды в журнал (nullptr - не записывать)
+    void setJournal(CommandJournal* commandJournal);
+
     // Выполнить команду и добавить в историю
     void executeCommand(std::unique_ptr<Command> cmd);
 
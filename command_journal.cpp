@@ -0,0 +1,461 @@
+#include "command_journal.h"
+#include "transport_system.h"
+#include "data_manager.h"
+#include "snapshot.h"
+#include "record_parser.h"
+#include "exceptions.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char JOURNAL_MAGIC[] = "TSJ 1 ";
+
+// Низкоуровневые операции с файлом журнала: fsync недоступен через std::ofstream
+static int openJournalFile(const std::string& path, bool truncate) {
+#ifdef _WIN32
+    return _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND),
+                 _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND), 0644);
+#endif
+}
+
+static bool writeJournalFile(int descriptor, const char* data, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        int written = _write(descriptor, data, static_cast<unsigned int>(size));
+#else
+        ssize_t written = ::write(descriptor, data, size);
+#endif
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+static bool syncJournalFile(int descriptor) {
+#ifdef _WIN32
+    return _commit(descriptor) == 0;
+#else
+    return ::fsync(descriptor) == 0;
+#endif
+}
+
+static void closeJournalFile(int descriptor) {
+#ifdef _WIN32
+    _close(descriptor);
+#else
+    ::close(descriptor);
+#endif
+}
+
+static std::string toHex(uint64_t value) {
+    char buffer[16];
+    for (int i = 15; i >= 0; --i) {
+        buffer[i] = "0123456789abcdef"[value & 0xF];
+        value >>= 4;
+    }
+    return std::string(buffer, sizeof(buffer));
+}
+
+static bool fromHex(std::string_view text, uint64_t& value) {
+    auto [ptr, error] = std::from_chars(text.data(), text.data() + text.size(), value, 16);
+    return error == std::errc() && ptr == text.data() + text.size();
+}
+
+CommandJournal::~CommandJournal() {
+    try {
+        sync();
+    } catch (...) {
+        // Деструктор не выбрасывает исключений; несохраненная пачка теряется, как при сбое
+    }
+    closeFile();
+}
+
+void CommandJournal::closeFile() {
+    if (descriptor >= 0) {
+        closeJournalFile(descriptor);
+        descriptor = -1;
+    }
+}
+
+void CommandJournal::open(const std::string& path, uint64_t snapshotChecksum, const ReplayResult& replay) {
+    std::lock_guard<std::mutex> lock(mutex);
+    closeFile();
+    filePath = path;
+    pending.clear();
+    pendingRecords = 0;
+    if (!replay.replayed) {
+        recordCount = 0;
+        rewrite(snapshotChecksum, "");
+        return;
+    }
+    // Оборванная запись в конце отбрасывается, чтобы новые записи шли сразу за целыми
+    if (replay.truncated) {
+        std::error_code error;
+        std::filesystem::resize_file(path, replay.validSize, error);
+        if (error) {
+            throw FileException(path, "обрезка поврежденного журнала");
+        }
+    }
+    descriptor = openJournalFile(path, false);
+    if (descriptor < 0) {
+        throw FileException(path, "открытие для записи");
+    }
+    recordCount = replay.recordCount;
+    fileSize = replay.validSize;
+}
+
+bool CommandJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return descriptor >= 0;
+}
+
+void CommandJournal::appendBody(const std::string& body) {
+    pending += toHex(SnapshotView::checksum(body.data(), body.size()));
+    pending += ' ';
+    pending += body;
+    pending += '\n';
+    pendingRecords++;
+    recordCount++;
+    if (pendingRecords >= SYNC_BATCH) {
+        syncLocked();
+    }
+}
+
+void CommandJournal::append(JournalAction action, const CommandRecord& record) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (descriptor < 0 || record.kind == CommandKind::None) {
+        return;
+    }
+    std::string body;
+    body.reserve(record.payload.size() + 3);
+    body += static_cast<char>(action);
+    body += static_cast<char>(record.kind);
+    body += ' ';
+    body += record.payload;
+    appendBody(body);
+}
+
+void CommandJournal::syncLocked() {
+    if (descriptor < 0 || pending.empty()) {
+        return;
+    }
+    if (!writeJournalFile(descriptor, pending.data(), pending.size()) || !syncJournalFile(descriptor)) {
+        throw FileException(filePath, "запись журнала");
+    }
+    fileSize += pending.size();
+    pending.clear();
+    pendingRecords = 0;
+}
+
+void CommandJournal::sync() {
+    std::lock_guard<std::mutex> lock(mutex);
+    syncLocked();
+}
+
+// Новый журнал пишется рядом и заменяет старый переименованием
+void CommandJournal::rewrite(uint64_t snapshotChecksum, const std::string& records) {
+    closeFile();
+    pending.clear();
+    pendingRecords = 0;
+
+    std::string content = JOURNAL_MAGIC + toHex(snapshotChecksum) + "\n" + records;
+    std::string tempPath = filePath + ".tmp";
+    int tempDescriptor = openJournalFile(tempPath, true);
+    if (tempDescriptor < 0) {
+        throw FileException(tempPath, "открытие для записи");
+    }
+    bool written = writeJournalFile(tempDescriptor, content.data(), content.size()) && syncJournalFile(tempDescriptor);
+    closeJournalFile(tempDescriptor);
+    std::error_code error;
+    if (!written) {
+        std::filesystem::remove(tempPath, error);
+        throw FileException(tempPath, "запись");
+    }
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        throw FileException(filePath, "замена журнала");
+    }
+
+    descriptor = openJournalFile(filePath, false);
+    if (descriptor < 0) {
+        throw FileException(filePath, "открытие для записи");
+    }
+    fileSize = content.size();
+}
+
+void CommandJournal::reset(uint64_t snapshotChecksum) {
+    std::lock_guard<std::mutex> lock(mutex);
+    recordCount = 0;
+    rewrite(snapshotChecksum, "");
+}
+
+CommandJournal::Checkpoint CommandJournal::checkpoint() {
+    std::lock_guard<std::mutex> lock(mutex);
+    Checkpoint result;
+    if (descriptor < 0) {
+        return result;
+    }
+    // Номер отметки - время в наносекундах: номера не повторяются и между запусками
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    uint64_t token = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count());
+    lastToken = std::max(token, lastToken + 1);
+
+    std::string body;
+    body += static_cast<char>(JournalAction::Checkpoint);
+    body += "- ";
+    body += toHex(lastToken);
+    appendBody(body);
+    syncLocked();
+
+    result.token = lastToken;
+    result.offset = fileSize;
+    result.recordCount = recordCount;
+    return result;
+}
+
+void CommandJournal::compact(uint64_t snapshotChecksum, const Checkpoint& checkpoint) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (descriptor < 0 || checkpoint.token == 0) {
+        return;
+    }
+    syncLocked();
+
+    // Записи после отметки (дописанные во время сохранения) переносятся в новый журнал
+    std::string records;
+    {
+        std::ifstream in(filePath, std::ios::binary);
+        if (!in.is_open() || !in.seekg(static_cast<std::streamoff>(checkpoint.offset))) {
+            throw FileException(filePath, "чтение журнала");
+        }
+        records.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+    size_t remaining = recordCount - checkpoint.recordCount;
+    rewrite(snapshotChecksum, records);
+    recordCount = remaining;
+}
+
+bool CommandJournal::needsCompaction() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recordCount >= COMPACTION_RECORDS || fileSize + pending.size() >= COMPACTION_BYTES;
+}
+
+size_t CommandJournal::getRecordCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recordCount;
+}
+
+bool CommandJournal::hasPendingRecords() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !pending.empty();
+}
+
+CommandJournal::ReplayResult CommandJournal::replay(TransportSystem& system, const std::string& path,
+                                                    uint64_t snapshotChecksum, uint64_t snapshotCheckpoint) {
+    ReplayResult result;
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        return result;
+    }
+    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    size_t headerEnd = content.find('\n');
+    std::string_view header = std::string_view(content).substr(0, headerEnd);
+    uint64_t journalSnapshot = 0;
+    if (headerEnd == std::string::npos || header.substr(0, sizeof(JOURNAL_MAGIC) - 1) != JOURNAL_MAGIC ||
+        !fromHex(header.substr(sizeof(JOURNAL_MAGIC) - 1), journalSnapshot)) {
+        std::cout << "[DEBUG] Журнал изменений поврежден и не воспроизводится" << std::endl;
+        return result;
+    }
+
+    // Проверенные записи (тела строк) до первой оборванной или поврежденной
+    std::vector<std::string_view> bodies;
+    result.validSize = headerEnd + 1;
+    for (size_t position = headerEnd + 1; position < content.size();) {
+        size_t lineEnd = content.find('\n', position);
+        if (lineEnd == std::string::npos) {
+            result.truncated = true;
+            break;
+        }
+        std::string_view line = std::string_view(content).substr(position, lineEnd - position);
+        uint64_t checksum = 0;
+        std::string_view body = line.size() > 19 ? line.substr(17) : std::string_view();
+        if (body.empty() || line[16] != ' ' || !fromHex(line.substr(0, 16), checksum) ||
+            checksum != SnapshotView::checksum(body.data(), body.size()) || body[2] != ' ') {
+            result.truncated = true;
+            break;
+        }
+        position = lineEnd + 1;
+        result.validSize = position;
+        bodies.push_back(body);
+    }
+    result.recordCount = bodies.size();
+
+    // Снимок, записанный после начала журнала, уже содержит записи до своей отметки
+    // (сбой между записью снимка и сжатием журнала)
+    size_t first = 0;
+    if (snapshotChecksum != 0 && journalSnapshot != snapshotChecksum) {
+        auto isSnapshotCheckpoint = [snapshotCheckpoint](std::string_view body) {
+            uint64_t token = 0;
+            return body[0] == static_cast<char>(JournalAction::Checkpoint) && fromHex(body.substr(3), token) &&
+                   snapshotCheckpoint != 0 && token == snapshotCheckpoint;
+        };
+        auto it = std::find_if(bodies.begin(), bodies.end(), isSnapshotCheckpoint);
+        if (it == bodies.end()) {
+            std::cout << "[DEBUG] Журнал изменений относится к предыдущему снимку, пропускаем" << std::endl;
+            return ReplayResult();
+        }
+        first = static_cast<size_t>(it - bodies.begin()) + 1;
+        result.skipped = first;
+    }
+
+    result.replayed = true;
+    for (size_t i = first; i < bodies.size(); ++i) {
+        std::string_view body = bodies[i];
+        if (body[0] == static_cast<char>(JournalAction::Checkpoint)) {
+            continue;
+        }
+        CommandRecord record{static_cast<CommandKind>(body[1]), std::string(body.substr(3))};
+        try {
+            if (apply(system, static_cast<JournalAction>(body[0]), record)) {
+                result.applied++;
+            }
+        } catch (const std::exception& e) {
+            result.failed++;
+            std::cout << "[DEBUG] Запись журнала " << i + 1 << " не применена: " << e.what() << std::endl;
+        }
+    }
+    return result;
+}
+
+bool CommandJournal::apply(TransportSystem& system, JournalAction action, const CommandRecord& record) {
+    const std::string& payload = record.payload;
+    FieldSplitter fields(payload, '|');
+    // Отмена команды добавления удаляет объект и наоборот
+    bool forward = action != JournalAction::Undo;
+
+    switch (record.kind) {
+        case CommandKind::AddStop:
+        case CommandKind::RemoveStop: {
+            Stop stop = Stop::deserialize(payload);
+            if ((record.kind == CommandKind::AddStop) == forward) {
+                if (system.hasStop(stop.getId())) {
+                    return false;
+                }
+                system.addStopDirect(stop);
+            } else {
+                if (!system.hasStop(stop.getId())) {
+                    return false;
+                }
+                system.removeStopDirect(stop.getId());
+            }
+            return true;
+        }
+        case CommandKind::AddVehicle:
+        case CommandKind::RemoveVehicle: {
+            if ((record.kind == CommandKind::AddVehicle) == forward) {
+                auto vehicle = DataManager::parseVehicle(payload);
+                if (system.findVehicleByLicensePlate(vehicle->getLicensePlate())) {
+                    return false;
+                }
+                system.addVehicleDirect(vehicle);
+            } else {
+                fields.next();
+                fields.next();
+                std::string licensePlate(RecordParser::trim(fields.next()));
+                if (!system.findVehicleByLicensePlate(licensePlate)) {
+                    return false;
+                }
+                system.removeVehicleDirect(licensePlate);
+            }
+            return true;
+        }
+        case CommandKind::AddDriver:
+        case CommandKind::RemoveDriver: {
+            auto driver = Driver::deserialize(payload);
+            bool exists = system.hasDriver(driver->getFirstName(), driver->getLastName(), driver->getMiddleName());
+            if ((record.kind == CommandKind::AddDriver) == forward) {
+                if (exists) {
+                    return false;
+                }
+                system.addDriverDirect(driver);
+            } else {
+                if (!exists) {
+                    return false;
+                }
+                system.removeDriverDirect(driver);
+            }
+            return true;
+        }
+        case CommandKind::AddRoute:
+        case CommandKind::RemoveRoute: {
+            if ((record.kind == CommandKind::AddRoute) == forward) {
+                auto route = Route::deserialize(payload);
+                if (system.findRouteByNumber(route->getNumber())) {
+                    return false;
+                }
+                system.addRouteDirect(route);
+            } else {
+                int routeNumber = RecordParser::parseInt(fields.next());
+                if (!system.findRouteByNumber(routeNumber)) {
+                    return false;
+                }
+                system.removeRouteDirect(routeNumber);
+            }
+            return true;
+        }
+        case CommandKind::AddTrip:
+        case CommandKind::RemoveTrip: {
+            int tripId = RecordParser::parseInt(fields.next());
+            if ((record.kind == CommandKind::AddTrip) == forward) {
+                if (system.getTripById(tripId)) {
+                    return false;
+                }
+                system.addTripDirect(Trip::deserialize(payload, &system));
+            } else {
+                if (!system.getTripById(tripId)) {
+                    return false;
+                }
+                system.removeTripDirect(tripId);
+            }
+            return true;
+        }
+        case CommandKind::UpdateTrip: {
+            int tripId = RecordParser::parseInt(fields.next());
+            if (!system.getTripById(tripId)) {
+                return false;
+            }
+            auto updated = Trip::deserialize(payload, &system);
+            system.updateTripScheduleDirect(tripId, updated->getSchedule());
+            return true;
+        }
+        case CommandKind::AddAdmin: {
+            std::string username(fields.next());
+            std::string password(fields.remainder());
+            system.addAdmin(username, password);
+            return true;
+        }
+        default:
+            throw InputException("Неизвестный вид записи журнала");
+    }
+}
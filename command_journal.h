@@ -0,0 +1,132 @@
+#ifndef COMMAND_JOURNAL_H
+#define COMMAND_JOURNAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "command.h"
+
+class TransportSystem;
+
+// Действие с командой, записанное в журнал
+enum class JournalAction : char {
+    Execute = 'E',
+    Undo = 'U',
+    Redo = 'R',
+    Checkpoint = 'C'    // Отметка начала сохранения (не команда)
+};
+
+// Журнал изменений (файл journal.log): дописываемый список команд после последнего
+// полного сохранения. Сохранение становится дописыванием нескольких строк вместо
+// перезаписи всех файлов, а после сбоя изменения восстанавливаются воспроизведением
+// журнала поверх снимка.
+//
+// Формат: строка заголовка "TSJ 1 <контрольная сумма снимка>", затем по строке на запись
+// "<контрольная сумма записи> <действие><вид> <объект>", где объект - строка в формате
+// текстовых файлов данных. Записи копятся в памяти и пишутся с fsync пачками по
+// SYNC_BATCH записей и при каждом сохранении; при сбое теряется не больше одной пачки.
+// Когда журнал вырастает, следующее сохранение сжимает его: измененные файлы данных
+// записываются заново вместе со снимком, и журнал начинается с заголовком нового снимка.
+// Набор MappedDataset журнал не читает - изменения видны в нем после сжатия
+//
+// Сохранение может идти в фоне, пока команды продолжают дописываться. Поэтому в начале
+// сохранения в журнал пишется отметка "C- <номер отметки>", тот же номер записывается
+// в снимок, а после записи снимка из журнала убираются только записи до отметки. Если сбой
+// случился между записью снимка и сжатием журнала, при загрузке воспроизводятся записи
+// после отметки снимка. Методы журнала можно вызывать из разных потоков
+class CommandJournal {
+public:
+    // Итог воспроизведения журнала
+    struct ReplayResult {
+        bool replayed = false;       // Журнал относится к загруженным данным и воспроизведен
+        size_t recordCount = 0;      // Прочитано целых записей
+        size_t applied = 0;          // Записей, изменивших систему
+        size_t failed = 0;           // Записей, которые не удалось применить
+        size_t validSize = 0;        // Размер проверенной части файла
+        bool truncated = false;      // В конце файла оборванная или поврежденная запись
+        size_t skipped = 0;          // Записей до отметки снимка (уже вошли в снимок)
+    };
+
+    // Отметка начала сохранения: номер и положение в журнале
+    struct Checkpoint {
+        uint64_t token = 0;          // Номер отметки (0 - журнал не открыт)
+        size_t offset = 0;           // Конец строки отметки в файле
+        size_t recordCount = 0;      // Записей в журнале до отметки включительно
+    };
+
+private:
+    static const size_t SYNC_BATCH = 16;               // Записей между fsync
+    static const size_t COMPACTION_RECORDS = 1000;     // Записей до сжатия
+    static const size_t COMPACTION_BYTES = 4 << 20;    // Или байтов до сжатия
+
+    std::string filePath;
+    int descriptor = -1;
+    std::string pending;            // Записи, еще не переданные в файл
+    size_t pendingRecords = 0;
+    size_t recordCount = 0;         // Записей в журнале после последнего сжатия
+    size_t fileSize = 0;
+    uint64_t lastToken = 0;         // Номер последней отметки сохранения
+    mutable std::mutex mutex;
+
+    void closeFile();
+
+    // Операции без захвата mutex (вызываются из открытых методов под ним)
+    void appendBody(const std::string& body);
+    void syncLocked();
+    void rewrite(uint64_t snapshotChecksum, const std::string& records);
+
+public:
+    CommandJournal() = default;
+    ~CommandJournal();
+
+    CommandJournal(const CommandJournal&) = delete;
+    CommandJournal& operator=(const CommandJournal&) = delete;
+
+    // Открыть журнал для дописывания после воспроизведения
+    // Если журнал не был воспроизведен (его нет, он поврежден или относится к другому
+    // снимку), он начинается заново; иначе дописывается после проверенной части.
+    // Выбрасывает FileException, если файл не открывается
+    void open(const std::string& path, uint64_t snapshotChecksum, const ReplayResult& replay);
+
+    bool isOpen() const;
+
+    // Дописать запись команды; без открытого журнала и для CommandKind::None ничего не делает
+    void append(JournalAction action, const CommandRecord& record);
+
+    // Записать накопленные записи в файл и дождаться их записи на диск (fsync)
+    void sync();
+
+    // Начать журнал заново для нового снимка (после полного сохранения)
+    void reset(uint64_t snapshotChecksum);
+
+    // Записать отметку начала сохранения и сбросить журнал на диск
+    // Без открытого журнала возвращает отметку с номером 0
+    Checkpoint checkpoint();
+
+    // Сжать журнал после записи снимка, снятого на отметке checkpoint: записи до отметки
+    // удаляются, записи после нее остаются под заголовком нового снимка
+    void compact(uint64_t snapshotChecksum, const Checkpoint& checkpoint);
+
+    // Журнал вырос настолько, что его пора сжать полным сохранением
+    bool needsCompaction() const;
+
+    size_t getRecordCount() const;
+
+    // Есть записи, еще не сброшенные на диск
+    bool hasPendingRecords() const;
+
+    // Воспроизвести журнал path поверх загруженных данных
+    // Если существующий снимок записан позже начала журнала (snapshotChecksum не совпадает
+    // с заголовком), записи до отметки снимка snapshotCheckpoint уже вошли в снимок и
+    // пропускаются; журнал без такой отметки пропускается целиком. Воспроизведение
+    // останавливается на первой оборванной или поврежденной записи
+    static ReplayResult replay(TransportSystem& system, const std::string& path, uint64_t snapshotChecksum,
+                               uint64_t snapshotCheckpoint);
+
+    // Применить одну запись к системе (действие Undo - обратной операцией)
+    // Возвращает false, если запись ничего не изменила (объект уже есть или его нет)
+    static bool apply(TransportSystem& system, JournalAction action, const CommandRecord& record);
+};
+
+#endif // COMMAND_JOURNAL_H
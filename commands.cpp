@@ -16,6 +16,10 @@ std::string AddRouteCommand::getDescription() const {
     return "Добавление маршрута " + std::to_string(route->getNumber());
 }
 
+CommandRecord AddRouteCommand::getRecord() const {
+    return {CommandKind::AddRoute, route->serialize()};
+}
+
 RemoveRouteCommand::RemoveRouteCommand(TransportSystem* sys, int num)
     : system(sys), routeNumber(num), route(nullptr) {}
 
@@ -34,6 +38,10 @@ std::string RemoveRouteCommand::getDescription() const {
     return "Удаление маршрута " + std::to_string(routeNumber);
 }
 
+CommandRecord RemoveRouteCommand::getRecord() const {
+    return {CommandKind::RemoveRoute, route ? route->serialize() : std::to_string(routeNumber)};
+}
+
 AddTripCommand::AddTripCommand(TransportSystem* sys, std::shared_ptr<Trip> t)
     : system(sys), trip(t) {}
 
@@ -49,6 +57,10 @@ std::string AddTripCommand::getDescription() const {
     return "Добавление рейса " + std::to_string(trip->getTripId());
 }
 
+CommandRecord AddTripCommand::getRecord() const {
+    return {CommandKind::AddTrip, trip->serialize()};
+}
+
 RemoveTripCommand::RemoveTripCommand(TransportSystem* sys, int id)
     : system(sys), tripId(id), trip(nullptr) {}
 
@@ -67,6 +79,10 @@ std::string RemoveTripCommand::getDescription() const {
     return "Удаление рейса " + std::to_string(tripId);
 }
 
+CommandRecord RemoveTripCommand::getRecord() const {
+    return {CommandKind::RemoveTrip, trip ? trip->serialize() : std::to_string(tripId)};
+}
+
 AddVehicleCommand::AddVehicleCommand(TransportSystem* sys, std::shared_ptr<Vehicle> v)
     : system(sys), vehicle(v) {}
 
@@ -82,6 +98,10 @@ std::string AddVehicleCommand::getDescription() const {
     return "Добавление транспорта " + vehicle->getLicensePlate();
 }
 
+CommandRecord AddVehicleCommand::getRecord() const {
+    return {CommandKind::AddVehicle, vehicle->serialize()};
+}
+
 RemoveVehicleCommand::RemoveVehicleCommand(TransportSystem* sys, const std::string& lp)
     : system(sys), licensePlate(lp), vehicle(nullptr) {}
 
@@ -100,6 +120,10 @@ std::string RemoveVehicleCommand::getDescription() const {
     return "Удаление транспорта " + licensePlate;
 }
 
+CommandRecord RemoveVehicleCommand::getRecord() const {
+    return {CommandKind::RemoveVehicle, vehicle ? vehicle->serialize() : "||" + licensePlate};
+}
+
 AddStopCommand::AddStopCommand(TransportSystem* sys, const Stop& s)
     : system(sys), stop(s) {}
 
@@ -115,6 +139,10 @@ std::string AddStopCommand::getDescription() const {
     return "Добавление остановки " + stop.getName();
 }
 
+CommandRecord AddStopCommand::getRecord() const {
+    return {CommandKind::AddStop, stop.serialize()};
+}
+
 RemoveStopCommand::RemoveStopCommand(TransportSystem* sys, int id)
     : system(sys), stopId(id), stop(0, "") {}
 
@@ -131,6 +159,10 @@ std::string RemoveStopCommand::getDescription() const {
     return "Удаление остановки ID " + std::to_string(stopId);
 }
 
+CommandRecord RemoveStopCommand::getRecord() const {
+    return {CommandKind::RemoveStop, stop.serialize()};
+}
+
 AddDriverCommand::AddDriverCommand(TransportSystem* sys, std::shared_ptr<Driver> d)
     : system(sys), driver(d) {}
 
@@ -146,6 +178,10 @@ std::string AddDriverCommand::getDescription() const {
     return "Добавление водителя " + driver->getFullName();
 }
 
+CommandRecord AddDriverCommand::getRecord() const {
+    return {CommandKind::AddDriver, driver->serialize()};
+}
+
 RemoveDriverCommand::RemoveDriverCommand(TransportSystem* sys, std::shared_ptr<Driver> d)
     : system(sys), driver(d),
       firstName(d->getFirstName()),
@@ -164,3 +200,7 @@ std::string RemoveDriverCommand::getDescription() const {
     return "Удаление водителя " + driver->getFullName();
 }
 
+CommandRecord RemoveDriverCommand::getRecord() const {
+    return {CommandKind::RemoveDriver, driver->serialize()};
+}
+
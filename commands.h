@@ -20,6 +20,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class RemoveRouteCommand : public Command {
@@ -33,6 +34,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class AddTripCommand : public Command {
@@ -45,6 +47,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class RemoveTripCommand : public Command {
@@ -58,6 +61,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class AddVehicleCommand : public Command {
@@ -70,6 +74,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class RemoveVehicleCommand : public Command {
@@ -83,6 +88,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class AddStopCommand : public Command {
@@ -95,6 +101,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class RemoveStopCommand : public Command {
@@ -108,6 +115,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class AddDriverCommand : public Command {
@@ -120,6 +128,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 class RemoveDriverCommand : public Command {
@@ -133,6 +142,7 @@ public:
     void execute() override;
     void undo() override;
     std::string getDescription() const override;
+    CommandRecord getRecord() const override;
 };
 
 #endif // COMMANDS_H
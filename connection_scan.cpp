@@ -0,0 +1,484 @@
+#include "connection_scan.h"
+#include "timetable_index.h"
+#include "query_options.h"
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define CONNECTION_SCAN_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONNECTION_SCAN_SSE2 1
+#endif
+
+// Соединения строятся по соседним остановкам расписания каждого рейса (остановки маршрута
+// без времени пропускаются) и сортируются по отправлению, при равном - по прибытию.
+// Соединения, прибывающие раньше отправления (переход через полночь), не включаются:
+// сканирование по времени отправления их не поддерживает
+void ConnectionTable::build(const TimetableIndex& index) {
+    std::vector<int> rawDepTimes;
+    std::vector<int> rawArrTimes;
+    std::vector<int> rawDepStops;
+    std::vector<int> rawArrStops;
+    std::vector<int> rawTrips;
+
+    for (size_t t = 0; t < index.getTripCount(); ++t) {
+        auto tripStops = index.getTripStops(static_cast<int>(t));
+        auto times = index.getTripTimes(static_cast<int>(t));
+        int previous = -1;
+        for (size_t i = 0; i < tripStops.size(); ++i) {
+            if (times[i] == TimetableIndex::NO_TIME) {
+                continue;
+            }
+            if (previous != -1 && times[i] >= times[previous]) {
+                rawDepTimes.push_back(times[previous]);
+                rawArrTimes.push_back(times[i]);
+                rawDepStops.push_back(tripStops[previous]);
+                rawArrStops.push_back(tripStops[i]);
+                rawTrips.push_back(static_cast<int>(t));
+            }
+            previous = static_cast<int>(i);
+        }
+    }
+
+    // Устойчивая сортировка сохраняет порядок соединений одного рейса с равными временами
+    std::vector<size_t> order(rawTrips.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        if (rawDepTimes[a] != rawDepTimes[b]) {
+            return rawDepTimes[a] < rawDepTimes[b];
+        }
+        return rawArrTimes[a] < rawArrTimes[b];
+    });
+
+    ownDepTimes.resize(order.size());
+    ownArrTimes.resize(order.size());
+    ownDepStops.resize(order.size());
+    ownArrStops.resize(order.size());
+    ownTrips.resize(order.size());
+    ownWeekDays.resize(order.size());
+    for (size_t c = 0; c < order.size(); ++c) {
+        ownDepTimes[c] = rawDepTimes[order[c]];
+        ownArrTimes[c] = rawArrTimes[order[c]];
+        ownDepStops[c] = rawDepStops[order[c]];
+        ownArrStops[c] = rawArrStops[order[c]];
+        ownTrips[c] = rawTrips[order[c]];
+        ownWeekDays[c] = index.getTripWeekDay(ownTrips[c]);
+    }
+
+    ownInterchangeFlags.resize(index.getStopCount());
+    for (size_t s = 0; s < index.getStopCount(); ++s) {
+        ownInterchangeFlags[s] = index.isInterchange(static_cast<int>(s)) ? 1 : 0;
+    }
+
+    Arrays arrays;
+    arrays.depTimes = ownDepTimes;
+    arrays.arrTimes = ownArrTimes;
+    arrays.depStops = ownDepStops;
+    arrays.arrStops = ownArrStops;
+    arrays.trips = ownTrips;
+    arrays.weekDays = ownWeekDays;
+    arrays.interchangeFlags = ownInterchangeFlags;
+    arrays.tripCount = index.getTripCount();
+    attach(arrays);
+}
+
+void ConnectionTable::attach(const Arrays& arrays) {
+    depTimes = arrays.depTimes;
+    arrTimes = arrays.arrTimes;
+    depStops = arrays.depStops;
+    arrStops = arrays.arrStops;
+    trips = arrays.trips;
+    weekDays = arrays.weekDays;
+    interchangeFlags = arrays.interchangeFlags;
+    tripCount = arrays.tripCount;
+}
+
+ConnectionTable::Arrays ConnectionTable::getArrays() const {
+    return {depTimes, arrTimes, depStops, arrStops, trips, weekDays, interchangeFlags, tripCount};
+}
+
+size_t ConnectionTable::size() const {
+    return depTimes.size();
+}
+
+std::span<const int> ConnectionTable::getDepTimes() const {
+    return depTimes;
+}
+
+std::span<const int> ConnectionTable::getArrTimes() const {
+    return arrTimes;
+}
+
+std::span<const int> ConnectionTable::getDepStops() const {
+    return depStops;
+}
+
+std::span<const int> ConnectionTable::getArrStops() const {
+    return arrStops;
+}
+
+std::span<const int> ConnectionTable::getTrips() const {
+    return trips;
+}
+
+size_t ConnectionTable::findFirst(int time) const {
+    return std::lower_bound(depTimes.begin(), depTimes.end(), time) - depTimes.begin();
+}
+
+void ConnectionTable::initState(ConnectionScanState& state, int origin, int departure) const {
+    state.arrival.assign(interchangeFlags.size(), NO_LABEL);
+    state.boardTime.assign(interchangeFlags.size(), NO_LABEL);
+    state.inConnection.assign(interchangeFlags.size(), -1);
+    state.tripBoarding.assign(tripCount, -1);
+    state.arrival[origin] = departure;
+    state.boardTime[origin] = departure;
+}
+
+// Сесть на рейс можно, если на него уже сели раньше или если на остановку отправления
+// успели к отправлению; пересесть на другой рейс можно только в пересадочном узле
+void ConnectionTable::relax(size_t connection, ConnectionScanState& state, int weekDay) const {
+    if (weekDay != 0 && weekDays[connection] != weekDay) {
+        return;
+    }
+    int trip = trips[connection];
+    if (state.tripBoarding[trip] < 0) {
+        if (state.boardTime[depStops[connection]] > depTimes[connection]) {
+            return;
+        }
+        state.tripBoarding[trip] = static_cast<int>(connection);
+    }
+    int stop = arrStops[connection];
+    if (arrTimes[connection] < state.arrival[stop]) {
+        state.arrival[stop] = arrTimes[connection];
+        state.inConnection[stop] = static_cast<int>(connection);
+        if (interchangeFlags[stop]) {
+            state.boardTime[stop] = arrTimes[connection];
+        }
+    }
+}
+
+void ConnectionTable::scanScalar(ConnectionScanState& state, size_t first, int target, int weekDay,
+                                 QueryGuard* guard) const {
+    size_t blockEnd = first;
+    for (size_t c = first; c < depTimes.size(); ++c) {
+        if (target >= 0 && depTimes[c] >= state.arrival[target]) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        relax(c, state, weekDay);
+    }
+}
+
+// Метки только улучшаются, поэтому соединение, достижимое по меткам на начало блока,
+// останется достижимым. Блок, в котором по меткам на его начало не достижимо ни одно
+// соединение, пропускается: до первого достижимого соединения метки не меняются.
+// Начиная с первого достижимого соединения блок обрабатывается скалярно, так как
+// соединения блока могут зависеть друг от друга
+void ConnectionTable::scanVectorized(ConnectionScanState& state, size_t first, int target, int weekDay,
+                                     QueryGuard* guard) const {
+#if defined(CONNECTION_SCAN_AVX2)
+    size_t size = depTimes.size();
+    size_t c = first;
+    size_t blockEnd = first;
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+
+    for (; c + 8 <= size; c += 8) {
+        // Соединения упорядочены по отправлению: проверка первого соединения блока
+        if (target >= 0 && depTimes[c] >= state.arrival[target]) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        __m256i dep = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depTimes.data() + c));
+        __m256i stops = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(depStops.data() + c));
+        __m256i tripIds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(trips.data() + c));
+        __m256i board = _mm256_i32gather_epi32(state.boardTime.data(), stops, 4);
+        __m256i boarded = _mm256_i32gather_epi32(state.tripBoarding.data(), tripIds, 4);
+        // Достижимо: boardTime <= dep или на рейс уже сели
+        __m256i late = _mm256_cmpgt_epi32(board, dep);
+        __m256i onTrip = _mm256_cmpgt_epi32(boarded, allOnes);
+        __m256i reachable = _mm256_or_si256(_mm256_andnot_si256(late, allOnes), onTrip);
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(reachable)));
+        if (mask == 0) {
+            continue;
+        }
+        for (size_t lane = std::countr_zero(mask); lane < 8; ++lane) {
+            if (target >= 0 && depTimes[c + lane] >= state.arrival[target]) {
+                return;
+            }
+            relax(c + lane, state, weekDay);
+        }
+    }
+    // Остаток короче векторного блока (меньше 8 соединений) досматривается без проверок
+    scanScalar(state, c, target, weekDay);
+#elif defined(CONNECTION_SCAN_SSE2)
+    size_t size = depTimes.size();
+    size_t c = first;
+    size_t blockEnd = first;
+    const __m128i allOnes = _mm_set1_epi32(-1);
+
+    for (; c + 4 <= size; c += 4) {
+        if (target >= 0 && depTimes[c] >= state.arrival[target]) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        __m128i dep = _mm_loadu_si128(reinterpret_cast<const __m128i*>(depTimes.data() + c));
+        // В SSE2 нет выборки по индексам: метки четырех соединений собираются поэлементно,
+        // а сравнение и проверка всего блока выполняются векторно
+        __m128i board = _mm_setr_epi32(state.boardTime[depStops[c]], state.boardTime[depStops[c + 1]],
+                                       state.boardTime[depStops[c + 2]], state.boardTime[depStops[c + 3]]);
+        __m128i boarded = _mm_setr_epi32(state.tripBoarding[trips[c]], state.tripBoarding[trips[c + 1]],
+                                         state.tripBoarding[trips[c + 2]], state.tripBoarding[trips[c + 3]]);
+        __m128i late = _mm_cmpgt_epi32(board, dep);
+        __m128i onTrip = _mm_cmpgt_epi32(boarded, allOnes);
+        __m128i reachable = _mm_or_si128(_mm_andnot_si128(late, allOnes), onTrip);
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(reachable)));
+        if (mask == 0) {
+            continue;
+        }
+        for (size_t lane = std::countr_zero(mask); lane < 4; ++lane) {
+            if (target >= 0 && depTimes[c + lane] >= state.arrival[target]) {
+                return;
+            }
+            relax(c + lane, state, weekDay);
+        }
+    }
+    // Остаток короче векторного блока (меньше 4 соединений) досматривается без проверок
+    scanScalar(state, c, target, weekDay);
+#else
+    scanScalar(state, first, target, weekDay, guard);
+#endif
+}
+
+void ConnectionTable::initProfileState(ConnectionProfileState& state, int origin,
+                                       const std::vector<int>& departures) const {
+    state.laneCount = std::min(departures.size(), PROFILE_LANES);
+    state.departures.assign(PROFILE_LANES, NO_LABEL);
+    std::copy_n(departures.begin(), state.laneCount, state.departures.begin());
+    state.arrival.assign(interchangeFlags.size() * PROFILE_LANES, NO_LABEL);
+    state.boardTime.assign(interchangeFlags.size() * PROFILE_LANES, NO_LABEL);
+    state.inConnection.assign(interchangeFlags.size() * PROFILE_LANES, -1);
+    state.tripBoarding.assign(tripCount * PROFILE_LANES, -1);
+    for (size_t lane = 0; lane < state.laneCount; ++lane) {
+        state.arrival[origin * PROFILE_LANES + lane] = state.departures[lane];
+        state.boardTime[origin * PROFILE_LANES + lane] = state.departures[lane];
+    }
+}
+
+// То же, что relax, для каждой полосы
+void ConnectionTable::relaxProfile(size_t connection, ConnectionProfileState& state) const {
+    int* boarding = &state.tripBoarding[static_cast<size_t>(trips[connection]) * PROFILE_LANES];
+    const int* board = &state.boardTime[static_cast<size_t>(depStops[connection]) * PROFILE_LANES];
+    size_t stop = static_cast<size_t>(arrStops[connection]);
+    for (size_t lane = 0; lane < PROFILE_LANES; ++lane) {
+        if (boarding[lane] < 0) {
+            if (board[lane] > depTimes[connection]) {
+                continue;
+            }
+            boarding[lane] = static_cast<int>(connection);
+        }
+        if (arrTimes[connection] < state.arrival[stop * PROFILE_LANES + lane]) {
+            state.arrival[stop * PROFILE_LANES + lane] = arrTimes[connection];
+            state.inConnection[stop * PROFILE_LANES + lane] = static_cast<int>(connection);
+            if (interchangeFlags[stop]) {
+                state.boardTime[stop * PROFILE_LANES + lane] = arrTimes[connection];
+            }
+        }
+    }
+}
+
+int ConnectionTable::latestArrival(const ConnectionProfileState& state, int target) {
+    const int* arrival = &state.arrival[static_cast<size_t>(target) * PROFILE_LANES];
+    return *std::max_element(arrival, arrival + state.laneCount);
+}
+
+void ConnectionTable::scanProfileScalar(ConnectionProfileState& state, size_t first, int target, int weekDay,
+                                        QueryGuard* guard) const {
+    if (state.laneCount == 0) {
+        return;
+    }
+    int limit = target >= 0 ? latestArrival(state, target) : NO_LABEL;
+    size_t blockEnd = first;
+    for (size_t c = first; c < depTimes.size(); ++c) {
+        if (depTimes[c] >= limit) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        if (weekDay != 0 && weekDays[c] != weekDay) {
+            continue;
+        }
+        relaxProfile(c, state);
+        if (arrStops[c] == target) {
+            limit = latestArrival(state, target);
+        }
+    }
+}
+
+// На каждое соединение - одна проверка посадки и один поэлементный минимум для всех полос.
+// Соединения, на которые не садится ни одна полоса, отбрасываются после первой проверки
+void ConnectionTable::scanProfileVectorized(ConnectionProfileState& state, size_t first, int target,
+                                            int weekDay, QueryGuard* guard) const {
+#if defined(CONNECTION_SCAN_AVX2)
+    static_assert(PROFILE_LANES == 8, "Полосы профильного поиска должны занимать один регистр AVX2");
+    if (state.laneCount == 0) {
+        return;
+    }
+    const __m256i allOnes = _mm256_set1_epi32(-1);
+    int limit = target >= 0 ? latestArrival(state, target) : NO_LABEL;
+    size_t blockEnd = first;
+
+    for (size_t c = first; c < depTimes.size(); ++c) {
+        if (depTimes[c] >= limit) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        if (weekDay != 0 && weekDays[c] != weekDay) {
+            continue;
+        }
+        auto* boardingSlot = reinterpret_cast<__m256i*>(
+            &state.tripBoarding[static_cast<size_t>(trips[c]) * PROFILE_LANES]);
+        __m256i boarding = _mm256_loadu_si256(boardingSlot);
+        __m256i board = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+            &state.boardTime[static_cast<size_t>(depStops[c]) * PROFILE_LANES]));
+        __m256i dep = _mm256_set1_epi32(depTimes[c]);
+
+        // Полосы, уже едущие этим рейсом, и полосы, успевающие на него сейчас
+        __m256i onTrip = _mm256_cmpgt_epi32(boarding, allOnes);
+        __m256i canBoard = _mm256_andnot_si256(_mm256_cmpgt_epi32(board, dep), allOnes);
+        __m256i active = _mm256_or_si256(onTrip, canBoard);
+        if (_mm256_testz_si256(active, active)) {
+            continue;
+        }
+        __m256i connection = _mm256_set1_epi32(static_cast<int>(c));
+        _mm256_storeu_si256(boardingSlot, _mm256_blendv_epi8(boarding, connection,
+                                                             _mm256_andnot_si256(onTrip, canBoard)));
+
+        size_t stop = static_cast<size_t>(arrStops[c]);
+        auto* arrivalSlot = reinterpret_cast<__m256i*>(&state.arrival[stop * PROFILE_LANES]);
+        __m256i arrival = _mm256_loadu_si256(arrivalSlot);
+        __m256i arr = _mm256_set1_epi32(arrTimes[c]);
+        __m256i improved = _mm256_and_si256(active, _mm256_cmpgt_epi32(arrival, arr));
+        if (_mm256_testz_si256(improved, improved)) {
+            continue;
+        }
+        // Поэлементный минимум по улучшенным полосам
+        _mm256_storeu_si256(arrivalSlot, _mm256_blendv_epi8(arrival, arr, improved));
+        auto* inSlot = reinterpret_cast<__m256i*>(&state.inConnection[stop * PROFILE_LANES]);
+        _mm256_storeu_si256(inSlot, _mm256_blendv_epi8(_mm256_loadu_si256(inSlot), connection, improved));
+        if (interchangeFlags[stop]) {
+            auto* boardSlot = reinterpret_cast<__m256i*>(&state.boardTime[stop * PROFILE_LANES]);
+            _mm256_storeu_si256(boardSlot, _mm256_blendv_epi8(_mm256_loadu_si256(boardSlot), arr, improved));
+        }
+        if (static_cast<int>(stop) == target) {
+            limit = latestArrival(state, target);
+        }
+    }
+#elif defined(CONNECTION_SCAN_SSE2)
+    // 8 полос занимают два регистра SSE2; выбор по маске вместо blendv (его нет в SSE2)
+    static_assert(PROFILE_LANES == 8, "Полосы профильного поиска должны занимать два регистра SSE2");
+    if (state.laneCount == 0) {
+        return;
+    }
+    const __m128i allOnes = _mm_set1_epi32(-1);
+    auto select = [](__m128i mask, __m128i ifSet, __m128i ifClear) {
+        return _mm_or_si128(_mm_and_si128(mask, ifSet), _mm_andnot_si128(mask, ifClear));
+    };
+    int limit = target >= 0 ? latestArrival(state, target) : NO_LABEL;
+    size_t blockEnd = first;
+
+    for (size_t c = first; c < depTimes.size(); ++c) {
+        if (depTimes[c] >= limit) {
+            return;
+        }
+        if (guard && c == blockEnd) {
+            if (!guard->step(GUARD_BLOCK)) {
+                return;
+            }
+            blockEnd += GUARD_BLOCK;
+        }
+        if (weekDay != 0 && weekDays[c] != weekDay) {
+            continue;
+        }
+        auto* boardingSlot = reinterpret_cast<__m128i*>(
+            &state.tripBoarding[static_cast<size_t>(trips[c]) * PROFILE_LANES]);
+        auto* boardFrom = reinterpret_cast<const __m128i*>(
+            &state.boardTime[static_cast<size_t>(depStops[c]) * PROFILE_LANES]);
+        __m128i dep = _mm_set1_epi32(depTimes[c]);
+
+        // Полосы, уже едущие этим рейсом, и полосы, успевающие на него сейчас
+        __m128i boarding[2], onTrip[2], canBoard[2], active[2];
+        int anyActive = 0;
+        for (int half = 0; half < 2; ++half) {
+            boarding[half] = _mm_loadu_si128(boardingSlot + half);
+            onTrip[half] = _mm_cmpgt_epi32(boarding[half], allOnes);
+            canBoard[half] = _mm_andnot_si128(_mm_cmpgt_epi32(_mm_loadu_si128(boardFrom + half), dep), allOnes);
+            active[half] = _mm_or_si128(onTrip[half], canBoard[half]);
+            anyActive |= _mm_movemask_epi8(active[half]);
+        }
+        if (anyActive == 0) {
+            continue;
+        }
+        __m128i connection = _mm_set1_epi32(static_cast<int>(c));
+        for (int half = 0; half < 2; ++half) {
+            _mm_storeu_si128(boardingSlot + half,
+                             select(_mm_andnot_si128(onTrip[half], canBoard[half]), connection, boarding[half]));
+        }
+
+        size_t stop = static_cast<size_t>(arrStops[c]);
+        auto* arrivalSlot = reinterpret_cast<__m128i*>(&state.arrival[stop * PROFILE_LANES]);
+        __m128i arr = _mm_set1_epi32(arrTimes[c]);
+        __m128i arrival[2], improved[2];
+        int anyImproved = 0;
+        for (int half = 0; half < 2; ++half) {
+            arrival[half] = _mm_loadu_si128(arrivalSlot + half);
+            improved[half] = _mm_and_si128(active[half], _mm_cmpgt_epi32(arrival[half], arr));
+            anyImproved |= _mm_movemask_epi8(improved[half]);
+        }
+        if (anyImproved == 0) {
+            continue;
+        }
+        // Поэлементный минимум по улучшенным полосам
+        auto* inSlot = reinterpret_cast<__m128i*>(&state.inConnection[stop * PROFILE_LANES]);
+        auto* boardSlot = reinterpret_cast<__m128i*>(&state.boardTime[stop * PROFILE_LANES]);
+        for (int half = 0; half < 2; ++half) {
+            _mm_storeu_si128(arrivalSlot + half, select(improved[half], arr, arrival[half]));
+            _mm_storeu_si128(inSlot + half, select(improved[half], connection, _mm_loadu_si128(inSlot + half)));
+            if (interchangeFlags[stop]) {
+                _mm_storeu_si128(boardSlot + half, select(improved[half], arr, _mm_loadu_si128(boardSlot + half)));
+            }
+        }
+        if (static_cast<int>(stop) == target) {
+            limit = latestArrival(state, target);
+        }
+    }
+#else
+    scanProfileScalar(state, first, target, weekDay, guard);
+#endif
+}
@@ -0,0 +1,151 @@
+#ifndef CONNECTION_SCAN_H
+#define CONNECTION_SCAN_H
+
+#include <limits>
+#include <span>
+#include <vector>
+
+class TimetableIndex;
+class QueryGuard;
+
+// Метки одного поиска сканированием соединений
+struct ConnectionScanState {
+    std::vector<int> arrival;        // Самое раннее прибытие на остановку
+    std::vector<int> boardTime;      // С какого времени с остановки можно сесть на другой рейс
+    std::vector<int> tripBoarding;   // Соединение, на котором сели на рейс (-1 - рейс недоступен)
+    std::vector<int> inConnection;   // Соединение, которым прибыли на остановку (-1 - нет)
+};
+
+// Метки поиска сразу для нескольких времен отправления (профильный поиск)
+// Метки остановок и рейсов хранятся по PROFILE_LANES значений подряд - по одному на каждое
+// время отправления, поэтому метки всех отправлений обновляются одной векторной операцией
+struct ConnectionProfileState {
+    size_t laneCount = 0;            // Сколько отправлений пачки используется
+    std::vector<int> departures;     // Время отправления каждой полосы
+    std::vector<int> arrival;        // [остановка * PROFILE_LANES + полоса]
+    std::vector<int> boardTime;      // [остановка * PROFILE_LANES + полоса]
+    std::vector<int> tripBoarding;   // [рейс * PROFILE_LANES + полоса]
+    std::vector<int> inConnection;   // [остановка * PROFILE_LANES + полоса]
+};
+
+// Таблица соединений для поиска сканированием соединений (CSA)
+// Соединение - проезд рейса между двумя соседними остановками его расписания.
+// Соединения хранятся "структурой массивов" в порядке времени отправления: при сканировании
+// каждый массив читается последовательно, а векторное ядро загружает поля нескольких
+// соединений одной инструкцией
+// Таблица может владеть массивами (build) или читать их из внешней памяти, например
+// из отображенного в память снимка (attach); сканирование работает одинаково
+class ConnectionTable {
+public:
+    // Массивы таблицы
+    struct Arrays {
+        std::span<const int> depTimes;   // Время отправления
+        std::span<const int> arrTimes;   // Время прибытия
+        std::span<const int> depStops;   // Остановка отправления
+        std::span<const int> arrStops;   // Остановка прибытия
+        std::span<const int> trips;      // Рейс (номер в индексе)
+        std::span<const int> weekDays;   // День недели рейса
+        // Пересадочные узлы (копия флагов индекса, чтобы сканирование не обращалось к индексу)
+        std::span<const unsigned char> interchangeFlags;
+        size_t tripCount = 0;
+    };
+
+private:
+    std::span<const int> depTimes;
+    std::span<const int> arrTimes;
+    std::span<const int> depStops;
+    std::span<const int> arrStops;
+    std::span<const int> trips;
+    std::span<const int> weekDays;
+    std::span<const unsigned char> interchangeFlags;
+    size_t tripCount = 0;
+
+    // Собственные массивы, заполняемые build
+    std::vector<int> ownDepTimes;
+    std::vector<int> ownArrTimes;
+    std::vector<int> ownDepStops;
+    std::vector<int> ownArrStops;
+    std::vector<int> ownTrips;
+    std::vector<int> ownWeekDays;
+    std::vector<unsigned char> ownInterchangeFlags;
+
+    // Обработка одного соединения (общая для обоих вариантов сканирования)
+    void relax(size_t connection, ConnectionScanState& state, int weekDay) const;
+
+    // Обработка одного соединения для всех полос профильного поиска
+    void relaxProfile(size_t connection, ConnectionProfileState& state) const;
+
+    // Позднейшее из прибытий на target по используемым полосам
+    static int latestArrival(const ConnectionProfileState& state, int target);
+
+public:
+    // Нет прибытия / посадки
+    static constexpr int NO_LABEL = std::numeric_limits<int>::max();
+
+    // Количество времен отправления, обрабатываемых одним профильным сканированием
+    static const size_t PROFILE_LANES = 8;
+
+    // Количество соединений между проверками ограничений запроса (кратно ширине векторного блока)
+    static const size_t GUARD_BLOCK = 256;
+
+    ConnectionTable() = default;
+    // Копия ссылалась бы на массивы оригинала
+    ConnectionTable(const ConnectionTable&) = delete;
+    ConnectionTable& operator=(const ConnectionTable&) = delete;
+
+    // Построить таблицу по индексу сети
+    void build(const TimetableIndex& index);
+
+    // Использовать готовые массивы без копирования; память должна жить дольше таблицы
+    // Массивы соединений должны быть одной длины и упорядочены, как после build
+    void attach(const Arrays& arrays);
+
+    // Текущие массивы таблицы (например, для записи в снимок)
+    Arrays getArrays() const;
+
+    size_t size() const;
+
+    std::span<const int> getDepTimes() const;
+    std::span<const int> getArrTimes() const;
+    std::span<const int> getDepStops() const;
+    std::span<const int> getArrStops() const;
+    std::span<const int> getTrips() const;
+
+    // Первое соединение с отправлением не раньше time
+    size_t findFirst(int time) const;
+
+    // Подготовить метки к поиску из origin с отправлением в departure
+    void initState(ConnectionScanState& state, int origin, int departure) const;
+
+    // Сканирование соединений начиная с first (эталонная скалярная реализация)
+    // target >= 0 - сканирование прекращается на первом соединении, отправляющемся не раньше
+    // найденного прибытия на target; weekDay = 0 - рейсы любого дня недели
+    // guard - ограничения запроса: проверяются раз в GUARD_BLOCK соединений, при срабатывании
+    // сканирование прекращается (guard->isTruncated() == true), метки остаются промежуточными
+    void scanScalar(ConnectionScanState& state, size_t first, int target, int weekDay,
+                    QueryGuard* guard = nullptr) const;
+
+    // Векторное сканирование: достижимость блока соединений проверяется одной инструкцией
+    // (AVX2 - 8 соединений, SSE2 - 4), блоки без достижимых соединений пропускаются целиком.
+    // Результат совпадает со scanScalar; без SSE2 и AVX2 вызывается scanScalar
+    void scanVectorized(ConnectionScanState& state, size_t first, int target, int weekDay,
+                        QueryGuard* guard = nullptr) const;
+
+    // Подготовить метки профильного поиска из origin для отправлений departures
+    // (не больше PROFILE_LANES; незанятые полосы ни на что не садятся)
+    void initProfileState(ConnectionProfileState& state, int origin, const std::vector<int>& departures) const;
+
+    // Профильное сканирование для всех отправлений пачки (эталонная скалярная реализация)
+    // Сканирование прекращается, когда все полосы уже прибыли на target раньше отправления,
+    // или при срабатывании ограничений запроса guard (проверяются раз в GUARD_BLOCK соединений)
+    void scanProfileScalar(ConnectionProfileState& state, size_t first, int target, int weekDay,
+                           QueryGuard* guard = nullptr) const;
+
+    // Профильное сканирование с метками полос в векторных регистрах (AVX2: 8 полос в одном,
+    // SSE2: по 4 полосы в двух), обновляемыми поэлементным минимумом.
+    // Без SSE2 и AVX2 вызывается scanProfileScalar
+    void scanProfileVectorized(ConnectionProfileState& state, size_t first, int target, int weekDay,
+                               QueryGuard* guard = nullptr) const;
+};
+
+#endif // CONNECTION_SCAN_H
@@ -9,11 +9,17 @@
 #include "route.h"
 #include "trip.h"
 #include "exceptions.h"
+#include "snapshot.h"
+#include "mapped_dataset.h"
+#include "thread_pool.h"
+#include "record_parser.h"
 #include <fstream>
-#include <sstream>
 #include <iostream>
 #include <algorithm>
+#include <bit>
 #include <cctype>
+#include <unordered_set>
+#include <vector>
 
 DataManager::DataManager(const std::string& dir) {
     // Нормализуем путь к папке data
@@ -53,61 +59,281 @@ DataManager::DataManager(const std::string& dir) {
     std::cout << "[DEBUG] Текущая рабочая директория: " << std::filesystem::current_path().string() << std::endl;
 }
 
-void DataManager::saveAllData(TransportSystem& system) {
-    std::cout << "Сохранение данных в файлы...\n";
+DataManager::~DataManager() {
+    waitForSave();
+}
 
-    bool hasErrors = false;
+DataManager::SaveTask::SaveTask(TransportSystem& system, unsigned files, const CommandJournal::Checkpoint& checkpoint)
+    : state(system), files(files), checkpoint(checkpoint) {}
 
-    try {
-        saveStops(system);
-    } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении остановок: " << e.what() << "\n";
-        hasErrors = true;
+bool DataManager::SaveTask::has(DataFile file) const {
+    return (files & (1u << static_cast<unsigned>(file))) != 0;
+}
+
+CommandJournal& DataManager::getJournal() {
+    return journal;
+}
+
+void DataManager::markUnjournaled() {
+    unjournaledChanges = true;
+}
+
+// Готовый результат сохранения, которое не понадобилось запускать в фоне
+static std::shared_future<SaveResult> completedSave(SaveResult result,
+                                                    const std::function<void(const SaveResult&)>& onComplete) {
+    if (onComplete) {
+        onComplete(result);
     }
+    std::promise<SaveResult> promise;
+    promise.set_value(std::move(result));
+    return promise.get_future().share();
+}
 
-    try {
-        saveVehicles(system);
-    } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении транспорта: " << e.what() << "\n";
-        hasErrors = true;
+// Дождаться сохранения и напечатать его сообщения
+static bool printSaveResult(const std::shared_future<SaveResult>& save) {
+    const SaveResult& result = save.get();
+    std::cout << result.messages << std::flush;
+    return result.success;
+}
+
+bool DataManager::saveChanges(TransportSystem& system) {
+    return printSaveResult(saveChangesAsync(system));
+}
+
+// Обычное сохранение только дописывает журнал: все изменения, сделанные командами,
+// уже в нем. Измененные файлы переписываются при изменениях в обход команд, без журнала
+// и для сжатия выросшего журнала
+std::shared_future<SaveResult> DataManager::saveChangesAsync(TransportSystem& system,
+                                                             std::function<void(const SaveResult&)> onComplete) {
+    std::string journalError;
+    if (!unjournaledChanges && journal.isOpen() && !journal.needsCompaction()) {
+        try {
+            journal.sync();
+            SaveResult result;
+            result.success = true;
+            result.messages = "Изменения сохранены в журнал (записей после полного сохранения: " +
+                              std::to_string(journal.getRecordCount()) + ")\n";
+            return completedSave(std::move(result), onComplete);
+        } catch (const std::exception& e) {
+            journalError = std::string("[ERROR] Ошибка при записи журнала: ") + e.what() + "\n";
+        }
     }
+    return startSave(system, std::move(journalError), std::move(onComplete));
+}
 
-    try {
-        saveDrivers(system);
-    } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении водителей: " << e.what() << "\n";
-        hasErrors = true;
+bool DataManager::saveAllData(TransportSystem& system) {
+    return printSaveResult(saveAllDataAsync(system));
+}
+
+bool DataManager::isSaving() const {
+    return pendingSave.valid() && pendingSave.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void DataManager::waitForSave() {
+    if (pendingSave.valid()) {
+        pendingSave.wait();
     }
+}
 
-    try {
-        saveRoutes(system);
-    } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении маршрутов: " << e.what() << "\n";
-        hasErrors = true;
+bool DataManager::hasUnsavedChanges() const {
+    // Изменения команд сохранены, как только их записи сброшены на диск в журнале
+    if (!unjournaledChanges && journal.isOpen()) {
+        return journal.hasPendingRecords();
+    }
+    return dirtyFiles != 0;
+}
+
+void DataManager::markDirty(DataFile file) {
+    if (file == DataFile::Count) {
+        return;
+    }
+    dirtyFiles |= (1u << static_cast<unsigned>(file)) | (1u << static_cast<unsigned>(DataFile::Snapshot));
+}
+
+bool DataManager::isDirty(DataFile file) const {
+    return file != DataFile::Count && (dirtyFiles & (1u << static_cast<unsigned>(file))) != 0;
+}
+
+DataFile DataManager::getVehicleFile(const std::string& vehicleType) {
+    if (vehicleType == "Автобус") return DataFile::Buses;
+    if (vehicleType == "Троллейбус") return DataFile::Trolleybuses;
+    if (vehicleType == "Трамвай") return DataFile::Trams;
+    return DataFile::Count;
+}
+
+DataFile DataManager::getTripFile(const std::string& vehicleType) {
+    if (vehicleType == "Автобус") return DataFile::BusTrips;
+    if (vehicleType == "Троллейбус") return DataFile::TrolleybusTrips;
+    if (vehicleType == "Трамвай") return DataFile::TramTrips;
+    return DataFile::Count;
+}
+
+const char* DataManager::getFileName(DataFile file) {
+    switch (file) {
+        case DataFile::Stops: return "stops.txt";
+        case DataFile::Buses: return "bus.txt";
+        case DataFile::Trolleybuses: return "trolleybus.txt";
+        case DataFile::Trams: return "tram.txt";
+        case DataFile::Drivers: return "drivers.txt";
+        case DataFile::Routes: return "routes.txt";
+        case DataFile::BusTrips: return "busTrips.txt";
+        case DataFile::TrolleybusTrips: return "trolleybusTrips.txt";
+        case DataFile::TramTrips: return "tramTrips.txt";
+        case DataFile::Admins: return "admins.bin";
+        case DataFile::Snapshot: return SNAPSHOT_FILE_NAME;
+        default: return "";
+    }
+}
+
+std::shared_future<SaveResult> DataManager::saveAllDataAsync(TransportSystem& system,
+                                                             std::function<void(const SaveResult&)> onComplete) {
+    return startSave(system, "", std::move(onComplete));
+}
+
+std::shared_future<SaveResult> DataManager::startSave(TransportSystem& system, std::string messages,
+                                                      std::function<void(const SaveResult&)> onComplete) {
+    // Сохранения идут по одному: копия снимается после записи предыдущей
+    waitForSave();
+    messages += "Сохранение данных в файлы...\n";
+
+    // Файлы, которых нет на диске (первый запуск, удалены вручную), записываются всегда
+    const unsigned fileCount = static_cast<unsigned>(DataFile::Count);
+    for (unsigned i = 0; i < fileCount; ++i) {
+        DataFile file = static_cast<DataFile>(i);
+        std::error_code error;
+        if (!std::filesystem::exists(dataDirectory + getFileName(file), error)) {
+            markDirty(file);
+        }
+    }
+    unsigned files = dirtyFiles.exchange(0);
+    bool unjournaled = unjournaledChanges.exchange(false);
+    if (files == 0) {
+        return completedSave(SaveResult{true, messages + "Нет изменений для сохранения.\n"}, onComplete);
     }
 
+    // Отметка журнала отделяет записи, которые войдут в снимок, от записей, дописанных
+    // во время сохранения. Без нее снимок нельзя связать с журналом - сохранение отменяется
+    std::shared_ptr<SaveTask> task;
     try {
-        saveTrips(system);
+        task = std::make_shared<SaveTask>(system, files, journal.checkpoint());
     } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении рейсов: " << e.what() << "\n";
-        hasErrors = true;
+        dirtyFiles |= files;
+        unjournaledChanges = unjournaledChanges || unjournaled;
+        messages += std::string("[ERROR] Ошибка при записи журнала: ") + e.what() + "\nДанные не сохранены!\n";
+        return completedSave(SaveResult{false, std::move(messages)}, onComplete);
+    }
+    task->log << messages;
+
+    pendingSave = std::async(std::launch::async, [this, task, unjournaled, onComplete = std::move(onComplete)]() {
+        SaveResult result;
+        result.success = writeTask(*task);
+        result.messages = task->log.str();
+        // Незаписанные файлы снова отмечаются измененными; снимок должен быть не старше их
+        if (task->files != 0) {
+            dirtyFiles |= task->files | (1u << static_cast<unsigned>(DataFile::Snapshot));
+        }
+        if (!result.success && unjournaled) {
+            unjournaledChanges = true;
+        }
+        if (onComplete) {
+            onComplete(result);
+        }
+        return result;
+    }).share();
+    return pendingSave;
+}
+
+bool DataManager::writeTask(SaveTask& task) {
+    int changedFiles = std::popcount(task.files);
+    bool hasErrors = false;
+
+    if (task.has(DataFile::Stops)) {
+        try {
+            saveStops(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении остановок: " << e.what() << "\n";
+            hasErrors = true;
+        }
     }
 
+    if (task.has(DataFile::Buses) || task.has(DataFile::Trolleybuses) || task.has(DataFile::Trams)) {
+        try {
+            saveVehicles(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении транспорта: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    if (task.has(DataFile::Drivers)) {
+        try {
+            saveDrivers(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении водителей: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    if (task.has(DataFile::Routes)) {
+        try {
+            saveRoutes(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении маршрутов: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    if (task.has(DataFile::BusTrips) || task.has(DataFile::TrolleybusTrips) || task.has(DataFile::TramTrips)) {
+        try {
+            saveTrips(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении рейсов: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    if (task.has(DataFile::Admins)) {
+        try {
+            saveAdminCredentials(task);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при сохранении учетных данных: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    // Снимок пишется последним, чтобы он был не старше текстовых файлов
     try {
-        saveAdminCredentials(system);
+        BinarySnapshot::write(task.state, dataDirectory + SNAPSHOT_FILE_NAME, task.checkpoint.token);
+        task.files &= ~(1u << static_cast<unsigned>(DataFile::Snapshot));
     } catch (const std::exception& e) {
-        std::cout << "[ERROR] Ошибка при сохранении учетных данных: " << e.what() << "\n";
+        task.log << "[ERROR] Ошибка при сохранении снимка данных: " << e.what() << "\n";
         hasErrors = true;
     }
 
+    // Записи журнала до отметки вошли в новые файлы: журнал сжимается для нового снимка.
+    // При ошибках журнал сохраняется целиком и будет воспроизведен при следующей загрузке
+    if (!hasErrors) {
+        try {
+            journal.compact(BinarySnapshot::readChecksum(dataDirectory + SNAPSHOT_FILE_NAME), task.checkpoint);
+        } catch (const std::exception& e) {
+            task.log << "[ERROR] Ошибка при записи журнала: " << e.what() << "\n";
+            hasErrors = true;
+        }
+    }
+
+    task.log << "[DEBUG] Записано файлов: " << changedFiles - std::popcount(task.files) << " из "
+              << static_cast<unsigned>(DataFile::Count) << "\n";
     if (hasErrors) {
-        std::cout << "Данные сохранены с ошибками!\n";
+        task.log << "Данные сохранены с ошибками!\n";
     } else {
-        std::cout << "Данные успешно сохранены!\n";
+        task.log << "Данные успешно сохранены!\n";
     }
+    return !hasErrors;
 }
 
 void DataManager::loadAllData(TransportSystem& system) {
+    // Фоновое сохранение должно закончить работу с файлами и журналом до загрузки
+    waitForSave();
     try {
         std::cout << "[DEBUG] Начало загрузки данных из папки: " << dataDirectory << std::endl;
 
@@ -140,18 +366,31 @@ void DataManager::loadAllData(TransportSystem& system) {
             }
         }
 
-        loadStops(system);
-        std::cout << "[DEBUG] Остановки загружены: " << system.getStops().size() << std::endl;
-        loadVehicles(system);
-        std::cout << "[DEBUG] Транспорт загружен: " << system.getVehicles().size() << std::endl;
-        loadDrivers(system);
-        std::cout << "[DEBUG] Водители загружены: " << system.getDrivers().size() << std::endl;
-        loadRoutes(system);
-        std::cout << "[DEBUG] Маршруты загружены: " << system.getRoutes().size() << std::endl;
-        loadTrips(system);
-        std::cout << "[DEBUG] Рейсы загружены: " << system.getTrips().size() << std::endl;
-        loadAdminCredentials(system);
-        std::cout << "[DEBUG] Загрузка данных завершена" << std::endl;
+        // Двоичный снимок загружается намного быстрее текстовых файлов; текстовые файлы
+        // читаются, только если снимка нет, он устарел или поврежден
+        bool fromSnapshot = loadSnapshot(system, files);
+        if (!fromSnapshot) {
+            loadStops(system);
+            std::cout << "[DEBUG] Остановки загружены: " << system.getStops().size() << std::endl;
+            loadVehicles(system);
+            std::cout << "[DEBUG] Транспорт загружен: " << system.getVehicles().size() << std::endl;
+            loadDrivers(system);
+            std::cout << "[DEBUG] Водители загружены: " << system.getDrivers().size() << std::endl;
+            loadRoutes(system);
+            std::cout << "[DEBUG] Маршруты загружены: " << system.getRoutes().size() << std::endl;
+            loadTrips(system);
+            std::cout << "[DEBUG] Рейсы загружены: " << system.getTrips().size() << std::endl;
+            loadAdminCredentials(system);
+        }
+        // Загруженные данные совпадают с файлами; устаревший снимок нужно переписать
+        dirtyFiles = 0;
+        if (!fromSnapshot) {
+            markDirty(DataFile::Snapshot);
+        }
+
+        // Изменения после последнего полного сохранения (отмечают измененные файлы)
+        replayJournal(system);
+        std::cout << "[DEBUG] Загрузка данных завершена" << (fromSnapshot ? " (снимок)" : "") << std::endl;
     } catch (const std::exception& e) {
         std::cout << "[DEBUG] Ошибка при загрузке данных: " << e.what() << std::endl;
         // Не игнорируем ошибки, выводим их, но не прерываем выполнение программы
@@ -159,116 +398,160 @@ void DataManager::loadAllData(TransportSystem& system) {
     }
 }
 
-void DataManager::saveStops(TransportSystem& system) {
-    std::string filePath = dataDirectory + "stops.txt";
-    std::cout << "[DEBUG] Сохранение stops.txt в: " << filePath << std::endl;
-    std::ofstream file(filePath, std::ios::trunc);
-    if (!file.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл для записи. Полный путь: " << std::filesystem::absolute(filePath).string() << std::endl;
-        throw FileException("stops.txt", "открытие для записи");
+void DataManager::replayJournal(TransportSystem& system) {
+    std::string journalPath = dataDirectory + JOURNAL_FILE_NAME;
+    uint64_t snapshotChecksum = BinarySnapshot::readChecksum(dataDirectory + SNAPSHOT_FILE_NAME);
+    uint64_t snapshotCheckpoint = BinarySnapshot::readJournalCheckpoint(dataDirectory + SNAPSHOT_FILE_NAME);
+    CommandJournal::ReplayResult replay = CommandJournal::replay(system, journalPath, snapshotChecksum,
+                                                                 snapshotCheckpoint);
+    if (replay.recordCount > 0 || replay.truncated) {
+        std::cout << "[DEBUG] Воспроизведен журнал изменений: записей " << replay.recordCount
+                  << ", применено " << replay.applied << ", с ошибками " << replay.failed;
+        if (replay.skipped > 0) {
+            std::cout << ", уже в снимке " << replay.skipped;
+        }
+        std::cout << (replay.truncated ? ", оборванная запись в конце отброшена" : "") << std::endl;
     }
+    journal.open(journalPath, snapshotChecksum, replay);
+}
 
-    const auto& stops = system.getStops();
-    int savedCount = 0;
-    for (const auto& stop : stops) {
-        file << stop.serialize() << "\n";
-        savedCount++;
+std::unique_ptr<MappedDataset> DataManager::openMappedDataset(bool verify) const {
+    return std::make_unique<MappedDataset>(dataDirectory + SNAPSHOT_FILE_NAME, verify);
+}
+
+bool DataManager::loadSnapshot(TransportSystem& system, const List<std::string>& textFiles) {
+    std::filesystem::path snapshotPath = std::filesystem::path(dataDirectory) / SNAPSHOT_FILE_NAME;
+    std::error_code error;
+    if (!std::filesystem::exists(snapshotPath, error)) {
+        return false;
     }
-    file.close();
-    std::cout << "[DEBUG] Сохранено остановок: " << savedCount << " в файл " << filePath << std::endl;
+
+    // Текстовые файлы, измененные после записи снимка (например, вручную), важнее снимка
+    auto snapshotTime = std::filesystem::last_write_time(snapshotPath, error);
+    if (error) {
+        return false;
+    }
+    for (const auto& fileName : textFiles) {
+        std::filesystem::path filePath = std::filesystem::path(dataDirectory) / fileName;
+        auto fileTime = std::filesystem::last_write_time(filePath, error);
+        if (!error && fileTime > snapshotTime) {
+            std::cout << "[DEBUG] Снимок данных старше файла " << fileName << ", загружаем текстовые файлы" << std::endl;
+            return false;
+        }
+    }
+
+    try {
+        BinarySnapshot::read(system, snapshotPath.string());
+    } catch (const std::exception& e) {
+        std::cout << "[DEBUG] Снимок данных не загружен: " << e.what() << std::endl;
+        return false;
+    }
+    std::cout << "[DEBUG] Загружен снимок данных: остановок " << system.getStops().size()
+              << ", транспорта " << system.getVehicles().size()
+              << ", водителей " << system.getDrivers().size()
+              << ", маршрутов " << system.getRoutes().size()
+              << ", рейсов " << system.getTrips().size() << std::endl;
+    return true;
 }
 
-void DataManager::saveVehicles(TransportSystem& system) {
-    const auto& vehicles = system.getVehicles();
-    
-    // Открываем три файла для разных типов транспорта
-    std::ofstream busFile(dataDirectory + "bus.txt", std::ios::trunc);
-    std::ofstream trolleybusFile(dataDirectory + "trolleybus.txt", std::ios::trunc);
-    std::ofstream tramFile(dataDirectory + "tram.txt", std::ios::trunc);
-    
-    if (!busFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл bus.txt для записи" << std::endl;
-        throw FileException("bus.txt", "открытие для записи");
+void DataManager::writeDataFile(SaveTask& task, DataFile file, const std::string& content) {
+    std::string fileName = getFileName(file);
+    std::string filePath = dataDirectory + fileName;
+    std::string tempPath = filePath + ".tmp";
+    std::error_code error;
+    {
+        std::ofstream out(tempPath, file == DataFile::Admins ? std::ios::binary | std::ios::trunc : std::ios::trunc);
+        if (!out.is_open()) {
+            task.log << "[DEBUG] Ошибка: не удалось открыть файл для записи. Полный путь: " << std::filesystem::absolute(tempPath).string() << "\n";
+            throw FileException(fileName, "открытие для записи");
+        }
+        out.write(content.data(), static_cast<std::streamsize>(content.size()));
+        out.close();
+        if (!out) {
+            std::filesystem::remove(tempPath, error);
+            throw FileException(fileName, "запись");
+        }
     }
-    if (!trolleybusFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл trolleybus.txt для записи" << std::endl;
-        throw FileException("trolleybus.txt", "открытие для записи");
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        throw FileException(fileName, "замена файла");
     }
-    if (!tramFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл tram.txt для записи" << std::endl;
-        throw FileException("tram.txt", "открытие для записи");
+    task.files &= ~(1u << static_cast<unsigned>(file));
+}
+
+void DataManager::saveStops(SaveTask& task) {
+    std::string filePath = dataDirectory + "stops.txt";
+    task.log << "[DEBUG] Сохранение stops.txt в: " << filePath << "\n";
+
+    const auto& stops = task.state.getStops();
+    std::string content;
+    int savedCount = 0;
+    for (const auto& stop : stops) {
+        content += stop.serialize();
+        content += '\n';
+        savedCount++;
     }
+    writeDataFile(task, DataFile::Stops, content);
+    task.log << "[DEBUG] Сохранено остановок: " << savedCount << " в файл " << filePath << "\n";
+}
+
+void DataManager::saveVehicles(SaveTask& task) {
+    const auto& vehicles = task.state.getVehicles();
+
+    // Три файла для разных типов транспорта; собираются только измененные
+    const DataFile files[] = {DataFile::Buses, DataFile::Trolleybuses, DataFile::Trams};
+    const char* labels[] = {"автобусов", "троллейбусов", "трамваев"};
+    std::string contents[3];
+    int counts[3] = {0, 0, 0};
 
-    int busCount = 0, trolleybusCount = 0, tramCount = 0;
-    
     for (const auto& vehicle : vehicles) {
-        std::string vehicleType = vehicle->getType();
-        if (vehicleType == "Автобус") {
-            busFile << vehicle->serialize() << "\n";
-            busCount++;
-        } else if (vehicleType == "Троллейбус") {
-            trolleybusFile << vehicle->serialize() << "\n";
-            trolleybusCount++;
-        } else if (vehicleType == "Трамвай") {
-            tramFile << vehicle->serialize() << "\n";
-            tramCount++;
+        DataFile file = getVehicleFile(vehicle->getType());
+        for (int i = 0; i < 3; ++i) {
+            if (files[i] == file && task.has(file)) {
+                contents[i] += vehicle->serialize();
+                contents[i] += '\n';
+                counts[i]++;
+            }
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        if (task.has(files[i])) {
+            writeDataFile(task, files[i], contents[i]);
+            task.log << "[DEBUG] Сохранено " << labels[i] << ": " << counts[i] << " в файл " << dataDirectory
+                      << getFileName(files[i]) << "\n";
         }
     }
-    
-    busFile.close();
-    trolleybusFile.close();
-    tramFile.close();
-    
-    std::cout << "[DEBUG] Сохранено автобусов: " << busCount << " в файл " << dataDirectory << "bus.txt" << std::endl;
-    std::cout << "[DEBUG] Сохранено троллейбусов: " << trolleybusCount << " в файл " << dataDirectory << "trolleybus.txt" << std::endl;
-    std::cout << "[DEBUG] Сохранено трамваев: " << tramCount << " в файл " << dataDirectory << "tram.txt" << std::endl;
 }
 
-void DataManager::saveDrivers(TransportSystem& system) {
+void DataManager::saveDrivers(SaveTask& task) {
     std::string filePath = dataDirectory + "drivers.txt";
-    std::cout << "[DEBUG] Сохранение drivers.txt в: " << filePath << std::endl;
-    std::ofstream file(filePath, std::ios::trunc);
-    if (!file.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл для записи. Полный путь: " << std::filesystem::absolute(filePath).string() << std::endl;
-        throw FileException("drivers.txt", "открытие для записи");
-    }
+    task.log << "[DEBUG] Сохранение drivers.txt в: " << filePath << "\n";
 
-    const auto& drivers = system.getDrivers();
+    const auto& drivers = task.state.getDrivers();
+    std::string content;
     int savedCount = 0;
     for (const auto& driver : drivers) {
-        file << driver->serialize() << "\n";
+        content += driver->serialize();
+        content += '\n';
         savedCount++;
     }
-    file.close();
-    std::cout << "[DEBUG] Сохранено водителей: " << savedCount << " в файл " << filePath << std::endl;
+    writeDataFile(task, DataFile::Drivers, content);
+    task.log << "[DEBUG] Сохранено водителей: " << savedCount << " в файл " << filePath << "\n";
 }
 
-void DataManager::saveRoutes(TransportSystem& system) {
+void DataManager::saveRoutes(SaveTask& task) {
     std::string filePath = dataDirectory + "routes.txt";
-    std::cout << "[DEBUG] Сохранение routes.txt в: " << filePath << std::endl;
-    std::ofstream file(filePath, std::ios::trunc);
-    if (!file.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл для записи. Полный путь: " << std::filesystem::absolute(filePath).string() << std::endl;
-        throw FileException("routes.txt", "открытие для записи");
-    }
+    task.log << "[DEBUG] Сохранение routes.txt в: " << filePath << "\n";
 
-    const auto& routes = system.getRoutes();
-    const auto& trips = system.getTrips();
+    const auto& routes = task.state.getRoutes();
+    std::string content;
     int savedCount = 0;
 
     for (const auto& route : routes) {
-        // Собираем реальные дни недели из рейсов этого маршрута
-        std::set<int> actualWeekDays;
-        for (const auto& trip : trips) {
-            if (trip->getRoute() == route) {
-                actualWeekDays.insert(trip->getWeekDay());
-            }
-        }
-
-        // Если для маршрута нет рейсов, используем дни недели из самого маршрута
-        if (actualWeekDays.empty()) {
-            actualWeekDays = route->getWeekDays();
-        }
+        // Реальные дни недели из рейсов этого маршрута (без рейсов - дни самого маршрута)
+        std::set<int> actualWeekDays = task.state.getRouteWeekDays(route);
 
         // Формируем строку сериализации с реальными днями недели
         std::string result = std::to_string(route->getNumber()) + "|" + route->getVehicleType() + "|";
@@ -286,83 +569,104 @@ void DataManager::saveRoutes(TransportSystem& system) {
             if (std::next(it) != actualWeekDays.end()) result += ",";
         }
 
-        file << result << "\n";
+        content += result;
+        content += '\n';
         savedCount++;
     }
-    file.close();
-    std::cout << "[DEBUG] Сохранено маршрутов: " << savedCount << " в файл " << filePath << std::endl;
+    writeDataFile(task, DataFile::Routes, content);
+    task.log << "[DEBUG] Сохранено маршрутов: " << savedCount << " в файл " << filePath << "\n";
 }
 
-void DataManager::saveTrips(TransportSystem& system) {
-    const auto& trips = system.getTrips();
-    
-    // Открываем три файла для разных типов транспорта
-    std::ofstream busTripsFile(dataDirectory + "busTrips.txt", std::ios::trunc);
-    std::ofstream trolleybusTripsFile(dataDirectory + "trolleybusTrips.txt", std::ios::trunc);
-    std::ofstream tramTripsFile(dataDirectory + "tramTrips.txt", std::ios::trunc);
-    
-    if (!busTripsFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл busTrips.txt для записи" << std::endl;
-        throw FileException("busTrips.txt", "открытие для записи");
-    }
-    if (!trolleybusTripsFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл trolleybusTrips.txt для записи" << std::endl;
-        throw FileException("trolleybusTrips.txt", "открытие для записи");
-    }
-    if (!tramTripsFile.is_open()) {
-        std::cout << "[DEBUG] Ошибка: не удалось открыть файл tramTrips.txt для записи" << std::endl;
-        throw FileException("tramTrips.txt", "открытие для записи");
-    }
+void DataManager::saveTrips(SaveTask& task) {
+    const auto& trips = task.state.getTrips();
+
+    // Три файла для разных типов транспорта; собираются только измененные
+    const DataFile files[] = {DataFile::BusTrips, DataFile::TrolleybusTrips, DataFile::TramTrips};
+    const char* labels[] = {"автобусов", "троллейбусов", "трамваев"};
+    std::string contents[3];
+    int counts[3] = {0, 0, 0};
 
-    int busTripsCount = 0, trolleybusTripsCount = 0, tramTripsCount = 0;
-    
     for (const auto& trip : trips) {
         auto route = trip->getRoute();
         if (!route) {
             continue; // Пропускаем рейсы без маршрута
         }
-        
-        std::string vehicleType = route->getVehicleType();
-        if (vehicleType == "Автобус") {
-            busTripsFile << trip->serialize() << "\n";
-            busTripsCount++;
-        } else if (vehicleType == "Троллейбус") {
-            trolleybusTripsFile << trip->serialize() << "\n";
-            trolleybusTripsCount++;
-        } else if (vehicleType == "Трамвай") {
-            tramTripsFile << trip->serialize() << "\n";
-            tramTripsCount++;
+
+        DataFile file = getTripFile(route->getVehicleType());
+        for (int i = 0; i < 3; ++i) {
+            if (files[i] == file && task.has(file)) {
+                contents[i] += trip->serialize();
+                contents[i] += '\n';
+                counts[i]++;
+            }
         }
     }
-    
-    busTripsFile.close();
-    trolleybusTripsFile.close();
-    tramTripsFile.close();
-    
-    std::cout << "[DEBUG] Сохранено рейсов автобусов: " << busTripsCount << " в файл " << dataDirectory << "busTrips.txt" << std::endl;
-    std::cout << "[DEBUG] Сохранено рейсов троллейбусов: " << trolleybusTripsCount << " в файл " << dataDirectory << "trolleybusTrips.txt" << std::endl;
-    std::cout << "[DEBUG] Сохранено рейсов трамваев: " << tramTripsCount << " в файл " << dataDirectory << "tramTrips.txt" << std::endl;
-}
 
-void DataManager::saveAdminCredentials(TransportSystem& system) {
-    std::ofstream file(dataDirectory + "admins.bin", std::ios::binary | std::ios::trunc);
-    if (!file.is_open()) throw FileException("admins.bin", "открытие для записи");
+    for (int i = 0; i < 3; ++i) {
+        if (task.has(files[i])) {
+            writeDataFile(task, files[i], contents[i]);
+            task.log << "[DEBUG] Сохранено рейсов " << labels[i] << ": " << counts[i] << " в файл " << dataDirectory
+                      << getFileName(files[i]) << "\n";
+        }
+    }
+}
 
-    const auto& creds = system.getAdminCredentials();
-    size_t count = creds.size();
-    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+void DataManager::saveAdminCredentials(SaveTask& task) {
+    const auto& creds = task.state.getAdminCredentials();
+    std::string content;
+    auto writeSize = [&content](size_t value) {
+        content.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
 
+    writeSize(creds.size());
     for (const auto& [username, password] : creds) {
-        size_t usernameLen = username.size();
-        size_t passwordLen = password.size();
-        file.write(reinterpret_cast<const char*>(&usernameLen), sizeof(usernameLen));
-        file.write(username.c_str(), usernameLen);
-        file.write(reinterpret_cast<const char*>(&passwordLen), sizeof(passwordLen));
-        file.write(password.c_str(), passwordLen);
+        writeSize(username.size());
+        content += username;
+        writeSize(password.size());
+        content += password;
     }
-    file.close();
+    writeDataFile(task, DataFile::Admins, content);
 }
 
+// Записи файла, пропущенные при загрузке из-за уже существующего ключа
+// Ключи проверяются по хеш-индексам системы и хеш-множествам прочитанного пакета, а вместо
+// строки на каждый дубликат выводится одна сводка по файлу с первыми несколькими ключами
+class DuplicateReport {
+private:
+    static const int MAX_EXAMPLES = 5;
+    std::string fileName;
+    std::string keyName;   // Что является ключом записи ("ID", "номер")
+    int count = 0;
+    std::string examples;
+
+public:
+    DuplicateReport(const std::string& fileName, const std::string& keyName)
+        : fileName(fileName), keyName(keyName) {}
+
+    void add(const std::string& key) {
+        if (count < MAX_EXAMPLES) {
+            examples += (count > 0 ? ", " : "") + key;
+        }
+        count++;
+    }
+
+    int getCount() const {
+        return count;
+    }
+
+    void print() const {
+        if (count == 0) {
+            return;
+        }
+        std::cout << "[DEBUG] Пропущено дубликатов в " << fileName << ": " << count
+                  << " (" << keyName << ": " << examples;
+        if (count > MAX_EXAMPLES) {
+            std::cout << " и еще " << count - MAX_EXAMPLES;
+        }
+        std::cout << ")" << std::endl;
+    }
+};
+
 void DataManager::loadStops(TransportSystem& system) {
     std::string filePath = dataDirectory + "stops.txt";
     std::cout << "[DEBUG] Попытка загрузить stops.txt из: " << filePath << std::endl;
@@ -377,6 +681,7 @@ void DataManager::loadStops(TransportSystem& system) {
     int loadedCount = 0;
     int emptyLines = 0;
     int errorLines = 0;
+    DuplicateReport duplicates("stops.txt", "ID");
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -397,19 +702,11 @@ void DataManager::loadStops(TransportSystem& system) {
         try {
             Stop stop = Stop::deserialize(line);
             // Проверяем на дубликаты перед добавлением
-            bool exists = false;
-            const auto& existingStops = system.getStops();
-            for (const auto& existingStop : existingStops) {
-                if (existingStop.getId() == stop.getId()) {
-                    exists = true;
-                    break;
-                }
-            }
-            if (!exists) {
+            if (!system.hasStop(stop.getId())) {
                 system.addStopDirect(stop);
                 loadedCount++;
             } else {
-                std::cout << "[DEBUG] Остановка с ID " << stop.getId() << " уже существует, пропускаем" << std::endl;
+                duplicates.add(std::to_string(stop.getId()));
             }
         } catch (const std::exception& e) {
             errorLines++;
@@ -425,6 +722,7 @@ void DataManager::loadStops(TransportSystem& system) {
     file.close();
 
     std::cout << "[DEBUG] Всего загружено остановок: " << loadedCount << std::endl;
+    duplicates.print();
     if (emptyLines > 0) {
         std::cout << "[DEBUG] Пропущено пустых строк: " << emptyLines << std::endl;
     }
@@ -492,12 +790,62 @@ void DataManager::loadVehicles(TransportSystem& system) {
 }
 
 // Вспомогательный метод для загрузки транспорта из файла
+// Разбор записи транспортного средства "тип|модель|номер|вместимость|топливо или напряжение"
+// Поля обрезаются от пробелов; вместимость и напряжение, которые не удалось разобрать,
+// заменяются значениями по умолчанию
+std::shared_ptr<Vehicle> DataManager::parseVehicle(std::string_view line) {
+    FieldSplitter fields(line, '|');
+    std::string_view type = RecordParser::trim(fields.next());
+    std::string_view model = RecordParser::trim(fields.next());
+    std::string licensePlate(RecordParser::trim(fields.next()));
+
+    std::shared_ptr<Vehicle> vehicle;
+    if (type == "Автобус") {
+        // Читаем capacity и fuelType для автобуса
+        std::string_view capacityStr = fields.next();
+        std::string_view fuelType = fields.remainder();
+        int capacity = 50; // значение по умолчанию, если число не разобрано
+        RecordParser::tryParseInt(capacityStr, capacity);
+        if (fuelType.empty()) {
+            fuelType = "дизель";
+        }
+        vehicle = std::make_shared<Bus>(std::string(model), licensePlate, capacity,
+                                        std::string(RecordParser::trim(fuelType)));
+    } else if (type == "Трамвай") {
+        // Читаем capacity и voltage для трамвая
+        std::string_view capacityStr = fields.next();
+        std::string_view voltageStr = fields.remainder();
+        int capacity = 100; // значения по умолчанию, если числа не разобраны
+        double voltage = 600.0;
+        RecordParser::tryParseInt(capacityStr, capacity);
+        RecordParser::tryParseDouble(voltageStr, voltage);
+        vehicle = std::make_shared<Tram>(std::string(model), licensePlate, capacity, voltage);
+    } else if (type == "Троллейбус") {
+        // Читаем capacity и voltage для троллейбуса
+        std::string_view capacityStr = fields.next();
+        std::string_view voltageStr = fields.remainder();
+        int capacity = 50; // значения по умолчанию, если числа не разобраны
+        double voltage = 600.0;
+        RecordParser::tryParseInt(capacityStr, capacity);
+        RecordParser::tryParseDouble(voltageStr, voltage);
+        vehicle = std::make_shared<Trolleybus>(std::string(model), licensePlate, capacity, voltage);
+    } else {
+        throw InputException("Неизвестный тип транспорта: " + std::string(type));
+    }
+
+    return vehicle;
+}
+
 int DataManager::loadVehiclesFromFile(std::ifstream& file, TransportSystem& system, const std::string& fileName) {
     std::string line;
     int lineNumber = 0;
     int loadedCount = 0;
     int emptyLines = 0;
     int errorLines = 0;
+    // Прочитанные транспортные средства добавляются в систему одним пакетом
+    List<std::shared_ptr<Vehicle>> batch;
+    std::unordered_set<std::string> batchPlates;
+    DuplicateReport duplicates(fileName, "номера");
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -516,104 +864,23 @@ int DataManager::loadVehiclesFromFile(std::ifstream& file, TransportSystem& syst
         }
 
         try {
-            std::istringstream ss(line);
-            std::string type, model, licensePlate;
-            std::getline(ss, type, '|');
-            std::getline(ss, model, '|');
-            std::getline(ss, licensePlate, '|');
-
-            // Убираем пробелы из полей
-            type.erase(0, type.find_first_not_of(" \t"));
-            type.erase(type.find_last_not_of(" \t") + 1);
-            model.erase(0, model.find_first_not_of(" \t"));
-            model.erase(model.find_last_not_of(" \t") + 1);
-            licensePlate.erase(0, licensePlate.find_first_not_of(" \t"));
-            licensePlate.erase(licensePlate.find_last_not_of(" \t") + 1);
+            // Номер - третье поле записи
+            FieldSplitter fields(line, '|');
+            fields.next();
+            fields.next();
+            std::string licensePlate(RecordParser::trim(fields.next()));
 
-            // Проверяем на дубликаты перед добавлением
-            bool exists = false;
-            const auto& existingVehicles = system.getVehicles();
-            for (const auto& existingVehicle : existingVehicles) {
-                if (existingVehicle->getLicensePlate() == licensePlate) {
-                    exists = true;
-                    break;
-                }
-            }
+            // Проверяем на дубликаты перед добавлением (в системе и среди уже прочитанных)
+            bool exists = system.findVehicleByLicensePlate(licensePlate) != nullptr ||
+                          batchPlates.count(licensePlate) != 0;
 
             if (!exists) {
-                std::shared_ptr<Vehicle> vehicle;
-                if (type == "Автобус") {
-                    // Читаем capacity и fuelType для автобуса
-                    std::string capacityStr, fuelType;
-                    std::getline(ss, capacityStr, '|');
-                    std::getline(ss, fuelType);
-                    int capacity = 50; // значение по умолчанию
-                    if (!capacityStr.empty()) {
-                        try {
-                            capacity = std::stoi(capacityStr);
-                        } catch (...) {
-                            // Используем значение по умолчанию
-                        }
-                    }
-                    if (fuelType.empty()) {
-                        fuelType = "дизель";
-                    }
-                    // Убираем пробелы
-                    fuelType.erase(0, fuelType.find_first_not_of(" \t"));
-                    fuelType.erase(fuelType.find_last_not_of(" \t") + 1);
-                    vehicle = std::make_shared<Bus>(model, licensePlate, capacity, fuelType);
-                } else if (type == "Трамвай") {
-                    // Читаем capacity и voltage для трамвая
-                    std::string capacityStr, voltageStr;
-                    std::getline(ss, capacityStr, '|');
-                    std::getline(ss, voltageStr);
-                    int capacity = 100; // значение по умолчанию
-                    double voltage = 600.0; // значение по умолчанию
-                    if (!capacityStr.empty()) {
-                        try {
-                            capacity = std::stoi(capacityStr);
-                        } catch (...) {
-                            // Используем значение по умолчанию
-                        }
-                    }
-                    if (!voltageStr.empty()) {
-                        try {
-                            voltage = std::stod(voltageStr);
-                        } catch (...) {
-                            // Используем значение по умолчанию
-                        }
-                    }
-                    vehicle = std::make_shared<Tram>(model, licensePlate, capacity, voltage);
-                } else if (type == "Троллейбус") {
-                    // Читаем capacity и voltage для троллейбуса
-                    std::string capacityStr, voltageStr;
-                    std::getline(ss, capacityStr, '|');
-                    std::getline(ss, voltageStr);
-                    int capacity = 50; // значение по умолчанию
-                    double voltage = 600.0; // значение по умолчанию
-                    if (!capacityStr.empty()) {
-                        try {
-                            capacity = std::stoi(capacityStr);
-                        } catch (...) {
-                            // Используем значение по умолчанию
-                        }
-                    }
-                    if (!voltageStr.empty()) {
-                        try {
-                            voltage = std::stod(voltageStr);
-                        } catch (...) {
-                            // Используем значение по умолчанию
-                        }
-                    }
-                    vehicle = std::make_shared<Trolleybus>(model, licensePlate, capacity, voltage);
-                } else {
-                    throw InputException("Неизвестный тип транспорта: " + type);
-                }
-
-                system.addVehicleDirect(vehicle);
+                std::shared_ptr<Vehicle> vehicle = parseVehicle(line);
+                batch.push_back(vehicle);
+                batchPlates.insert(licensePlate);
                 loadedCount++;
             } else {
-                std::cout << "[DEBUG] Транспорт с номером " << licensePlate << " уже существует, пропускаем" << std::endl;
+                duplicates.add(licensePlate);
             }
         } catch (const std::exception& e) {
             errorLines++;
@@ -624,10 +891,13 @@ int DataManager::loadVehiclesFromFile(std::ifstream& file, TransportSystem& syst
         }
     }
 
+    system.addVehiclesDirect(batch);
+
     if (file.bad() && !file.eof()) {
         throw FileException(fileName, "ошибка чтения файла");
     }
 
+    duplicates.print();
     if (emptyLines > 0) {
         std::cout << "[DEBUG] Пропущено пустых строк в " << fileName << ": " << emptyLines << std::endl;
     }
@@ -656,6 +926,10 @@ void DataManager::loadDrivers(TransportSystem& system) {
     int loadedCount = 0;
     int emptyLines = 0;
     int errorLines = 0;
+    // Прочитанные водители добавляются в систему одним пакетом
+    List<std::shared_ptr<Driver>> batch;
+    std::unordered_set<std::string> batchNames;
+    DuplicateReport duplicates("drivers.txt", "водители");
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -677,11 +951,7 @@ void DataManager::loadDrivers(TransportSystem& system) {
                 // Проверяем, что строка не содержит данные транспорта (формат: тип|модель|номер)
                 // Водители должны быть в формате: имя|фамилия|отчество
                 // Если в строке есть цифры в первой части или формат не соответствует, пропускаем
-                std::istringstream testStream(line);
-                std::string firstPart, secondPart, thirdPart;
-                std::getline(testStream, firstPart, '|');
-                std::getline(testStream, secondPart, '|');
-                std::getline(testStream, thirdPart);
+                std::string_view firstPart = FieldSplitter(line, '|').next();
 
                 // Проверяем, что первая часть не является типом транспорта
                 if (firstPart == "Автобус" || firstPart == "Трамвай" || firstPart == "Троллейбус") {
@@ -699,22 +969,18 @@ void DataManager::loadDrivers(TransportSystem& system) {
                 }
 
                 auto driver = Driver::deserialize(line);
-                // Проверяем на дубликаты перед добавлением
-                bool exists = false;
-                const auto& existingDrivers = system.getDrivers();
-                for (const auto& existingDriver : existingDrivers) {
-                    if (existingDriver->getFirstName() == driver->getFirstName() &&
-                        existingDriver->getLastName() == driver->getLastName() &&
-                        existingDriver->getMiddleName() == driver->getMiddleName()) {
-                        exists = true;
-                        break;
-                    }
-                }
+                // Проверяем на дубликаты перед добавлением (в системе и среди уже прочитанных)
+                std::string key = driver->getLastName() + '\x1f' + driver->getFirstName() + '\x1f' +
+                                  driver->getMiddleName();
+                bool exists = system.hasDriver(driver->getFirstName(), driver->getLastName(),
+                                               driver->getMiddleName()) ||
+                              batchNames.count(key) != 0;
                 if (!exists) {
-                    system.addDriverDirect(driver);
+                    batch.push_back(driver);
+                    batchNames.insert(key);
                     loadedCount++;
                 } else {
-                    std::cout << "[DEBUG] Водитель " << driver->getFullName() << " уже существует, пропускаем" << std::endl;
+                    duplicates.add(driver->getFullName());
                 }
         } catch (const std::exception& e) {
             errorLines++;
@@ -725,12 +991,15 @@ void DataManager::loadDrivers(TransportSystem& system) {
         }
     }
 
+    system.addDriversDirect(batch);
+
     if (file.bad() && !file.eof()) {
         throw FileException("drivers.txt", "ошибка чтения файла");
     }
     file.close();
 
     std::cout << "[DEBUG] Всего загружено водителей: " << loadedCount << std::endl;
+    duplicates.print();
     if (emptyLines > 0) {
         std::cout << "[DEBUG] Пропущено пустых строк: " << emptyLines << std::endl;
     }
@@ -757,6 +1026,7 @@ void DataManager::loadRoutes(TransportSystem& system) {
     int loadedCount = 0;
     int emptyLines = 0;
     int errorLines = 0;
+    DuplicateReport duplicates("routes.txt", "номера");
 
     while (std::getline(file, line)) {
         lineNumber++;
@@ -777,19 +1047,11 @@ void DataManager::loadRoutes(TransportSystem& system) {
         try {
             auto route = Route::deserialize(line);
             // Проверяем на дубликаты перед добавлением
-            bool exists = false;
-            const auto& existingRoutes = system.getRoutes();
-            for (const auto& existingRoute : existingRoutes) {
-                if (existingRoute->getNumber() == route->getNumber()) {
-                    exists = true;
-                    break;
-                }
-            }
-            if (!exists) {
+            if (!system.findRouteByNumber(route->getNumber())) {
                 system.addRouteDirect(route);
                 loadedCount++;
             } else {
-                std::cout << "[DEBUG] Маршрут с номером " << route->getNumber() << " уже существует, пропускаем" << std::endl;
+                duplicates.add(std::to_string(route->getNumber()));
             }
         } catch (const std::exception& e) {
             errorLines++;
@@ -806,6 +1068,7 @@ void DataManager::loadRoutes(TransportSystem& system) {
     file.close();
 
     std::cout << "[DEBUG] Всего загружено маршрутов: " << loadedCount << std::endl;
+    duplicates.print();
     if (emptyLines > 0) {
         std::cout << "[DEBUG] Пропущено пустых строк: " << emptyLines << std::endl;
     }
@@ -819,126 +1082,193 @@ void DataManager::loadRoutes(TransportSystem& system) {
 }
 
 void DataManager::loadTrips(TransportSystem& system) {
-    int totalLoaded = 0;
-    
-    // Загружаем рейсы автобусов
-    std::string busTripsFilePath = dataDirectory + "busTrips.txt";
-    std::cout << "[DEBUG] Попытка загрузить busTrips.txt из: " << busTripsFilePath << std::endl;
-    std::ifstream busTripsFile(busTripsFilePath);
-    if (busTripsFile.is_open()) {
-        int loaded = loadTripsFromFile(busTripsFile, system, "busTrips.txt");
-        totalLoaded += loaded;
-        busTripsFile.close();
-    } else {
-        std::cout << "[DEBUG] Файл busTrips.txt не найден или не может быть открыт. Полный путь: " << std::filesystem::absolute(busTripsFilePath).string() << std::endl;
-    }
-    
-    // Загружаем рейсы троллейбусов
-    std::string trolleybusTripsFilePath = dataDirectory + "trolleybusTrips.txt";
-    std::cout << "[DEBUG] Попытка загрузить trolleybusTrips.txt из: " << trolleybusTripsFilePath << std::endl;
-    std::ifstream trolleybusTripsFile(trolleybusTripsFilePath);
-    if (trolleybusTripsFile.is_open()) {
-        int loaded = loadTripsFromFile(trolleybusTripsFile, system, "trolleybusTrips.txt");
-        totalLoaded += loaded;
-        trolleybusTripsFile.close();
-    } else {
-        std::cout << "[DEBUG] Файл trolleybusTrips.txt не найден или не может быть открыт. Полный путь: " << std::filesystem::absolute(trolleybusTripsFilePath).string() << std::endl;
-    }
-    
-    // Загружаем рейсы трамваев
-    std::string tramTripsFilePath = dataDirectory + "tramTrips.txt";
-    std::cout << "[DEBUG] Попытка загрузить tramTrips.txt из: " << tramTripsFilePath << std::endl;
-    std::ifstream tramTripsFile(tramTripsFilePath);
-    if (tramTripsFile.is_open()) {
-        int loaded = loadTripsFromFile(tramTripsFile, system, "tramTrips.txt");
-        totalLoaded += loaded;
-        tramTripsFile.close();
-    } else {
-        std::cout << "[DEBUG] Файл tramTrips.txt не найден или не может быть открыт. Полный путь: " << std::filesystem::absolute(tramTripsFilePath).string() << std::endl;
-    }
-    
+    // Файлы рейсов разных видов транспорта разбираются одновременно
+    List<std::string> fileNames;
+    fileNames.push_back("busTrips.txt");
+    fileNames.push_back("trolleybusTrips.txt");
+    fileNames.push_back("tramTrips.txt");
+    int totalLoaded = loadTripFiles(system, fileNames);
+
     // Для обратной совместимости: если новые файлы не найдены, пытаемся загрузить из старого trips.txt
     if (totalLoaded == 0) {
-        std::string oldFilePath = dataDirectory + "trips.txt";
         std::cout << "[DEBUG] Новые файлы не найдены, пытаемся загрузить из старого trips.txt" << std::endl;
-        std::ifstream oldFile(oldFilePath);
-        if (oldFile.is_open()) {
-            int loaded = loadTripsFromFile(oldFile, system, "trips.txt");
-            totalLoaded += loaded;
-            oldFile.close();
-        }
+        List<std::string> oldFileNames;
+        oldFileNames.push_back("trips.txt");
+        totalLoaded += loadTripFiles(system, oldFileNames);
     }
-    
+
     std::cout << "[DEBUG] Всего загружено рейсов: " << totalLoaded << std::endl;
 }
 
-// Вспомогательный метод для загрузки рейсов из файла
-int DataManager::loadTripsFromFile(std::ifstream& file, TransportSystem& system, const std::string& fileName) {
-    std::string line;
-    int lineNumber = 0;
-    int loadedCount = 0;
+// Размер части файла рейсов, разбираемой одной задачей (граница сдвигается до конца строки)
+static const size_t TRIP_CHUNK_SIZE = 1 << 20;
+
+// Результат разбора одной непустой строки файла рейсов
+struct TripLineResult {
+    int lineNumber;                // Номер строки внутри части (с 1)
+    std::shared_ptr<Trip> trip;    // Рейс, если строка разобрана
+    std::string text;              // Строка без пробелов по краям (для отложенных и ошибочных)
+    std::string error;             // Текст ошибки разбора
+};
+
+// Часть файла рейсов: строки [begin, end) содержимого файла
+struct TripFileChunk {
+    size_t file;
+    size_t begin;
+    size_t end;
+    int lineCount = 0;
     int emptyLines = 0;
-    int errorLines = 0;
-
-    while (std::getline(file, line)) {
-        lineNumber++;
-        if (line.empty()) {
-            emptyLines++;
+    std::vector<TripLineResult> lines;
+};
+
+// Рейсы читаются в два этапа. Сначала файлы целиком считываются в память, делятся на части
+// по границам строк, и части разбираются параллельно без изменения системы (рейсы только
+// ищут маршрут, транспорт и водителя). Затем результаты обходятся по порядку файлов и строк:
+// строки, которым нужен новый транспорт или водитель, разбираются повторно уже с добавлением
+// в систему, а проверка дубликатов и вывод идут так же, как при последовательном чтении
+int DataManager::loadTripFiles(TransportSystem& system, const List<std::string>& fileNames) {
+    std::vector<std::string> names;
+    std::vector<std::string> contents;
+    std::vector<bool> opened;
+    for (const auto& fileName : fileNames) {
+        std::string filePath = dataDirectory + fileName;
+        std::cout << "[DEBUG] Попытка загрузить " << fileName << " из: " << filePath << std::endl;
+        std::ifstream file(filePath, std::ios::binary);
+        names.push_back(fileName);
+        contents.emplace_back();
+        opened.push_back(file.is_open());
+        if (!file.is_open()) {
+            std::cout << "[DEBUG] Файл " << fileName << " не найден или не может быть открыт. Полный путь: " << std::filesystem::absolute(filePath).string() << std::endl;
             continue;
         }
+        file.seekg(0, std::ios::end);
+        std::streamoff fileSize = file.tellg();
+        file.seekg(0, std::ios::beg);
+        if (fileSize > 0) {
+            contents.back().resize(static_cast<size_t>(fileSize));
+            file.read(contents.back().data(), fileSize);
+        }
+        if (file.bad() || (fileSize > 0 && file.gcount() != fileSize)) {
+            throw FileException(fileName, "ошибка чтения файла");
+        }
+    }
 
-        // Убираем пробелы в начале и конце строки
-        line.erase(0, line.find_first_not_of(" \t\r\n"));
-        line.erase(line.find_last_not_of(" \t\r\n") + 1);
-
-        if (line.empty()) {
-            emptyLines++;
-            continue;
+    std::vector<TripFileChunk> chunks;
+    for (size_t f = 0; f < contents.size(); ++f) {
+        const std::string& content = contents[f];
+        for (size_t begin = 0; begin < content.size();) {
+            size_t end = content.find('\n', std::min(begin + TRIP_CHUNK_SIZE, content.size()) - 1);
+            end = end == std::string::npos ? content.size() : end + 1;
+            TripFileChunk chunk;
+            chunk.file = f;
+            chunk.begin = begin;
+            chunk.end = end;
+            chunks.push_back(std::move(chunk));
+            begin = end;
         }
+    }
 
-        try {
-            auto trip = Trip::deserialize(line, &system);
-            // Проверяем на дубликаты перед добавлением
-            bool exists = false;
-            const auto& existingTrips = system.getTrips();
-            for (const auto& existingTrip : existingTrips) {
-                if (existingTrip->getTripId() == trip->getTripId()) {
-                    exists = true;
-                    break;
-                }
+    ThreadPool::shared().parallelFor(chunks.size(), [&](size_t index) {
+        TripFileChunk& chunk = chunks[index];
+        const std::string& content = contents[chunk.file];
+        for (size_t position = chunk.begin; position < chunk.end;) {
+            size_t lineEnd = content.find('\n', position);
+            if (lineEnd == std::string::npos || lineEnd > chunk.end) {
+                lineEnd = chunk.end;
             }
-            if (!exists) {
-                system.addTripDirect(trip);
-                loadedCount++;
-                std::cout << "[DEBUG] Загружен рейс ID: " << trip->getTripId() << " из " << fileName << std::endl;
-            } else {
-                std::cout << "[DEBUG] Рейс с ID " << trip->getTripId() << " уже существует, пропускаем" << std::endl;
+            std::string line = content.substr(position, lineEnd - position);
+            position = lineEnd + 1;
+            chunk.lineCount++;
+
+            // Убираем пробелы в начале и конце строки
+            line.erase(0, line.find_first_not_of(" \t\r\n"));
+            line.erase(line.find_last_not_of(" \t\r\n") + 1);
+            if (line.empty()) {
+                chunk.emptyLines++;
+                continue;
             }
-        } catch (const std::exception& e) {
-            errorLines++;
-            std::cout << "[DEBUG] Ошибка при загрузке рейса из файла " << fileName << ", строка " << lineNumber << ": " << e.what() << std::endl;
-            std::cout << "[DEBUG] Содержимое строки (первые 100 символов): " << line.substr(0, 100) << std::endl;
-            // Не бросаем исключение, просто пропускаем неправильную строку
+
+            TripLineResult result{chunk.lineCount, nullptr, {}, {}};
+            try {
+                result.trip = Trip::deserialize(line, &system, false);
+            } catch (const std::exception& e) {
+                result.error = e.what();
+            }
+            if (!result.trip) {
+                result.text = std::move(line);
+            }
+            chunk.lines.push_back(std::move(result));
+        }
+    });
+
+    int totalLoaded = 0;
+    size_t chunkIndex = 0;
+    for (size_t f = 0; f < names.size(); ++f) {
+        if (!opened[f]) {
             continue;
         }
-    }
+        const std::string& fileName = names[f];
+        int lineOffset = 0;
+        int loadedCount = 0;
+        int emptyLines = 0;
+        int errorLines = 0;
+        // Прочитанные рейсы добавляются в систему одним пакетом
+        List<std::shared_ptr<Trip>> batch;
+        std::unordered_set<int> batchIds;
+        DuplicateReport duplicates(fileName, "ID");
+
+        for (; chunkIndex < chunks.size() && chunks[chunkIndex].file == f; ++chunkIndex) {
+            TripFileChunk& chunk = chunks[chunkIndex];
+            emptyLines += chunk.emptyLines;
+            for (auto& result : chunk.lines) {
+                int lineNumber = lineOffset + result.lineNumber;
+                std::shared_ptr<Trip> trip = result.trip;
+                if (!trip && result.error.empty()) {
+                    // Рейсу нужен новый транспорт или водитель: разбираем строку повторно
+                    try {
+                        trip = Trip::deserialize(result.text, &system);
+                    } catch (const std::exception& e) {
+                        result.error = e.what();
+                    }
+                }
+                if (!trip) {
+                    errorLines++;
+                    std::cout << "[DEBUG] Ошибка при загрузке рейса из файла " << fileName << ", строка " << lineNumber << ": " << result.error << std::endl;
+                    std::cout << "[DEBUG] Содержимое строки (первые 100 символов): " << result.text.substr(0, 100) << std::endl;
+                    // Не бросаем исключение, просто пропускаем неправильную строку
+                    continue;
+                }
 
-    if (file.bad() && !file.eof()) {
-        throw FileException(fileName, "ошибка чтения файла");
-    }
+                // Проверяем на дубликаты перед добавлением (в системе и среди уже прочитанных)
+                bool exists = system.getTripById(trip->getTripId()) != nullptr ||
+                              batchIds.count(trip->getTripId()) != 0;
+                if (!exists) {
+                    batch.push_back(trip);
+                    batchIds.insert(trip->getTripId());
+                    loadedCount++;
+                    std::cout << "[DEBUG] Загружен рейс ID: " << trip->getTripId() << " из " << fileName << std::endl;
+                } else {
+                    duplicates.add(std::to_string(trip->getTripId()));
+                }
+            }
+            lineOffset += chunk.lineCount;
+        }
 
-    if (emptyLines > 0) {
-        std::cout << "[DEBUG] Пропущено пустых строк в " << fileName << ": " << emptyLines << std::endl;
-    }
-    if (errorLines > 0) {
-        std::cout << "[DEBUG] Ошибок при загрузке рейсов из " << fileName << ": " << errorLines << std::endl;
-    }
+        system.addTripsDirect(batch);
+        totalLoaded += loadedCount;
 
-    if (loadedCount == 0 && lineNumber == 0) {
-        std::cout << "[DEBUG] ВНИМАНИЕ: Файл " << fileName << " пуст или не содержит данных!" << std::endl;
+        duplicates.print();
+        if (emptyLines > 0) {
+            std::cout << "[DEBUG] Пропущено пустых строк в " << fileName << ": " << emptyLines << std::endl;
+        }
+        if (errorLines > 0) {
+            std::cout << "[DEBUG] Ошибок при загрузке рейсов из " << fileName << ": " << errorLines << std::endl;
+        }
+        if (loadedCount == 0 && lineOffset == 0) {
+            std::cout << "[DEBUG] ВНИМАНИЕ: Файл " << fileName << " пуст или не содержит данных!" << std::endl;
+        }
     }
-    
-    return loadedCount;
+    return totalLoaded;
 }
 
 void DataManager::loadAdminCredentials(TransportSystem& system) {
@@ -2,10 +2,46 @@
 #define DATA_MANAGER_H
 
 #include <string>
+#include <string_view>
+#include <memory>
+#include <atomic>
+#include <functional>
+#include <future>
 #include <filesystem>
 #include <fstream>
+#include <sstream>
+#include "list.h"
+#include "command_journal.h"
+#include "system_state.h"
 
 class TransportSystem;
+class MappedDataset;
+class Vehicle;
+
+// Файлы данных, которые сохраняются по отдельности (номер бита в маске измененных файлов)
+// Транспорт и рейсы хранятся в отдельном файле для каждого вида транспорта
+enum class DataFile : unsigned {
+    Stops,
+    Buses,
+    Trolleybuses,
+    Trams,
+    Drivers,
+    Routes,
+    BusTrips,
+    TrolleybusTrips,
+    TramTrips,
+    Admins,
+    Snapshot,   // Снимок содержит все данные и меняется вместе с любым файлом
+    Count
+};
+
+// Итог сохранения
+// Поток записи не печатает сообщения сам, а копит их здесь: их выводит тот, кто дождался
+// итога, поэтому сообщения не вклиниваются в меню и ввод пользователя
+struct SaveResult {
+    bool success = false;    // Все изменения сохранены
+    std::string messages;    // Сообщения о ходе сохранения (строки с '\n')
+};
 
 // Класс для управления сохранением и загрузкой данных
 // Обеспечивает персистентность данных транспортной системы:
@@ -13,27 +49,128 @@ class TransportSystem;
 // маршрутов, рейсов и учетных данных администраторов
 class DataManager {
 private:
+    // Задание сохранения: копия состояния, файлы, которые осталось записать, и отметка журнала
+    struct SaveTask {
+        SystemState state;
+        unsigned files;                         // Биты DataFile; бит снимается после записи файла
+        CommandJournal::Checkpoint checkpoint;
+        std::ostringstream log;                 // Сообщения потока записи
+
+        SaveTask(TransportSystem& system, unsigned files, const CommandJournal::Checkpoint& checkpoint);
+        bool has(DataFile file) const;
+    };
+
     std::string dataDirectory;  // Путь к директории с данными
+    CommandJournal journal;     // Журнал изменений после последнего полного сохранения
+    // Файлы, данные которых изменились после сохранения (биты DataFile); меняются и потоком записи
+    std::atomic<unsigned> dirtyFiles{0};
+    // Есть изменения в обход команд, которых нет в журнале
+    std::atomic<bool> unjournaledChanges{false};
+    std::shared_future<SaveResult> pendingSave;  // Последнее фоновое сохранение
 
 public:
     // Конструктор менеджера данных
     // Создает директорию, если она не существует, и нормализует путь
     DataManager(const std::string& dir = "data/");
 
-    // Сохранить все данные транспортной системы в файлы
-    void saveAllData(TransportSystem& system);
+    // Дожидается фонового сохранения
+    ~DataManager();
+
+    DataManager(const DataManager&) = delete;
+    DataManager& operator=(const DataManager&) = delete;
+
+    // Имя файла двоичного снимка в директории данных
+    static constexpr const char* SNAPSHOT_FILE_NAME = "snapshot.bin";
+    // Имя файла журнала изменений в директории данных
+    static constexpr const char* JOURNAL_FILE_NAME = "journal.log";
+
+    // Сохранить изменения: если все изменения записаны в журнал, журнал только сбрасывается
+    // на диск; иначе (изменения в обход команд, журнал не открыт или пора сжимать) - запись
+    // измененных файлов. Печатает сообщения сохранения; true, если все изменения сохранены
+    bool saveChanges(TransportSystem& system);
+
+    // То же в фоне (см. saveAllDataAsync); сброс журнала выполняется сразу, и тогда
+    // возвращается уже готовый результат
+    std::shared_future<SaveResult> saveChangesAsync(TransportSystem& system,
+                                                    std::function<void(const SaveResult&)> onComplete = nullptr);
+
+    // Сохранить данные транспортной системы в файлы (текстовые и снимок)
+    // Записываются только измененные файлы (и отсутствующие на диске), каждый - во временный
+    // файл с заменой переименованием. После успешной записи журнал сжимается.
+    // Возвращает false при ошибках записи; незаписанные файлы остаются измененными
+    bool saveAllData(TransportSystem& system);
+
+    // Сохранить данные в фоне: копия состояния (SystemState) снимается в вызывающем потоке,
+    // файлы пишет отдельный поток, а система тем временем может изменяться. Результат -
+    // через future и onComplete (вызывается в потоке записи). Новое сохранение сначала
+    // дожидается предыдущего. Сообщения не печатаются, а передаются в SaveResult
+    std::shared_future<SaveResult> saveAllDataAsync(TransportSystem& system,
+                                                    std::function<void(const SaveResult&)> onComplete = nullptr);
+
+    // Идет фоновое сохранение
+    bool isSaving() const;
+
+    // Дождаться окончания фонового сохранения (если оно идет)
+    void waitForSave();
+
+    // Есть изменения, которые еще не записаны ни в файлы, ни в журнал на диске
+    bool hasUnsavedChanges() const;
+
+    CommandJournal& getJournal();
+
+    // Изменение внесено в обход команд и журнала: следующее сохранение запишет файлы
+    void markUnjournaled();
+
+    // Отметить файл как измененный (вместе с ним - снимок); DataFile::Count игнорируется
+    void markDirty(DataFile file);
+    bool isDirty(DataFile file) const;
+
+    // Файл транспорта и файл рейсов для вида транспорта ("Автобус", ...);
+    // DataFile::Count для неизвестного вида
+    static DataFile getVehicleFile(const std::string& vehicleType);
+    static DataFile getTripFile(const std::string& vehicleType);
+
+    // Имя файла в директории данных
+    static const char* getFileName(DataFile file);
+
+    // Создать транспортное средство из строки файла транспорта (тип|модель|номер|...)
+    // Выбрасывает InputException для неизвестного типа
+    static std::shared_ptr<Vehicle> parseVehicle(std::string_view line);
+
+    // Открыть снимок в режиме только для чтения: файл отображается в память, объекты
+    // системы не создаются (см. MappedDataset). Снимок должен быть записан saveAllData.
+    // Реплика (main --replica) открывает его с verify = false, чтобы не читать файл целиком
+    std::unique_ptr<MappedDataset> openMappedDataset(bool verify = true) const;
 
     // Загрузить все данные транспортной системы из файлов
+    // Сначала пробует двоичный снимок, при его отсутствии или повреждении - текстовые файлы
     void loadAllData(TransportSystem& system);
 
 private:
-    // Методы сохранения отдельных типов данных
-    void saveStops(TransportSystem& system);
-    void saveVehicles(TransportSystem& system);
-    void saveDrivers(TransportSystem& system);
-    void saveRoutes(TransportSystem& system);
-    void saveTrips(TransportSystem& system);
-    void saveAdminCredentials(TransportSystem& system);
+    // Начать сохранение измененных файлов; messages - сообщения, предшествующие сохранению
+    std::shared_future<SaveResult> startSave(TransportSystem& system, std::string messages,
+                                             std::function<void(const SaveResult&)> onComplete);
+
+    // Записать файлы задания (выполняется в потоке записи, сообщения - в task.log); false при ошибках
+    bool writeTask(SaveTask& task);
+
+    // Записать содержимое файла данных через временный файл и переименование,
+    // чтобы при сбое на диске оставалась старая или новая версия файла целиком
+    void writeDataFile(SaveTask& task, DataFile file, const std::string& content);
+
+    // Методы сохранения отдельных типов данных (только файлы задания)
+    void saveStops(SaveTask& task);
+    void saveVehicles(SaveTask& task);
+    void saveDrivers(SaveTask& task);
+    void saveRoutes(SaveTask& task);
+    void saveTrips(SaveTask& task);
+    void saveAdminCredentials(SaveTask& task);
+
+    // Загрузить двоичный снимок, если он есть, цел и не старше текстовых файлов
+    bool loadSnapshot(TransportSystem& system, const List<std::string>& textFiles);
+
+    // Воспроизвести журнал поверх загруженных данных и открыть его для дописывания
+    void replayJournal(TransportSystem& system);
 
     // Методы загрузки отдельных типов данных
     void loadStops(TransportSystem& system);
@@ -45,7 +182,9 @@ private:
     
     // Вспомогательные методы для загрузки данных из файлов
     int loadVehiclesFromFile(std::ifstream& file, TransportSystem& system, const std::string& fileName);
-    int loadTripsFromFile(std::ifstream& file, TransportSystem& system, const std::string& fileName);
+    // Загрузить рейсы из файлов (одновременно, частями на общем пуле потоков);
+    // возвращает количество добавленных рейсов
+    int loadTripFiles(TransportSystem& system, const List<std::string>& fileNames);
 };
 
 #endif // DATA_MANAGER_H
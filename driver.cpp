@@ -1,5 +1,5 @@
 #include "driver.h"
-#include <sstream>
+#include "record_parser.h"
 
 // Конструктор водителя: инициализирует ФИО и категорию водительских прав
 Driver::Driver(const std::string& fname, const std::string& lname, const std::string& mname, const std::string& cat)
@@ -48,14 +48,14 @@ std::string Driver::serialize() const {
 }
 
 // Десериализация водителя из строки формата "firstName|lastName|middleName|category"
-std::shared_ptr<Driver> Driver::deserialize(const std::string& data) {
-    std::istringstream ss(data);
-    std::string firstName, lastName, middleName, category;
-    std::getline(ss, firstName, '|');   // Читаем имя
-    std::getline(ss, lastName, '|');    // Читаем фамилию
-    std::getline(ss, middleName, '|');  // Читаем отчество
-    std::getline(ss, category);         // Читаем категорию
+std::shared_ptr<Driver> Driver::deserialize(std::string_view data) {
+    FieldSplitter fields(data, '|');
+    std::string_view firstName = fields.next();   // Имя
+    std::string_view lastName = fields.next();    // Фамилия
+    std::string_view middleName = fields.next();  // Отчество
+    std::string_view category = fields.remainder();  // Категория
     // Если категория не указана в старых данных, оставляем пустой строкой
-    return std::make_shared<Driver>(firstName, lastName, middleName, category);
+    return std::make_shared<Driver>(std::string(firstName), std::string(lastName),
+                                    std::string(middleName), std::string(category));
 }
 
@@ -2,6 +2,7 @@
 #define DRIVER_H
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <sstream>
 
@@ -38,7 +39,7 @@ public:
     std::string serialize() const;
 
     // Десериализация водителя из строки формата "firstName|lastName|middleName|category"
-    static std::shared_ptr<Driver> deserialize(const std::string& data);
+    static std::shared_ptr<Driver> deserialize(std::string_view data);
 };
 
 #endif // DRIVER_H
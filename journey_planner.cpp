@@ -1,20 +1,54 @@
 #include "journey_planner.h"
 #include "transport_system.h"
-#include <queue>
 #include <algorithm>
-#include <set>
+#include <memory_resource>
 #include "exceptions.h"
+#include "query_context.h"
 
 // Конструктор планировщика поездок
 // Инициализирует планировщик и создает алгоритмы поиска маршрутов:
 // BFS для поиска всех маршрутов с пересадками,
 // FastestPath для поиска самого быстрого маршрута,
-// MinimalTransfers для поиска маршрута с минимальными пересадками
+// MinimalTransfers для поиска маршрута с минимальными пересадками,
+// GoalDirected для направленного к цели поиска самого быстрого маршрута,
+// ConnectionScan для поиска самого раннего прибытия сканированием соединений,
+// EarliestArrival и FewestTransfers - специализированные поиски по раундам
 JourneyPlanner::JourneyPlanner(TransportSystem* sys) 
     : system(sys),
       bfsAlgorithm(std::make_unique<BFSAlgorithm>(sys, 2)),
       fastestAlgorithm(std::make_unique<FastestPathAlgorithm>(sys)),
-      minimalTransfersAlgorithm(std::make_unique<MinimalTransfersAlgorithm>(sys)) {}
+      minimalTransfersAlgorithm(std::make_unique<MinimalTransfersAlgorithm>(sys)),
+      goalDirectedAlgorithm(std::make_unique<GoalDirectedFastestPathAlgorithm>(sys, 2)),
+      connectionScanAlgorithm(std::make_unique<ConnectionScanAlgorithm>(sys)),
+      earliestArrivalAlgorithm(std::make_unique<PolicyPathFindingAlgorithm<EarliestArrivalPlanner>>(sys)),
+      fewestTransfersAlgorithm(std::make_unique<PolicyPathFindingAlgorithm<FewestTransfersPlanner>>(sys)) {}
+
+// Возвращает индекс сети, соответствующий текущей версии расписания
+// Индекс возвращается через shared_ptr: запрос продолжает пользоваться своим экземпляром,
+// даже если во время его выполнения индекс будет перестроен
+std::shared_ptr<const TimetableIndex> JourneyPlanner::getTimetableIndex() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (!timetableIndex || timetableIndex->getVersion() != system->getTimetableVersion()) {
+        timetableIndex = std::make_shared<const TimetableIndex>(*system);
+    }
+    return timetableIndex;
+}
+
+std::shared_ptr<const TimetableIndex> JourneyPlanner::findCurrentTimetableIndex() const {
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (timetableIndex && timetableIndex->getVersion() == system->getTimetableVersion()) {
+        return timetableIndex;
+    }
+    return nullptr;
+}
+
+void JourneyPlanner::setSearchThreads(size_t threads) {
+    searchThreads = threads;
+}
+
+size_t JourneyPlanner::getSearchThreads() const {
+    return searchThreads;
+}
 
 // Поиск маршрутов с пересадками с заданным временем отправления
 // Использует алгоритм BFS для поиска всех возможных маршрутов
@@ -27,70 +61,139 @@ List<Journey> JourneyPlanner::findJourneysWithTransfers(
 
     // Используем алгоритм BFS (создаем временный объект для const метода)
     BFSAlgorithm bfs(const_cast<TransportSystem*>(system), maxTransfers);
+    bfs.setThreadCount(searchThreads);
     return bfs.findPath(startStop, endStop, departureTime);
 }
 
+// Поиск маршрутов с пересадками с ограничениями запроса
+// При срабатывании ограничений возвращает маршруты, найденные до прерывания, и флаг truncated
+QueryResult JourneyPlanner::findJourneysWithTransfers(
+    const std::string& startStop,
+    const std::string& endStop,
+    const Time& departureTime,
+    int maxTransfers,
+    const QueryOptions& options) const {
+
+    BFSAlgorithm bfs(const_cast<TransportSystem*>(system), maxTransfers);
+    bfs.setThreadCount(searchThreads);
+    bfs.setQueryOptions(options);
+
+    QueryResult result;
+    result.journeys = bfs.findPath(startStop, endStop, departureTime);
+    result.truncated = bfs.wasTruncated();
+    return result;
+}
+
+// Поиск k лучших маршрутов с заданным временем отправления
+// Использует режим top-K алгоритма BFS: память и время зависят от k,
+// а не от количества всех допустимых маршрутов
+List<Journey> JourneyPlanner::findTopJourneys(
+    const std::string& startStop,
+    const std::string& endStop,
+    const Time& departureTime,
+    size_t k,
+    JourneyCriterion criterion,
+    int maxTransfers) const {
+
+    BFSAlgorithm bfs(const_cast<TransportSystem*>(system), maxTransfers);
+    bfs.setThreadCount(searchThreads);
+    return bfs.findTopK(startStop, endStop, departureTime, k, criterion);
+}
+
+// Поиск k лучших маршрутов с ограничениями запроса
+QueryResult JourneyPlanner::findTopJourneys(
+    const std::string& startStop,
+    const std::string& endStop,
+    const Time& departureTime,
+    size_t k,
+    JourneyCriterion criterion,
+    int maxTransfers,
+    const QueryOptions& options) const {
+
+    BFSAlgorithm bfs(const_cast<TransportSystem*>(system), maxTransfers);
+    bfs.setThreadCount(searchThreads);
+    bfs.setQueryOptions(options);
+
+    QueryResult result;
+    result.journeys = bfs.findTopK(startStop, endStop, departureTime, k, criterion);
+    result.truncated = bfs.wasTruncated();
+    return result;
+}
+
 // Поиск всех возможных маршрутов между остановками (без привязки ко времени)
-// Находит все возможные маршруты между остановками, начиная с любого рейса,
-// проходящего через начальную остановку. Использует BFS с ограничением итераций
-// для предотвращения зависания
+// Использует бюджет узлов по умолчанию для предотвращения зависания
 List<Journey> JourneyPlanner::findAllJourneysWithTransfers(
     const std::string& startStop,
     const std::string& endStop,
     int maxTransfers) const {
 
+    QueryOptions options;
+    options.maxLabels = MAX_ALL_JOURNEYS_LABELS;
+    return findAllJourneysWithTransfers(startStop, endStop, maxTransfers, options).journeys;
+}
+
+// Поиск всех возможных маршрутов между остановками (без привязки ко времени)
+// Находит все возможные маршруты между остановками, начиная с любого рейса,
+// проходящего через начальную остановку. Использует BFS, ограниченный
+// параметрами запроса (бюджет узлов, крайний срок, отмена)
+QueryResult JourneyPlanner::findAllJourneysWithTransfers(
+    const std::string& startStop,
+    const std::string& endStop,
+    int maxTransfers,
+    const QueryOptions& options) const {
+
     List<Journey> journeys;
 
-    // Узел поиска: содержит текущую остановку, время, пройденный путь и пересадки
+    auto index = getTimetableIndex();
+    int start = index->getStopIndex(startStop);
+    int end = index->getStopIndex(endStop);
+
+    // Узел поиска: текущая остановка, время и ссылка на родительский узел
+    // Путь не копируется в каждый узел, а восстанавливается по родителям для найденных маршрутов
     struct SearchNode {
-        std::string currentStop;              // Текущая остановка
-        Time currentTime;                     // Текущее время
-        Time startTime;                       // Время начала поездки
-        List<std::shared_ptr<Trip>> pathTrips; // Рейсы, использованные в пути
-        List<std::string> transferPoints;     // Остановки, где были пересадки
-        int transfers;                        // Количество пересадок
+        int stop;        // Номер текущей остановки
+        int time;        // Текущее время (минуты от начала суток)
+        int startTime;   // Время начала поездки
+        int trip;        // Номер рейса последнего участка (-1 для начального узла)
+        int parent;      // Номер родительского узла (-1 для начального узла)
+        int transfers;   // Количество пересадок
     };
 
-    // Получаем все рейсы, проходящие через начальную остановку
-    auto initialTrips = system->getTripsThroughStop(startStop);
-
-    // Фильтруем только рейсы с рассчитанным временем прибытия
-    List<std::shared_ptr<Trip>> validInitialTrips;
-    for (const auto& trip : initialTrips) {
-        if (trip->hasStop(startStop)) {
-            validInitialTrips.push_back(trip);
+    // Отслеживаем уже посещенные комбинации (остановка + количество пересадок),
+    // чтобы избежать бесконечных циклов. Метки хранятся в контексте потока:
+    // номер метки = номер остановки * transferLayers + количество пересадок
+    size_t transferLayers = static_cast<size_t>(std::max(maxTransfers, 1));
+    QueryContextLease context;
+    context->beginQuery(index->getStopCount() * transferLayers, index->getStopCount(), 0);
+    std::pmr::memory_resource* arena = &context->arena;
+
+    // Все созданные узлы в порядке BFS (массив служит и очередью) и узлы найденных маршрутов
+    std::pmr::vector<SearchNode> nodes(arena);
+    std::pmr::vector<int> found(arena);
+    nodes.reserve(1024);
+
+    // Добавляем начальные узлы для каждого рейса через начальную остановку
+    // (рейсы с рассчитанным временем прибытия, по возрастанию времени прибытия)
+    if (start >= 0) {
+        for (const auto& visit : index->getStopVisits(start)) {
+            nodes.push_back({start, visit.time, visit.time, -1, -1, 0});
         }
+        std::stable_sort(nodes.begin(), nodes.end(), [](const SearchNode& a, const SearchNode& b) {
+            return a.time < b.time;
+        });
     }
 
-    // Сортируем рейсы по времени прибытия на начальную остановку
-    validInitialTrips.sort([&startStop](const auto& a, const auto& b) {
-        return a->getArrivalTime(startStop) < b->getArrivalTime(startStop);
-    });
-
-    std::queue<SearchNode> q;
-    // Используем set для отслеживания уже посещенных комбинаций (остановка + количество пересадок)
-    // чтобы избежать бесконечных циклов
-    std::set<std::pair<std::string, int>> visited;
-    // Ограничение на количество итераций для предотвращения зависания
-    const int MAX_ITERATIONS = 10000;
-    int iterations = 0;
-
-    // Добавляем в очередь начальные узлы для каждого рейса через начальную остановку
-    for (const auto& trip : validInitialTrips) {
-        Time arrivalAtStart = trip->getArrivalTime(startStop);
-        q.push({startStop, arrivalAtStart, arrivalAtStart, {}, {}, 0});
-    }
+    // Контроль ограничений запроса (заменяет фиксированное ограничение итераций)
+    QueryGuard guard(options);
 
     // Основной цикл поиска в ширину
-    while (!q.empty() && iterations < MAX_ITERATIONS) {
-        iterations++;
-        auto node = q.front();
-        q.pop();
-
-        // Если достигли конечной остановки - сохраняем найденный маршрут
-        if (node.currentStop == endStop) {
-            journeys.push_back(Journey(node.pathTrips, node.transferPoints,
-                                 node.startTime, node.currentTime));
+    for (size_t head = 0; head < nodes.size() && guard.step(); ++head) {
+        // Копия узла: массив может перераспределиться при добавлении потомков
+        const SearchNode node = nodes[head];
+
+        // Если достигли конечной остановки - запоминаем найденный маршрут
+        if (node.stop == end) {
+            found.push_back(static_cast<int>(head));
             continue;
         }
 
@@ -101,71 +204,71 @@ List<Journey> JourneyPlanner::findAllJourneysWithTransfers(
 
         // Проверяем, не посещали ли мы уже эту остановку с таким же количеством пересадок
         // Это предотвращает бесконечные циклы
-        auto visitKey = std::make_pair(node.currentStop, node.transfers);
-        if (visited.find(visitKey) != visited.end()) {
+        size_t visitKey = static_cast<size_t>(node.stop) * transferLayers + node.transfers;
+        if (context->labels.isSet(visitKey)) {
             continue;
         }
-        visited.insert(visitKey);
-
-        // Получаем все рейсы, проходящие через текущую остановку
-        auto trips = system->getTripsThroughStop(node.currentStop);
-
-        for (const auto& trip : trips) {
-            // Проверяем, что время прибытия рассчитано для текущей остановки
-            if (!trip->hasStop(node.currentStop)) {
-                continue;
-            }
-
-            Time arrivalAtStop = trip->getArrivalTime(node.currentStop);
+        context->labels.set(visitKey, 1);
 
+        // Перебираем все рейсы, проходящие через текущую остановку
+        for (const auto& visit : index->getStopVisits(node.stop)) {
             // Для промежуточных остановок пропускаем рейсы, которые уже прошли
-            if (node.currentStop != startStop && arrivalAtStop < node.currentTime) {
+            if (node.stop != start && visit.time < node.time) {
                 continue;
             }
 
             // Проверяем, что мы не используем тот же рейс дважды подряд
-            if (!node.pathTrips.empty() && node.pathTrips.back() == trip) {
+            if (node.trip >= 0 && index->getTrip(node.trip) == index->getTrip(visit.trip)) {
                 continue;
             }
 
-            // Получаем список остановок маршрута и позицию текущей остановки
-            const auto& routeStops = trip->getRoute()->getAllStops();
-            int currentPos = trip->getRoute()->getStopPosition(node.currentStop);
+            if (visit.position == -1) continue;  // Остановка не найдена в маршруте
 
-            if (currentPos == -1) continue;  // Остановка не найдена в маршруте
+            // Для первого рейса время начала поездки - время посадки на него
+            int startTime = node.trip >= 0 ? node.startTime : visit.time;
+            // Пересадка считается только если мы переходим на другой рейс
+            int transfers = node.transfers + (node.trip >= 0 ? 1 : 0);
 
             // Проверяем все последующие остановки на этом маршруте
-            for (int i = currentPos + 1; i < routeStops.size(); ++i) {
-                std::string nextStop = routeStops[i];
-
+            auto tripStops = index->getTripStops(visit.trip);
+            auto tripTimes = index->getTripTimes(visit.trip);
+            for (size_t i = visit.position + 1; i < tripStops.size(); ++i) {
                 // Проверяем, что время прибытия рассчитано для следующей остановки
-                if (!trip->hasStop(nextStop)) {
+                if (tripTimes[i] == TimetableIndex::NO_TIME) {
                     continue;
                 }
 
-                Time arrivalAtNext = trip->getArrivalTime(nextStop);
-
-                // Создаем новый узел для следующей остановки
-                SearchNode nextNode = node;
-                nextNode.currentStop = nextStop;
-                nextNode.currentTime = arrivalAtNext;
-                nextNode.pathTrips.push_back(trip);
-
-                // Для первого рейса устанавливаем время начала поездки
-                if (nextNode.pathTrips.size() == 1) {
-                    nextNode.startTime = arrivalAtStop;
+                // Выходить имеет смысл только на конечной остановке или в пересадочном узле
+                if (tripStops[i] != end && !index->isInterchange(tripStops[i])) {
+                    continue;
                 }
 
-                // Пересадка считается только если мы переходим на другой рейс
-                if (!node.pathTrips.empty() && node.pathTrips.back() != trip) {
-                    nextNode.transferPoints.push_back(node.currentStop);
-                    nextNode.transfers++;
-                }
+                nodes.push_back({tripStops[i], tripTimes[i], startTime, visit.trip,
+                                 static_cast<int>(head), transfers});
+            }
+        }
+    }
+
+    // Восстанавливаем найденные маршруты по ссылкам на родителей
+    std::pmr::vector<int> chain(arena);
+    for (int last : found) {
+        chain.clear();
+        for (int n = last; nodes[n].parent >= 0; n = nodes[n].parent) {
+            chain.push_back(n);
+        }
 
-                // Добавляем новый узел в очередь для дальнейшего поиска
-                q.push(nextNode);
+        List<std::shared_ptr<Trip>> pathTrips;
+        List<std::string> transferPoints;
+        for (auto step = chain.rbegin(); step != chain.rend(); ++step) {
+            const SearchNode& legEnd = nodes[*step];
+            const SearchNode& legStart = nodes[legEnd.parent];
+            pathTrips.push_back(index->getTrip(legEnd.trip));
+            if (legStart.trip >= 0) {
+                transferPoints.push_back(index->getStopName(legStart.stop));
             }
         }
+        journeys.push_back(Journey(pathTrips, transferPoints,
+                                   Time(0, nodes[last].startTime), Time(0, nodes[last].time)));
     }
 
     // Сортируем найденные маршруты: сначала по времени отправления, затем по длительности
@@ -176,7 +279,77 @@ List<Journey> JourneyPlanner::findAllJourneysWithTransfers(
         return a.getTotalDuration() < b.getTotalDuration();
     });
 
-    return journeys;
+    QueryResult result;
+    result.journeys = journeys;
+    result.truncated = guard.isTruncated();
+    return result;
+}
+
+// Возвращает дерево прибытий для запроса
+// Хранится одно последнее дерево: типичный сценарий - та же начальная остановка
+// и меняющаяся конечная. Дерево сравнивается с текущей версией расписания,
+// поэтому любое изменение маршрутов, рейсов или остановок делает его недействительным
+template<typename Origin>
+std::shared_ptr<const JourneyTree> JourneyPlanner::getCachedJourneyTree(const Origin& origin,
+                                                                        const Time& departureTime,
+                                                                        int weekDay,
+                                                                        int maxTransfers) const {
+    {
+        std::lock_guard<std::mutex> lock(treeMutex);
+        if (lastJourneyTree && lastJourneyTree->matches(origin, departureTime, weekDay, maxTransfers,
+                                                        system->getTimetableVersion())) {
+            return lastJourneyTree;
+        }
+    }
+
+    // Дерево строится без блокировки, чтобы не задерживать запросы других потоков
+    auto tree = std::make_shared<const JourneyTree>(getTimetableIndex(), origin, departureTime,
+                                                    weekDay, maxTransfers, searchThreads);
+    std::lock_guard<std::mutex> lock(treeMutex);
+    lastJourneyTree = tree;
+    return tree;
+}
+
+std::shared_ptr<const JourneyTree> JourneyPlanner::getJourneyTree(const std::string& startStop,
+                                                                  const Time& departureTime,
+                                                                  int weekDay,
+                                                                  int maxTransfers) const {
+    return getCachedJourneyTree(startStop, departureTime, weekDay, maxTransfers);
+}
+
+std::shared_ptr<const JourneyTree> JourneyPlanner::getJourneyTree(const List<StopPenalty>& startStops,
+                                                                  const Time& departureTime,
+                                                                  int weekDay,
+                                                                  int maxTransfers) const {
+    return getCachedJourneyTree(startStops, departureTime, weekDay, maxTransfers);
+}
+
+Journey JourneyPlanner::findEarliestJourney(const std::string& startStop,
+                                           const std::string& endStop,
+                                           const Time& departureTime,
+                                           int weekDay,
+                                           int maxTransfers) const {
+    auto journeys = getJourneyTree(startStop, departureTime, weekDay, maxTransfers)->extractJourney(endStop);
+
+    if (journeys.empty()) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    return journeys[0];
+}
+
+GroupJourney JourneyPlanner::findEarliestJourney(const List<StopPenalty>& startStops,
+                                                const List<StopPenalty>& endStops,
+                                                const Time& departureTime,
+                                                int weekDay,
+                                                int maxTransfers) const {
+    auto journeys = getJourneyTree(startStops, departureTime, weekDay, maxTransfers)->extractJourney(endStops);
+
+    if (journeys.empty()) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    return journeys[0];
 }
 
 Journey JourneyPlanner::findFastestJourney(const std::string& startStop,
@@ -191,6 +364,67 @@ Journey JourneyPlanner::findFastestJourney(const std::string& startStop,
     return journeys[0];
 }
 
+Journey JourneyPlanner::findFastestJourneyGoalDirected(const std::string& startStop,
+                                                      const std::string& endStop,
+                                                      const Time& departureTime) {
+    auto journeys = goalDirectedAlgorithm->findPath(startStop, endStop, departureTime);
+
+    if (journeys.empty()) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    return journeys[0];
+}
+
+Journey JourneyPlanner::findEarliestJourneyConnectionScan(const std::string& startStop,
+                                                         const std::string& endStop,
+                                                         const Time& departureTime,
+                                                         int weekDay) {
+    connectionScanAlgorithm->setWeekDay(weekDay);
+    auto journeys = connectionScanAlgorithm->findPath(startStop, endStop, departureTime);
+
+    if (journeys.empty()) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    return journeys[0];
+}
+
+List<Journey> JourneyPlanner::findJourneyProfile(const std::string& startStop,
+                                                 const std::string& endStop,
+                                                 const Time& windowStart,
+                                                 const Time& windowEnd,
+                                                 int weekDay) {
+    connectionScanAlgorithm->setWeekDay(weekDay);
+    return connectionScanAlgorithm->findProfile(startStop, endStop, windowStart, windowEnd);
+}
+
+// Выбор конфигурации - единственное ветвление времени выполнения; ядра специализированы
+Journey JourneyPlanner::findJourneyByCriterion(const std::string& startStop,
+                                               const std::string& endStop,
+                                               const Time& departureTime,
+                                               JourneyCriterion criterion,
+                                               int weekDay) {
+    List<Journey> journeys;
+    if (criterion == JourneyCriterion::Transfers) {
+        fewestTransfersAlgorithm->setWeekDay(weekDay);
+        journeys = fewestTransfersAlgorithm->findPath(startStop, endStop, departureTime);
+    } else {
+        earliestArrivalAlgorithm->setWeekDay(weekDay);
+        journeys = earliestArrivalAlgorithm->findPath(startStop, endStop, departureTime);
+    }
+
+    if (journeys.empty()) {
+        throw ContainerException("Маршрут не найден");
+    }
+
+    return journeys[0];
+}
+
+ReachabilityAnalysis JourneyPlanner::analyzeReachability(int maxTransfers) const {
+    return ReachabilityAnalysis(getTimetableIndex(), maxTransfers, searchThreads);
+}
+
 Journey JourneyPlanner::findJourneyWithLeastTransfers(const std::string& startStop,
                                                      const std::string& endStop,
                                                      const Time& departureTime) {
@@ -3,10 +3,16 @@
 
 #include <string>
 #include <memory>
+#include <mutex>
 #include "list.h"
 #include "journey.h"
 #include "time.h"
 #include "algorithm.h"
+#include "query_options.h"
+#include "timetable_index.h"
+#include "journey_tree.h"
+#include "reachability_analysis.h"
+#include "policy_planner.h"
 
 class TransportSystem;
 
@@ -19,23 +25,151 @@ private:
     std::unique_ptr<BFSAlgorithm> bfsAlgorithm;
     std::unique_ptr<FastestPathAlgorithm> fastestAlgorithm;
     std::unique_ptr<MinimalTransfersAlgorithm> minimalTransfersAlgorithm;
+    std::unique_ptr<GoalDirectedFastestPathAlgorithm> goalDirectedAlgorithm;
+    std::unique_ptr<ConnectionScanAlgorithm> connectionScanAlgorithm;
+    std::unique_ptr<PolicyPathFindingAlgorithm<EarliestArrivalPlanner>> earliestArrivalAlgorithm;
+    std::unique_ptr<PolicyPathFindingAlgorithm<FewestTransfersPlanner>> fewestTransfersAlgorithm;
+
+    // Количество потоков для поиска BFS и построения дерева прибытий (1 - последовательно, 0 - все ядра)
+    size_t searchThreads = 1;
+
+    // Бюджет узлов по умолчанию для поиска без привязки ко времени
+    static const size_t MAX_ALL_JOURNEYS_LABELS = 10000;
+
+    // Индекс сети, перестраиваемый при изменении версии расписания
+    mutable std::shared_ptr<const TimetableIndex> timetableIndex;
+    mutable std::mutex indexMutex;
+
+    // Последнее построенное дерево прибытий: запросы из той же остановки с тем же временем
+    // и днем недели отвечаются по нему без нового поиска (устаревает вместе с индексом)
+    mutable std::shared_ptr<const JourneyTree> lastJourneyTree;
+    mutable std::mutex treeMutex;
+
+    // Взять дерево из кэша или построить новое (origin - остановка или группа остановок)
+    template<typename Origin>
+    std::shared_ptr<const JourneyTree> getCachedJourneyTree(const Origin& origin,
+                                                            const Time& departureTime,
+                                                            int weekDay,
+                                                            int maxTransfers) const;
 
 public:
     JourneyPlanner(TransportSystem* sys);
 
+    // Получить актуальный индекс сети (строится при первом обращении и после изменений расписания)
+    std::shared_ptr<const TimetableIndex> getTimetableIndex() const;
+
+    // Уже построенный индекс, если он соответствует текущей версии расписания; иначе nullptr
+    // (в отличие от getTimetableIndex индекс не перестраивается)
+    std::shared_ptr<const TimetableIndex> findCurrentTimetableIndex() const;
+
+    // Количество потоков для поиска маршрутов с пересадками, раундов дерева прибытий
+    // (параллельный просмотр шаблонов маршрутов) и анализа достижимости
+    // По умолчанию 1; консольное и оконное приложения включают все ядра (0) при запуске
+    void setSearchThreads(size_t threads);
+    size_t getSearchThreads() const;
+
     List<Journey> findJourneysWithTransfers(const std::string& startStop,
                                                    const std::string& endStop,
                                                    const Time& departureTime,
                                                    int maxTransfers = 2) const;
 
+    // Поиск маршрутов с пересадками с ограничениями запроса (крайний срок, бюджет, отмена)
+    QueryResult findJourneysWithTransfers(const std::string& startStop,
+                                          const std::string& endStop,
+                                          const Time& departureTime,
+                                          int maxTransfers,
+                                          const QueryOptions& options) const;
+
+    // Поиск не более k лучших маршрутов по заданному критерию
+    List<Journey> findTopJourneys(const std::string& startStop,
+                                  const std::string& endStop,
+                                  const Time& departureTime,
+                                  size_t k,
+                                  JourneyCriterion criterion = JourneyCriterion::Duration,
+                                  int maxTransfers = 2) const;
+
+    QueryResult findTopJourneys(const std::string& startStop,
+                                const std::string& endStop,
+                                const Time& departureTime,
+                                size_t k,
+                                JourneyCriterion criterion,
+                                int maxTransfers,
+                                const QueryOptions& options) const;
+
     List<Journey> findAllJourneysWithTransfers(const std::string& startStop,
                                                       const std::string& endStop,
                                                       int maxTransfers = 2) const;
 
+    QueryResult findAllJourneysWithTransfers(const std::string& startStop,
+                                             const std::string& endStop,
+                                             int maxTransfers,
+                                             const QueryOptions& options) const;
+
+    // Получить дерево самых ранних прибытий из остановки (из кэша или построив заново)
+    std::shared_ptr<const JourneyTree> getJourneyTree(const std::string& startStop,
+                                                      const Time& departureTime,
+                                                      int weekDay = 0,
+                                                      int maxTransfers = 2) const;
+
+    // Маршрут с самым ранним прибытием (weekDay = 0 - рейсы всех дней недели)
+    // Повторные запросы из той же остановки используют сохраненное дерево прибытий
+    Journey findEarliestJourney(const std::string& startStop,
+                                const std::string& endStop,
+                                const Time& departureTime,
+                                int weekDay = 0,
+                                int maxTransfers = 2) const;
+
     Journey findFastestJourney(const std::string& startStop,
                                const std::string& endStop,
                                const Time& departureTime);
 
+    // Дерево прибытий из группы начальных остановок с временем доступа к каждой
+    std::shared_ptr<const JourneyTree> getJourneyTree(const List<StopPenalty>& startStops,
+                                                      const Time& departureTime,
+                                                      int weekDay = 0,
+                                                      int maxTransfers = 2) const;
+
+    // Маршрут с самым ранним прибытием между группами остановок
+    // Подходит любая начальная и любая конечная остановка группы; время доступа и выхода
+    // добавляется к времени поездки. Все варианты решаются одним поиском, а не N x M запросами
+    GroupJourney findEarliestJourney(const List<StopPenalty>& startStops,
+                                     const List<StopPenalty>& endStops,
+                                     const Time& departureTime,
+                                     int weekDay = 0,
+                                     int maxTransfers = 2) const;
+
+    // Самый быстрый маршрут с поиском, направленным к цели (нижние оценки времени до цели)
+    Journey findFastestJourneyGoalDirected(const std::string& startStop,
+                                           const std::string& endStop,
+                                           const Time& departureTime);
+
+    // Маршрут с самым ранним прибытием, найденный сканированием соединений (без ограничения пересадок)
+    Journey findEarliestJourneyConnectionScan(const std::string& startStop,
+                                              const std::string& endStop,
+                                              const Time& departureTime,
+                                              int weekDay = 0);
+
+    // Профиль маршрутов за окно отправлений (для всего дня - от 00:00 до 23:59):
+    // для каждого отправления из начальной остановки - самое раннее прибытие,
+    // без маршрутов, с которыми можно выехать позже и приехать не позже
+    List<Journey> findJourneyProfile(const std::string& startStop,
+                                     const std::string& endStop,
+                                     const Time& windowStart,
+                                     const Time& windowEnd,
+                                     int weekDay = 0);
+
+    // Маршрут по критерию, найденный специализированным поиском по раундам (не более 2 пересадок)
+    // Duration - самое раннее прибытие (при равенстве меньше пересадок),
+    // Transfers - наименьшее число пересадок (при равенстве самое раннее прибытие)
+    Journey findJourneyByCriterion(const std::string& startStop,
+                                   const std::string& endStop,
+                                   const Time& departureTime,
+                                   JourneyCriterion criterion,
+                                   int weekDay = 0);
+
+    // Таблица достижимости всех остановок из всех с не более чем maxTransfers пересадками
+    ReachabilityAnalysis analyzeReachability(int maxTransfers = 2) const;
+
     Journey findJourneyWithLeastTransfers(const std::string& startStop,
                                           const std::string& endStop,
                                           const Time& departureTime);
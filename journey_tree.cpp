@@ -0,0 +1,194 @@
+#include "journey_tree.h"
+#include "exceptions.h"
+#include "round_executor.h"
+#include <algorithm>
+
+JourneyTree::JourneyTree(std::shared_ptr<const TimetableIndex> timetableIndex,
+                         const std::string& originName,
+                         const Time& departureTime,
+                         int weekDayFilter,
+                         int transfersLimit,
+                         size_t threads)
+    : index(std::move(timetableIndex)),
+      origins{{originName, 0}},
+      departure(departureTime.getTotalMinutes()),
+      weekDay(weekDayFilter),
+      maxTransfers(std::max(transfersLimit, 0)),
+      stopCount(index->getStopCount()) {
+    build(threads);
+}
+
+JourneyTree::JourneyTree(std::shared_ptr<const TimetableIndex> timetableIndex,
+                         const List<StopPenalty>& originStops,
+                         const Time& departureTime,
+                         int weekDayFilter,
+                         int transfersLimit,
+                         size_t threads)
+    : index(std::move(timetableIndex)),
+      departure(departureTime.getTotalMinutes()),
+      weekDay(weekDayFilter),
+      maxTransfers(std::max(transfersLimit, 0)),
+      stopCount(index->getStopCount()) {
+    for (const auto& origin : originStops) {
+        origins.emplace_back(origin.stop, std::max(origin.penalty, 0));
+    }
+    build(threads);
+}
+
+// Построение дерева по раундам
+// Раунд 0 содержит только начальные остановки; раунды 1..maxTransfers+1 выполняет
+// RoundExecutor, просматривая шаблоны маршрутов. Метка остановки в раунде записывается,
+// только если прибытие строго раньше, чем во всех предыдущих раундах, поэтому при
+// равном времени прибытия остается вариант с меньшим числом пересадок.
+// Все начальные остановки группы обрабатываются одним поиском
+void JourneyTree::build(size_t threads) {
+    int rounds = maxTransfers + 2;   // Раунд 0 и до maxTransfers + 1 рейсов
+    labels.assign(static_cast<size_t>(rounds) * stopCount, Label{});
+
+    // Раунд 0: начальные остановки (при повторе остановки в группе - с лучшим временем)
+    std::vector<int> startStops;
+    for (const auto& [name, penalty] : origins) {
+        int stop = index->getStopIndex(name);
+        if (stop < 0) {
+            continue;
+        }
+        int ready = departure + penalty;
+        Label& label = labels[static_cast<size_t>(stop)];
+        if (label.arrival == NO_ARRIVAL) {
+            startStops.push_back(stop);
+        } else if (ready >= label.arrival) {
+            continue;
+        }
+        label.arrival = ready;
+    }
+
+    RoundExecutor executor(*index, weekDay, threads);
+    executor.run(labels, rounds, startStops);
+}
+
+const JourneyTree::Label& JourneyTree::getLabel(int round, int stop) const {
+    return labels[static_cast<size_t>(round) * stopCount + stop];
+}
+
+int JourneyTree::findBestRound(int stop) const {
+    if (stop < 0) {
+        return -1;
+    }
+    int bestRound = -1;
+    int rounds = maxTransfers + 2;
+    for (int round = 0; round < rounds; ++round) {
+        int arrival = getLabel(round, stop).arrival;
+        if (arrival != NO_ARRIVAL &&
+            (bestRound == -1 || arrival < getLabel(bestRound, stop).arrival)) {
+            bestRound = round;
+        }
+    }
+    return bestRound;
+}
+
+bool JourneyTree::matches(const std::string& originName,
+                          const Time& departureTime,
+                          int weekDayFilter,
+                          int transfersLimit,
+                          unsigned long long version) const {
+    return origins.size() == 1 && origins[0].first == originName && origins[0].second == 0 &&
+           departure == departureTime.getTotalMinutes() &&
+           weekDay == weekDayFilter &&
+           maxTransfers == std::max(transfersLimit, 0) &&
+           index->getVersion() == version;
+}
+
+bool JourneyTree::matches(const List<StopPenalty>& originStops,
+                          const Time& departureTime,
+                          int weekDayFilter,
+                          int transfersLimit,
+                          unsigned long long version) const {
+    if (origins.size() != originStops.size()) {
+        return false;
+    }
+    size_t i = 0;
+    for (const auto& origin : originStops) {
+        if (origins[i].first != origin.stop || origins[i].second != std::max(origin.penalty, 0)) {
+            return false;
+        }
+        ++i;
+    }
+    return departure == departureTime.getTotalMinutes() &&
+           weekDay == weekDayFilter &&
+           maxTransfers == std::max(transfersLimit, 0) &&
+           index->getVersion() == version;
+}
+
+bool JourneyTree::isReachable(const std::string& target) const {
+    return findBestRound(index->getStopIndex(target)) != -1;
+}
+
+Time JourneyTree::getArrivalTime(const std::string& target) const {
+    int stop = index->getStopIndex(target);
+    int round = findBestRound(stop);
+    if (round == -1) {
+        throw ContainerException("Остановка недостижима: " + target);
+    }
+    return Time(0, getLabel(round, stop).arrival);
+}
+
+// Восстановление маршрута: от конечной остановки идем по остановкам посадки,
+// на каждом шаге переходя в предыдущий раунд, до начальной остановки в раунде 0
+GroupJourney JourneyTree::extractPath(int stop, int round, int endTime) const {
+    std::string endStop = index->getStopName(stop);
+    std::vector<int> legTrips;
+    std::vector<int> legBoardStops;
+    for (; round > 0; --round) {
+        const Label& label = getLabel(round, stop);
+        legTrips.push_back(label.trip);
+        legBoardStops.push_back(label.boardStop);
+        stop = label.boardStop;
+    }
+
+    List<std::shared_ptr<Trip>> trips;
+    List<std::string> transferPoints;
+    for (size_t i = legTrips.size(); i-- > 0;) {
+        trips.push_back(index->getTrip(legTrips[i]));
+        // Остановка посадки на каждый рейс, кроме первого, - точка пересадки
+        if (i + 1 < legTrips.size()) {
+            transferPoints.push_back(index->getStopName(legBoardStops[i]));
+        }
+    }
+
+    return {index->getStopName(stop), endStop,
+            Journey(trips, transferPoints, Time(0, departure), Time(0, endTime))};
+}
+
+List<Journey> JourneyTree::extractJourney(const std::string& target) const {
+    List<Journey> result;
+    int stop = index->getStopIndex(target);
+    int round = findBestRound(stop);
+    if (round != -1) {
+        result.push_back(extractPath(stop, round, getLabel(round, stop).arrival).journey);
+    }
+    return result;
+}
+
+List<GroupJourney> JourneyTree::extractJourney(const List<StopPenalty>& targets) const {
+    List<GroupJourney> result;
+    int bestStop = -1;
+    int bestRound = -1;
+    int bestEnd = 0;
+    for (const auto& target : targets) {
+        int stop = index->getStopIndex(target.stop);
+        int round = findBestRound(stop);
+        if (round == -1) {
+            continue;
+        }
+        int endTime = getLabel(round, stop).arrival + std::max(target.penalty, 0);
+        if (bestStop == -1 || endTime < bestEnd || (endTime == bestEnd && round < bestRound)) {
+            bestStop = stop;
+            bestRound = round;
+            bestEnd = endTime;
+        }
+    }
+    if (bestStop != -1) {
+        result.push_back(extractPath(bestStop, bestRound, bestEnd));
+    }
+    return result;
+}
@@ -0,0 +1,118 @@
+#ifndef JOURNEY_TREE_H
+#define JOURNEY_TREE_H
+
+#include <string>
+#include <memory>
+#include <vector>
+#include "list.h"
+#include "journey.h"
+#include "time.h"
+#include "timetable_index.h"
+
+// Остановка группы с дополнительным временем (в минутах): дойти до начальной остановки
+// или от конечной остановки до цели. Группы используются, когда подходит любая из
+// нескольких остановок (например, автобусная и трамвайная остановки у одного вокзала)
+struct StopPenalty {
+    std::string stop;   // Название остановки
+    int penalty;        // Время доступа/выхода в минутах
+
+    StopPenalty(const std::string& stopName, int penaltyMinutes = 0)
+        : stop(stopName), penalty(penaltyMinutes) {}
+};
+
+// Маршрут между группами остановок: выбранные начальная и конечная остановки и поездка
+// Время поездки включает время доступа и выхода
+struct GroupJourney {
+    std::string startStop;
+    std::string endStop;
+    Journey journey;
+};
+
+// Дерево самых ранних прибытий из одной остановки (или группы остановок) во все остальные
+// Строится по раундам: в раунде k найдены поездки, использующие k рейсов (k-1 пересадку).
+// Для каждой остановки и раунда хранится время прибытия, рейс и остановка посадки,
+// поэтому маршрут до любой остановки восстанавливается по дереву без повторного поиска.
+// Дерево неизменяемо и привязано к индексу сети (и, значит, к версии расписания)
+class JourneyTree {
+public:
+    // Метка остановки в раунде
+    struct Label {
+        int arrival = NO_ARRIVAL;   // Время прибытия (минуты от начала суток)
+        int trip = -1;              // Рейс, на котором прибыли (номер в индексе)
+        int boardStop = -1;         // Остановка посадки на этот рейс
+    };
+
+    // Остановка недостижима
+    static const int NO_ARRIVAL = -1;
+
+private:
+    std::shared_ptr<const TimetableIndex> index;   // Индекс сети, по которому построено дерево
+    std::vector<std::pair<std::string, int>> origins;  // Начальные остановки и время доступа к ним
+    int departure;                                 // Время отправления (минуты от начала суток)
+    int weekDay;                                   // День недели (0 - все дни)
+    int maxTransfers;                              // Максимальное количество пересадок
+    size_t stopCount;                              // Количество остановок в индексе
+    std::vector<Label> labels;                     // Метки: раунд * stopCount + остановка
+
+    const Label& getLabel(int round, int stop) const;
+
+    // Построение дерева (вызывается из конструкторов)
+    void build(size_t threads);
+
+    // Восстановить маршрут до остановки stop, достигнутой в раунде round
+    // endTime - время окончания поездки (прибытие плюс время выхода)
+    GroupJourney extractPath(int stop, int round, int endTime) const;
+
+    // Раунд, в котором остановка достигнута раньше всего (с наименьшим числом рейсов), или -1
+    int findBestRound(int stop) const;
+
+public:
+    // Построить дерево из остановки originName при отправлении не раньше departureTime
+    // weekDay = 0 - учитывать рейсы всех дней недели, 1..7 - только рейсы этого дня
+    // threads - количество потоков для просмотра маршрутов в раунде (результат от него не зависит)
+    JourneyTree(std::shared_ptr<const TimetableIndex> timetableIndex,
+                const std::string& originName,
+                const Time& departureTime,
+                int weekDay,
+                int maxTransfers,
+                size_t threads = 1);
+
+    // Построить дерево из группы начальных остановок: на каждую из них можно попасть
+    // к моменту departureTime + ее время доступа
+    JourneyTree(std::shared_ptr<const TimetableIndex> timetableIndex,
+                const List<StopPenalty>& originStops,
+                const Time& departureTime,
+                int weekDay,
+                int maxTransfers,
+                size_t threads = 1);
+
+    // Построено ли дерево для такого запроса и такой версии расписания
+    bool matches(const std::string& originName,
+                 const Time& departureTime,
+                 int weekDay,
+                 int maxTransfers,
+                 unsigned long long version) const;
+
+    bool matches(const List<StopPenalty>& originStops,
+                 const Time& departureTime,
+                 int weekDay,
+                 int maxTransfers,
+                 unsigned long long version) const;
+
+    // Достижима ли остановка
+    bool isReachable(const std::string& target) const;
+
+    // Самое раннее время прибытия на остановку (ContainerException, если она недостижима)
+    Time getArrivalTime(const std::string& target) const;
+
+    // Восстановить маршрут до остановки: самое раннее прибытие, при равенстве - меньше пересадок
+    // Возвращает пустой список, если остановка недостижима
+    List<Journey> extractJourney(const std::string& target) const;
+
+    // Восстановить лучший маршрут до любой остановки группы: минимум прибытия плюс время выхода
+    // (при равенстве - меньше пересадок, затем порядок остановок в группе)
+    // Возвращает пустой список, если ни одна остановка группы не достижима
+    List<GroupJourney> extractJourney(const List<StopPenalty>& targets) const;
+};
+
+#endif // JOURNEY_TREE_H
@@ -12,15 +12,32 @@
 #include "trip.h"
 #include "time.h"
 #include "stop.h"
+#include "data_manager.h"
+#include "mapped_dataset.h"
 
-int main() {
+int main(int argc, char* argv[]) {
     SetConsoleCP(CP_UTF8);
     SetConsoleOutputCP(CP_UTF8);
 
     try {
+        // Реплика для запросов (--replica): снимок data/snapshot.bin отображается в память,
+        // объекты системы не создаются. Снимок заменяется переименованием только после
+        // полной записи, поэтому по умолчанию он не перечитывается целиком для проверки
+        // контрольной суммы - страницы подгружаются по мере запросов; --verify включает проверку
+        if (argc > 1 && std::string(argv[1]) == "--replica") {
+            bool verify = argc > 2 && std::string(argv[2]) == "--verify";
+            DataManager dataManager;
+            auto dataset = dataManager.openMappedDataset(verify);
+            runReplicaMode(*dataset);
+            return 0;
+        }
+
         TransportSystem system;
 
         system.loadData();
+        system.setAutosaveInterval(std::chrono::minutes(5));
+        // Поиск с пересадками и дерево прибытий используют все ядра (результаты те же, что в одном потоке)
+        system.getJourneyPlanner().setSearchThreads(0);
 
         // Если данных нет вообще (файлы не существуют или пустые), инициализируем тестовые данные
         // Но только если ВСЕ категории пустые, чтобы не добавлять дубликаты
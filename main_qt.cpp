@@ -445,6 +445,9 @@ int main(int argc, char *argv[]) {
         // Загружаем данные из файлов
         std::cout << "[INFO] Загрузка данных из файлов..." << std::endl;
         system.loadData();
+        system.setAutosaveInterval(std::chrono::minutes(5));
+        // Поиск с пересадками и дерево прибытий используют все ядра (результаты те же, что в одном потоке)
+        system.getJourneyPlanner().setSearchThreads(0);
 
         // Проверяем, есть ли данные вообще (только если ВСЕ категории пустые)
         // Это означает, что файлы не существуют или пустые
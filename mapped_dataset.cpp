@@ -0,0 +1,113 @@
+#include "mapped_dataset.h"
+#include "exceptions.h"
+#include <algorithm>
+
+MappedDataset::MappedDataset(const std::string& filePath, bool verify)
+    : file(filePath), view(file.getData(), file.getSize(), verify) {
+    if (!view.hasSection(SnapshotSectionId::PlannerStops)) {
+        throw FileException(filePath, "в снимке нет индекса планировщика");
+    }
+    stopNames = view.getSection<uint32_t>(SnapshotSectionId::PlannerStops);
+    stopOrder = view.getSection<uint32_t>(SnapshotSectionId::PlannerStopOrder);
+    plannerTrips = view.getSection<uint32_t>(SnapshotSectionId::PlannerTrips);
+    trips = view.getSection<SnapshotTrip>(SnapshotSectionId::Trips);
+    routes = view.getSection<SnapshotRoute>(SnapshotSectionId::Routes);
+
+    ConnectionTable::Arrays arrays;
+    arrays.depTimes = view.getSection<int>(SnapshotSectionId::ConnectionDepTimes);
+    arrays.arrTimes = view.getSection<int>(SnapshotSectionId::ConnectionArrTimes);
+    arrays.depStops = view.getSection<int>(SnapshotSectionId::ConnectionDepStops);
+    arrays.arrStops = view.getSection<int>(SnapshotSectionId::ConnectionArrStops);
+    arrays.trips = view.getSection<int>(SnapshotSectionId::ConnectionTrips);
+    arrays.weekDays = view.getSection<int>(SnapshotSectionId::ConnectionWeekDays);
+    arrays.interchangeFlags = view.getSection<unsigned char>(SnapshotSectionId::PlannerInterchange);
+    arrays.tripCount = plannerTrips.size();
+    connections.attach(arrays);
+}
+
+size_t MappedDataset::getStopCount() const {
+    return stopNames.size();
+}
+
+size_t MappedDataset::getConnectionCount() const {
+    return connections.size();
+}
+
+int MappedDataset::getStopIndex(std::string_view name) const {
+    auto it = std::lower_bound(stopOrder.begin(), stopOrder.end(), name, [this](uint32_t stop, std::string_view key) {
+        return view.getString(stopNames[stop]) < key;
+    });
+    if (it == stopOrder.end() || view.getString(stopNames[*it]) != name) {
+        return -1;
+    }
+    return static_cast<int>(*it);
+}
+
+std::string_view MappedDataset::getStopName(int stop) const {
+    return view.getString(stopNames[stop]);
+}
+
+int MappedDataset::getTripId(int trip) const {
+    uint32_t record = plannerTrips[trip];
+    return record == SNAPSHOT_NONE ? -1 : trips[record].id;
+}
+
+int MappedDataset::getRouteNumber(int trip) const {
+    uint32_t record = plannerTrips[trip];
+    return record == SNAPSHOT_NONE ? -1 : routes[trips[record].route].number;
+}
+
+std::optional<MappedJourney> MappedDataset::findEarliestJourney(std::string_view start, std::string_view end,
+                                                                const Time& departureTime, int weekDay) const {
+    int startStop = getStopIndex(start);
+    int endStop = getStopIndex(end);
+    if (startStop < 0 || endStop < 0 || startStop == endStop) {
+        return std::nullopt;
+    }
+
+    int departure = departureTime.getTotalMinutes();
+    ConnectionScanState state;
+    connections.initState(state, startStop, departure);
+    connections.scanVectorized(state, connections.findFirst(departure), endStop, weekDay);
+    if (state.inConnection[endStop] < 0) {
+        return std::nullopt;
+    }
+
+    // Восстановление от цели: соединение прибытия -> рейс -> соединение посадки
+    auto depTimes = connections.getDepTimes();
+    auto arrTimes = connections.getArrTimes();
+    auto depStops = connections.getDepStops();
+    auto tripIds = connections.getTrips();
+    MappedJourney journey{departure, state.arrival[endStop], {}};
+    for (int stop = endStop; stop != startStop;) {
+        int arrivalConnection = state.inConnection[stop];
+        int trip = tripIds[arrivalConnection];
+        int boardConnection = state.tripBoarding[trip];
+        journey.legs.push_back({getTripId(trip), getRouteNumber(trip), depStops[boardConnection], stop,
+                                depTimes[boardConnection], arrTimes[arrivalConnection]});
+        stop = depStops[boardConnection];
+    }
+    std::reverse(journey.legs.begin(), journey.legs.end());
+    return journey;
+}
+
+std::vector<MappedDeparture> MappedDataset::getDepartures(std::string_view stop, const Time& from, const Time& to,
+                                                          int weekDay) const {
+    std::vector<MappedDeparture> result;
+    int stopIndex = getStopIndex(stop);
+    if (stopIndex < 0) {
+        return result;
+    }
+    ConnectionTable::Arrays arrays = connections.getArrays();
+    int last = to.getTotalMinutes();
+    for (size_t c = connections.findFirst(from.getTotalMinutes()); c < arrays.depTimes.size(); ++c) {
+        if (arrays.depTimes[c] > last) {
+            break;
+        }
+        if (arrays.depStops[c] == stopIndex && (weekDay == 0 || arrays.weekDays[c] == weekDay)) {
+            result.push_back({arrays.depTimes[c], getTripId(arrays.trips[c]), getRouteNumber(arrays.trips[c]),
+                              arrays.arrStops[c]});
+        }
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef MAPPED_DATASET_H
+#define MAPPED_DATASET_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "mapped_file.h"
+#include "snapshot.h"
+#include "connection_scan.h"
+#include "time.h"
+
+// Поездка на одном рейсе в ответе MappedDataset
+struct MappedLeg {
+    int tripId;          // Идентификатор рейса
+    int routeNumber;     // Номер маршрута
+    int fromStop;        // Остановка посадки (номер в наборе данных)
+    int toStop;          // Остановка высадки
+    int departure;       // Отправление с fromStop (минуты от начала суток)
+    int arrival;         // Прибытие на toStop
+};
+
+// Маршрут поездки из MappedDataset
+struct MappedJourney {
+    int departure;                 // Заданное время отправления
+    int arrival;                   // Прибытие на конечную остановку
+    std::vector<MappedLeg> legs;   // Поездки по порядку
+
+    int getTransferCount() const { return legs.empty() ? 0 : static_cast<int>(legs.size()) - 1; }
+};
+
+// Отправление рейса с остановки
+struct MappedDeparture {
+    int time;            // Время отправления
+    int tripId;
+    int routeNumber;
+    int nextStop;        // Следующая остановка рейса
+};
+
+// Набор данных только для чтения поверх отображенного в память снимка (snapshot.bin)
+// Для реплик, которые только отвечают на запросы: объекты системы не создаются, поиск
+// маршрутов и расписание остановок читаются прямо из страниц файла (таблица соединений
+// и индекс остановок снимка), память выделяется только под метки отдельного запроса.
+// Процессы, открывшие один файл, используют одну физическую копию расписания.
+// Запись нового снимка (через переименование) не затрагивает уже открытый набор
+class MappedDataset {
+private:
+    MappedFile file;
+    SnapshotView view;
+    ConnectionTable connections;
+    std::span<const uint32_t> stopNames;
+    std::span<const uint32_t> stopOrder;
+    std::span<const uint32_t> plannerTrips;
+    std::span<const SnapshotTrip> trips;
+    std::span<const SnapshotRoute> routes;
+
+    int getTripId(int trip) const;
+    int getRouteNumber(int trip) const;
+
+public:
+    // Открыть снимок. verify = false пропускает проверку контрольной суммы и ссылок
+    // (файл не читается целиком при открытии) - только для заранее проверенных файлов.
+    // Выбрасывает FileException, если файла нет, он поврежден или в нем нет индекса
+    explicit MappedDataset(const std::string& filePath, bool verify = true);
+
+    size_t getStopCount() const;
+    size_t getConnectionCount() const;
+
+    // Номер остановки по названию (двоичный поиск по упорядоченным названиям) или -1
+    int getStopIndex(std::string_view name) const;
+    std::string_view getStopName(int stop) const;
+
+    // Самое раннее прибытие (сканирование соединений, как ConnectionScanAlgorithm)
+    // weekDay = 0 - рейсы всех дней недели; пусто, если остановки неизвестны или маршрута нет
+    std::optional<MappedJourney> findEarliestJourney(std::string_view start, std::string_view end,
+                                                     const Time& departureTime, int weekDay = 0) const;
+
+    // Отправления с остановки в интервале [from, to] в порядке времени
+    std::vector<MappedDeparture> getDepartures(std::string_view stop, const Time& from, const Time& to,
+                                               int weekDay = 0) const;
+};
+
+#endif // MAPPED_DATASET_H
@@ -0,0 +1,99 @@
+#include "mapped_file.h"
+#include "exceptions.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filePath) {
+    fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        fileHandle = nullptr;
+        throw FileException(filePath, "открытие для чтения");
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        throw FileException(filePath, "определение размера");
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        throw FileException(filePath, "отображение в память");
+    }
+    data = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!data) {
+        close();
+        throw FileException(filePath, "отображение в память");
+    }
+}
+
+void MappedFile::close() {
+    if (data) {
+        UnmapViewOfFile(data);
+        data = nullptr;
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+        fileHandle = nullptr;
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filePath) {
+    descriptor = ::open(filePath.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw FileException(filePath, "открытие для чтения");
+    }
+    struct stat info;
+    if (fstat(descriptor, &info) != 0 || info.st_size == 0) {
+        close();
+        throw FileException(filePath, "определение размера");
+    }
+    size = static_cast<size_t>(info.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, descriptor, 0);
+    if (mapping == MAP_FAILED) {
+        close();
+        throw FileException(filePath, "отображение в память");
+    }
+    data = static_cast<const char*>(mapping);
+}
+
+void MappedFile::close() {
+    if (data) {
+        munmap(const_cast<char*>(data), size);
+        data = nullptr;
+    }
+    if (descriptor >= 0) {
+        ::close(descriptor);
+        descriptor = -1;
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+const char* MappedFile::getData() const {
+    return data;
+}
+
+size_t MappedFile::getSize() const {
+    return size;
+}
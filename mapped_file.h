@@ -0,0 +1,35 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Файл, отображенный в память только для чтения
+// Страницы подгружаются операционной системой при первом обращении и разделяются
+// всеми процессами, отобразившими тот же файл. Отображение закрывается деструктором
+class MappedFile {
+private:
+    const char* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int descriptor = -1;
+#endif
+
+    void close();
+
+public:
+    // Отобразить файл; выбрасывает FileException, если файл не открывается или пуст
+    explicit MappedFile(const std::string& filePath);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* getData() const;
+    size_t getSize() const;
+};
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,12 @@
+#include "policy_planner.h"
+#include "transport_system.h"
+
+std::shared_ptr<const TimetableIndex> currentTimetableIndex(TransportSystem* system) {
+    return system->getJourneyPlanner().getTimetableIndex();
+}
+
+// Используемые конфигурации компилируются один раз здесь
+template class RoundPlanner<EarliestArrivalCriterion, FewestTransfersCriterion, 3>;
+template class RoundPlanner<FewestTransfersCriterion, EarliestArrivalCriterion, 3>;
+template class PolicyPathFindingAlgorithm<EarliestArrivalPlanner>;
+template class PolicyPathFindingAlgorithm<FewestTransfersPlanner>;
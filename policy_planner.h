@@ -0,0 +1,117 @@
+#ifndef POLICY_PLANNER_H
+#define POLICY_PLANNER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "list.h"
+#include "journey.h"
+#include "time.h"
+#include "timetable_index.h"
+#include "algorithm.h"
+
+// Критерии выбора маршрута для RoundPlanner
+// key - значение критерия для маршрута, прибывающего в arrival за rounds поездок
+// (меньше - лучше)
+
+// Самое раннее прибытие
+// Метку, прибывающую не раньше уже найденного прибытия на цель, можно отбросить:
+// она не даст более раннего прибытия
+struct EarliestArrivalCriterion {
+    static constexpr bool pruneByTargetArrival = true;
+    static constexpr bool stopAtFirstArrival = false;
+
+    static int key(int arrival, int /*rounds*/) { return arrival; }
+    static const char* name() { return "самое раннее прибытие"; }
+};
+
+// Наименьшее число пересадок
+// Первый раунд, в котором цель достигнута, дает наименьшее число поездок
+struct FewestTransfersCriterion {
+    static constexpr bool pruneByTargetArrival = false;
+    static constexpr bool stopAtFirstArrival = true;
+
+    static int key(int /*arrival*/, int rounds) { return rounds; }
+    static const char* name() { return "наименьшее число пересадок"; }
+};
+
+// Поиск маршрута по раундам, настраиваемый на этапе компиляции
+// Primary - основной критерий, TieBreak - критерий выбора при равенстве основного,
+// MaxRounds - наибольшее число поездок (пересадок на одну меньше).
+// Все проверки критериев разрешаются при компиляции, поэтому для каждой используемой
+// конфигурации компилятор строит отдельное ядро поиска без ветвлений по настройкам.
+// Используется через TemplateAlgorithm (функциональный объект) и PolicyPathFindingAlgorithm
+template<typename Primary, typename TieBreak, int MaxRounds>
+class RoundPlanner {
+    static_assert(MaxRounds >= 1, "Нужна хотя бы одна поездка");
+
+public:
+    // Метка остановки в раунде
+    struct Label {
+        int arrival;     // Время прибытия
+        int trip;        // Рейс последней поездки (-1 для начальной остановки)
+        int boardStop;   // Остановка посадки на этот рейс
+    };
+
+    static constexpr int maxRounds = MaxRounds;
+
+    // Найти маршрут из startStop в endStop (номера в индексе); пустой список, если маршрута нет
+    // weekDay = 0 - рейсы всех дней недели
+    // guard - ограничения запроса: проверяются раз в раунд и перед просмотром каждого шаблона;
+    // при срабатывании возвращается лучший маршрут по меткам, найденным к этому моменту
+    List<Journey> operator()(const TimetableIndex& index, int startStop, int endStop,
+                             const Time& departureTime, int weekDay,
+                             QueryGuard* guard = nullptr) const;
+
+    static std::string getDescription();
+
+private:
+    // Восстановить маршрут по меткам раундов
+    static Journey extractJourney(const TimetableIndex& index, const std::vector<Label>& labels,
+                                  int endStop, int round, const Time& departureTime);
+};
+
+// Текущий индекс сети планировщика системы
+// Определена в policy_planner.cpp, чтобы заголовок не зависел от transport_system.h
+std::shared_ptr<const TimetableIndex> currentTimetableIndex(TransportSystem* system);
+
+// Стратегия поиска (PathFindingAlgorithm) поверх RoundPlanner
+// Тонкая обертка: виртуальный findPath только находит индекс и вызывает ядро
+template<typename Planner>
+class PolicyPathFindingAlgorithm : public PathFindingAlgorithm {
+private:
+    TemplateAlgorithm<Planner> planner;
+    int weekDay = 0;
+
+public:
+    explicit PolicyPathFindingAlgorithm(TransportSystem* sys) : PathFindingAlgorithm(sys) {}
+
+    // День недели рейсов (0 - все дни)
+    void setWeekDay(int day) { weekDay = day; }
+    int getWeekDay() const { return weekDay; }
+
+    List<Journey> findPath(const std::string& start,
+                           const std::string& end,
+                           const Time& departureTime) override;
+
+    void execute() override {}
+
+    std::string getDescription() const override {
+        return Planner::getDescription();
+    }
+};
+
+// Используемые конфигурации (две пересадки, как у остальных планировщиков)
+using EarliestArrivalPlanner = RoundPlanner<EarliestArrivalCriterion, FewestTransfersCriterion, 3>;
+using FewestTransfersPlanner = RoundPlanner<FewestTransfersCriterion, EarliestArrivalCriterion, 3>;
+
+// Эти конфигурации компилируются один раз в policy_planner.cpp, а не в каждом файле
+extern template class RoundPlanner<EarliestArrivalCriterion, FewestTransfersCriterion, 3>;
+extern template class RoundPlanner<FewestTransfersCriterion, EarliestArrivalCriterion, 3>;
+extern template class PolicyPathFindingAlgorithm<EarliestArrivalPlanner>;
+extern template class PolicyPathFindingAlgorithm<FewestTransfersPlanner>;
+
+// Реализация шаблонов
+#include "policy_planner.tpp"
+
+#endif // POLICY_PLANNER_H
@@ -0,0 +1,198 @@
+#ifndef POLICY_PLANNER_TPP
+#define POLICY_PLANNER_TPP
+
+// Этот файл должен включаться только из policy_planner.h
+#ifndef POLICY_PLANNER_H
+#error "policy_planner.tpp should only be included from policy_planner.h"
+#endif
+
+#include <algorithm>
+#include <limits>
+
+// Раунд r находит поездки из r рейсов: шаблоны маршрутов, проходящие через остановки,
+// улучшенные в раунде r-1, просматриваются от самой ранней такой остановки; на каждой
+// остановке пробуем улучшить прибытие текущим рейсом и пересесть на более ранний рейс
+// шаблона. Пересаживаться можно только в пересадочных узлах
+template<typename Primary, typename TieBreak, int MaxRounds>
+List<Journey> RoundPlanner<Primary, TieBreak, MaxRounds>::operator()(const TimetableIndex& index,
+                                                                     int startStop, int endStop,
+                                                                     const Time& departureTime,
+                                                                     int weekDay,
+                                                                     QueryGuard* guard) const {
+    List<Journey> result;
+    if (startStop < 0 || endStop < 0 || startStop == endStop) {
+        return result;
+    }
+
+    const int none = std::numeric_limits<int>::max();
+    const RoutePatterns& patterns = index.getPatterns();
+    size_t stopCount = index.getStopCount();
+
+    std::vector<Label> labels(static_cast<size_t>(MaxRounds + 1) * stopCount, Label{none, -1, -1});
+    std::vector<int> best(stopCount, none);
+    std::vector<int> firstPosition(patterns.getPatternCount(), -1);
+    std::vector<int> queued;
+    std::vector<int> marked{startStop};
+    std::vector<int> improved;
+    std::vector<char> boardable(stopCount, 0);
+
+    int departure = departureTime.getTotalMinutes();
+    labels[startStop] = {departure, -1, -1};
+    best[startStop] = departure;
+
+    bool stopped = false;
+    for (int round = 1; round <= MaxRounds && !marked.empty() && !stopped; ++round) {
+        if (guard && !guard->step()) {
+            break;
+        }
+        const Label* previous = &labels[static_cast<size_t>(round - 1) * stopCount];
+        Label* current = &labels[static_cast<size_t>(round) * stopCount];
+
+        queued.clear();
+        for (int stop : marked) {
+            boardable[stop] = 1;
+            for (const auto& entry : patterns.getStopPatterns(stop)) {
+                if (weekDay != 0 && patterns.getWeekDay(entry.pattern) != weekDay) {
+                    continue;
+                }
+                int& first = firstPosition[entry.pattern];
+                if (first == -1) {
+                    queued.push_back(entry.pattern);
+                    first = entry.position;
+                } else {
+                    first = std::min(first, entry.position);
+                }
+            }
+        }
+
+        improved.clear();
+        for (int pattern : queued) {
+            // Метки текущего раунда, уже найденные до прерывания, остаются корректными
+            if (guard && !guard->step()) {
+                stopped = true;
+                break;
+            }
+            auto stops = patterns.getStops(pattern);
+            auto trips = patterns.getTrips(pattern);
+            size_t trip = trips.size();
+            int boardStop = -1;
+
+            for (size_t i = static_cast<size_t>(firstPosition[pattern]); i < stops.size(); ++i) {
+                int stop = stops[i];
+                auto column = patterns.getTimes(pattern, static_cast<int>(i));
+
+                if (trip < trips.size()) {
+                    int arrival = column[trip];
+                    bool better = arrival < best[stop];
+                    if constexpr (Primary::pruneByTargetArrival) {
+                        better = better && arrival < best[endStop];
+                    }
+                    if (better) {
+                        if (current[stop].arrival == none) {
+                            improved.push_back(stop);
+                        }
+                        current[stop] = {arrival, trips[trip], boardStop};
+                        best[stop] = arrival;
+                    }
+                }
+
+                if (boardable[stop]) {
+                    size_t candidate = RoutePatterns::findFirstTrip(column, previous[stop].arrival);
+                    if (candidate < trip) {
+                        trip = candidate;
+                        boardStop = stop;
+                    }
+                }
+            }
+            firstPosition[pattern] = -1;
+        }
+
+        if constexpr (Primary::stopAtFirstArrival) {
+            if (current[endStop].arrival != none) {
+                break;
+            }
+        }
+
+        for (int stop : marked) {
+            boardable[stop] = 0;
+        }
+        marked.clear();
+        for (int stop : improved) {
+            if (index.isInterchange(stop)) {
+                marked.push_back(stop);
+            }
+        }
+    }
+
+    // Выбор раунда по основному критерию, при равенстве - по дополнительному
+    int bestRound = -1;
+    for (int round = 1; round <= MaxRounds; ++round) {
+        int arrival = labels[static_cast<size_t>(round) * stopCount + endStop].arrival;
+        if (arrival == none) {
+            continue;
+        }
+        if (bestRound == -1) {
+            bestRound = round;
+            continue;
+        }
+        int bestArrival = labels[static_cast<size_t>(bestRound) * stopCount + endStop].arrival;
+        int key = Primary::key(arrival, round);
+        int bestKey = Primary::key(bestArrival, bestRound);
+        if (key < bestKey || (key == bestKey && TieBreak::key(arrival, round) < TieBreak::key(bestArrival, bestRound))) {
+            bestRound = round;
+        }
+    }
+
+    if (bestRound != -1) {
+        result.push_back(extractJourney(index, labels, endStop, bestRound, departureTime));
+    }
+    return result;
+}
+
+template<typename Primary, typename TieBreak, int MaxRounds>
+Journey RoundPlanner<Primary, TieBreak, MaxRounds>::extractJourney(const TimetableIndex& index,
+                                                                   const std::vector<Label>& labels,
+                                                                   int endStop, int round,
+                                                                   const Time& departureTime) {
+    size_t stopCount = index.getStopCount();
+    int arrival = labels[static_cast<size_t>(round) * stopCount + endStop].arrival;
+    std::vector<int> legTrips;
+    std::vector<int> legBoardStops;
+    for (int stop = endStop; round > 0; --round) {
+        const Label& label = labels[static_cast<size_t>(round) * stopCount + stop];
+        legTrips.push_back(label.trip);
+        legBoardStops.push_back(label.boardStop);
+        stop = label.boardStop;
+    }
+
+    List<std::shared_ptr<Trip>> trips;
+    List<std::string> transferPoints;
+    for (size_t i = legTrips.size(); i-- > 0;) {
+        trips.push_back(index.getTrip(legTrips[i]));
+        // Остановка посадки на каждый рейс, кроме первого, - точка пересадки
+        if (i + 1 < legTrips.size()) {
+            transferPoints.push_back(index.getStopName(legBoardStops[i]));
+        }
+    }
+    return Journey(trips, transferPoints, departureTime, Time(0, arrival));
+}
+
+template<typename Primary, typename TieBreak, int MaxRounds>
+std::string RoundPlanner<Primary, TieBreak, MaxRounds>::getDescription() {
+    return std::string("Поиск по раундам: ") + Primary::name() + ", при равенстве - " + TieBreak::name() +
+           ", не более " + std::to_string(MaxRounds - 1) + " пересадок";
+}
+
+template<typename Planner>
+List<Journey> PolicyPathFindingAlgorithm<Planner>::findPath(const std::string& start,
+                                                            const std::string& end,
+                                                            const Time& departureTime) {
+    auto index = currentTimetableIndex(system);
+    QueryGuard guard(queryOptions);
+    auto journeys = planner(*index, index->getStopIndex(start), index->getStopIndex(end), departureTime,
+                            weekDay, &guard);
+    truncated = guard.isTruncated();
+    return journeys;
+}
+
+#endif // POLICY_PLANNER_TPP
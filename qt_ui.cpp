@@ -14,12 +14,15 @@
 #include "journey.h"
 #include "journey_planner.h"
 #include <QApplication>
+#include <QTimer>
+#include <QPointer>
 #include <QHeaderView>
 #include <QDateTime>
 #include <QInputDialog>
 #include <QRegularExpressionValidator>
 #include <QValidator>
 #include <sstream>
+#include <iostream>
 #include <iomanip>
 #include <algorithm>
 #include <set>
@@ -85,6 +88,15 @@ MainWindow::MainWindow(TransportSystem* system, QWidget *parent)
 
     setupUI();
     createLoginScreen();
+
+    // Автосохранение проверяется в потоке окна: копия данных для фоновой записи
+    // снимается там же, где данные изменяются
+    QTimer* autosaveTimer = new QTimer(this);
+    connect(autosaveTimer, &QTimer::timeout, this, [this]() {
+        // Окно не читает консоль, поэтому итог автосохранения печатается прямо в потоке записи
+        transportSystem->autosaveIfDue([](const SaveResult& result) { std::cout << result.messages << std::flush; });
+    });
+    autosaveTimer->start(30 * 1000);
 }
 
 MainWindow::~MainWindow() = default;
@@ -424,23 +436,23 @@ void AdminModeWidget::setupUI() {
     QWidget* manageTab = new QWidget();
     QVBoxLayout* manageLayout = new QVBoxLayout(manageTab);
 
-    QPushButton* saveBtn = new QPushButton("Сохранить данные", manageTab);
+    saveButton = new QPushButton("Сохранить данные", manageTab);
     QPushButton* undoBtn = new QPushButton("Отменить последнее действие", manageTab);
     QPushButton* redoBtn = new QPushButton("Повторить последнее действие", manageTab);
     QPushButton* backBtn = new QPushButton("Выйти из режима администратора", manageTab);
 
-    saveBtn->setMinimumHeight(40);
+    saveButton->setMinimumHeight(40);
     undoBtn->setMinimumHeight(40);
     redoBtn->setMinimumHeight(40);
     backBtn->setMinimumHeight(40);
 
-    manageLayout->addWidget(saveBtn);
+    manageLayout->addWidget(saveButton);
     manageLayout->addWidget(undoBtn);
     manageLayout->addWidget(redoBtn);
     manageLayout->addStretch();
     manageLayout->addWidget(backBtn);
 
-    connect(saveBtn, &QPushButton::clicked, this, &AdminModeWidget::saveData);
+    connect(saveButton, &QPushButton::clicked, this, &AdminModeWidget::saveData);
     connect(undoBtn, &QPushButton::clicked, this, &AdminModeWidget::undoLastAction);
     connect(redoBtn, &QPushButton::clicked, this, &AdminModeWidget::redoLastAction);
     connect(backBtn, &QPushButton::clicked, this, &AdminModeWidget::backToMain);
@@ -799,15 +811,38 @@ void AdminModeWidget::viewAllData() {
     QMessageBox::information(this, "Обновление", stats);
 }
 
+// Сохранение идет в потоке записи, чтобы окно не замирало на время записи файлов.
+// Итог приходит в поток интерфейса через очередь событий приложения; QPointer
+// защищает от закрытия виджета до окончания сохранения
 void AdminModeWidget::saveData() {
+    saveButton->setEnabled(false);
+    QPointer<AdminModeWidget> self(this);
     try {
-        transportSystem->saveData();
-        QMessageBox::information(this, "Сохранение", "Данные успешно сохранены.");
+        transportSystem->saveDataAsync([self](const SaveResult& result) {
+            QMetaObject::invokeMethod(qApp, [self, result]() {
+                if (self) {
+                    self->showSaveResult(result);
+                }
+            }, Qt::QueuedConnection);
+        });
     } catch (const std::exception& e) {
+        saveButton->setEnabled(true);
         QMessageBox::critical(this, "Ошибка", QString("Ошибка при сохранении: %1").arg(e.what()));
     }
 }
 
+void AdminModeWidget::showSaveResult(const SaveResult& result) {
+    saveButton->setEnabled(true);
+    QString messages = QString::fromStdString(result.messages).trimmed();
+    if (result.success) {
+        QMessageBox::information(this, "Сохранение",
+            messages.isEmpty() ? QString("Данные успешно сохранены.") : messages);
+    } else {
+        QMessageBox::critical(this, "Ошибка",
+            QString("Не все изменения сохранены:\n%1").arg(messages));
+    }
+}
+
 void AdminModeWidget::undoLastAction() {
     try {
         if (transportSystem->canUndo()) {
@@ -1331,6 +1366,66 @@ void StopTimetableDialog::populateTimetable(const std::string& stopName, int wee
 
 // ==================== RouteSearchDialog ====================
 
+// Вывод маршрута с пересадками в поле результатов поиска
+// Время отправления - посадка на первый рейс на остановке A (а не время запроса),
+// время в пути считается от посадки, без ожидания на остановке
+static void appendJourneyDetails(QTextEdit* resultsText, const Journey& journey,
+                                 const std::string& stopA, const std::string& stopB) {
+    const auto& trips = journey.getTrips();
+    const auto& transferPoints = journey.getTransferPoints();
+
+    Time startTime = journey.getStartTime();
+    if (!trips.empty() && trips[0]->hasStop(stopA)) {
+        startTime = trips[0]->getArrivalTime(stopA);
+    }
+    Time endTime = journey.getEndTime();
+    QString startTimeStr = QString("%1:%2")
+        .arg(startTime.getHours(), 2, 10, QChar('0'))
+        .arg(startTime.getMinutes(), 2, 10, QChar('0'));
+    QString endTimeStr = QString("%1:%2")
+        .arg(endTime.getHours(), 2, 10, QChar('0'))
+        .arg(endTime.getMinutes(), 2, 10, QChar('0'));
+
+    resultsText->append(QString("Пересадок: %1\n").arg(journey.getTransferCount()));
+    resultsText->append(QString("Общее время в пути: %1 минут\n").arg(endTime - startTime));
+    resultsText->append(QString("Время отправления: %1\n").arg(startTimeStr));
+    resultsText->append(QString("Время прибытия: %1\n").arg(endTimeStr));
+
+    resultsText->append("\nПуть:\n");
+    resultsText->append("  " + QString::fromStdString(stopA));
+
+    for (size_t j = 0; j < trips.size(); ++j) {
+        const auto& trip = trips[j];
+        const auto& route = trip->getRoute();
+        const auto& routeStops = route->getAllStops();
+
+        // Определяем начальную и конечную остановки для этого участка
+        std::string segmentStart = (j == 0) ? stopA : transferPoints[j - 1];
+        std::string segmentEnd = (j < transferPoints.size()) ? transferPoints[j] : stopB;
+
+        int startPos = route->getStopPosition(segmentStart);
+        int endPos = route->getStopPosition(segmentEnd);
+
+        if (startPos != -1 && endPos != -1 && startPos < endPos) {
+            for (int k = startPos + 1; k <= endPos; ++k) {
+                resultsText->append(" → " + QString::fromStdString(routeStops[k]));
+            }
+        }
+
+        resultsText->append(QString(" [Маршрут %1 (%2)]")
+            .arg(route->getNumber())
+            .arg(QString::fromStdString(route->getVehicleType())));
+
+        if (j < transferPoints.size()) {
+            resultsText->append(QString("\n  Пересадка на остановке: %1\n")
+                .arg(QString::fromStdString(transferPoints[j])));
+            resultsText->append("  " + QString::fromStdString(transferPoints[j]));
+        }
+    }
+    resultsText->append("\n\n");
+    resultsText->append("========================================\n");
+}
+
 RouteSearchDialog::RouteSearchDialog(TransportSystem* system, QWidget *parent)
     : QDialog(parent), transportSystem(system) {
     setWindowTitle("Поиск маршрутов");
@@ -1344,6 +1439,23 @@ RouteSearchDialog::RouteSearchDialog(TransportSystem* system, QWidget *parent)
     QLabel* stopBLabel = new QLabel("Остановка B:", this);
     stopBComboBox = new QComboBox(this);
 
+    QLabel* departureLabel = new QLabel("Время отправления:", this);
+    departureTimeEdit = new QTimeEdit(QTime::currentTime(), this);
+    departureTimeEdit->setDisplayFormat("HH:mm");
+
+    // По умолчанию - сегодняшний день недели (1 - понедельник, как в расписании рейсов)
+    QLabel* weekDayLabel = new QLabel("День недели:", this);
+    weekDayComboBox = new QComboBox(this);
+    weekDayComboBox->addItem("Все дни", 0);
+    weekDayComboBox->addItem("Понедельник", 1);
+    weekDayComboBox->addItem("Вторник", 2);
+    weekDayComboBox->addItem("Среда", 3);
+    weekDayComboBox->addItem("Четверг", 4);
+    weekDayComboBox->addItem("Пятница", 5);
+    weekDayComboBox->addItem("Суббота", 6);
+    weekDayComboBox->addItem("Воскресенье", 7);
+    weekDayComboBox->setCurrentIndex(QDate::currentDate().dayOfWeek());
+
     QPushButton* searchBtn = new QPushButton("Поиск", this);
 
     resultsText = new QTextEdit(this);
@@ -1355,6 +1467,10 @@ RouteSearchDialog::RouteSearchDialog(TransportSystem* system, QWidget *parent)
     layout->addWidget(stopAComboBox);
     layout->addWidget(stopBLabel);
     layout->addWidget(stopBComboBox);
+    layout->addWidget(departureLabel);
+    layout->addWidget(departureTimeEdit);
+    layout->addWidget(weekDayLabel);
+    layout->addWidget(weekDayComboBox);
     layout->addWidget(searchBtn);
     layout->addWidget(resultsText);
     layout->addWidget(closeBtn);
@@ -1424,102 +1540,69 @@ void RouteSearchDialog::onSearchClicked() {
             resultsText->append("Ищем маршруты с пересадками...\n\n");
 
             try {
+                std::string startName = stopA.toStdString();
+                std::string endName = stopB.toStdString();
+                int weekDay = weekDayComboBox->currentData().toInt();
+
+                // Дерево прибытий из остановки A сохраняется в планировщике, поэтому при смене
+                // только остановки B ближайший маршрут восстанавливается из него без нового поиска
                 auto& planner = transportSystem->getJourneyPlanner();
-                auto journeys = planner.findAllJourneysWithTransfers(
-                    stopA.toStdString(), stopB.toStdString(), 2);
+                QTime departure = departureTimeEdit->time();
+                auto nearest = planner.getJourneyTree(startName,
+                                                      Time(departure.hour(), departure.minute()),
+                                                      weekDay)
+                                   ->extractJourney(endName);
+
+                if (!nearest.empty()) {
+                    resultsText->append("========================================\n");
+                    resultsText->append("Ближайший маршрут с пересадками:\n");
+                    resultsText->append("========================================\n\n");
+                    appendJourneyDetails(resultsText, nearest[0], startName, endName);
+                }
 
-                if (journeys.empty()) {
-                    resultsText->append("Маршрутов с пересадками не найдено.\n");
-                } else {
-                    // Фильтруем уникальные варианты по комбинации маршрутов и точек пересадки
-                    List<Journey> uniqueJourneys;
-                    std::set<std::string> seenRoutes;
-
-                    for (const auto& journey : journeys) {
-                        // Создаем уникальный ключ: последовательность номеров маршрутов + точки пересадки
-                        std::string routeKey;
-                        const auto& trips = journey.getTrips();
-                        const auto& transferPoints = journey.getTransferPoints();
-
-                        for (size_t i = 0; i < trips.size(); ++i) {
-                            routeKey += std::to_string(trips[i]->getRoute()->getNumber());
-                            if (i < transferPoints.size()) {
-                                routeKey += "@" + transferPoints[i] + "@";
-                            }
-                        }
+                auto journeys = planner.findAllJourneysWithTransfers(startName, endName, 2);
+
+                // Фильтруем уникальные варианты по комбинации маршрутов и точек пересадки
+                // (при выбранном дне недели - только варианты, все рейсы которых ходят в этот день)
+                List<Journey> uniqueJourneys;
+                std::set<std::string> seenRoutes;
 
-                        // Добавляем только если такой комбинации еще не было
-                        if (seenRoutes.find(routeKey) == seenRoutes.end()) {
-                            seenRoutes.insert(routeKey);
-                            uniqueJourneys.push_back(journey);
+                for (const auto& journey : journeys) {
+                    // Создаем уникальный ключ: последовательность номеров маршрутов + точки пересадки
+                    std::string routeKey;
+                    bool dayMatches = true;
+                    const auto& trips = journey.getTrips();
+                    const auto& transferPoints = journey.getTransferPoints();
+
+                    for (size_t i = 0; i < trips.size(); ++i) {
+                        if (weekDay != 0 && trips[i]->getWeekDay() != weekDay) {
+                            dayMatches = false;
+                        }
+                        routeKey += std::to_string(trips[i]->getRoute()->getNumber());
+                        if (i < transferPoints.size()) {
+                            routeKey += "@" + transferPoints[i] + "@";
                         }
                     }
 
-                    if (uniqueJourneys.empty()) {
-                        resultsText->append("Маршрутов с пересадками не найдено.\n");
-                    } else {
-                        resultsText->append("========================================\n");
-                        resultsText->append("Маршруты с пересадками:\n");
-                        resultsText->append("========================================\n\n");
-
-                        // Показываем до 5 уникальных вариантов
-                        int count = std::min(5, static_cast<int>(uniqueJourneys.size()));
-                        for (int i = 0; i < count; ++i) {
-                            resultsText->append(QString("--- Вариант %1 ---\n").arg(i + 1));
-                            const auto& journey = uniqueJourneys[i];
-
-                            resultsText->append(QString("Пересадок: %1\n").arg(journey.getTransferCount()));
-                            resultsText->append(QString("Общее время в пути: %1 минут\n").arg(journey.getTotalDuration()));
-
-                            Time startTime = journey.getStartTime();
-                            Time endTime = journey.getEndTime();
-                            QString startTimeStr = QString("%1:%2")
-                                .arg(startTime.getHours(), 2, 10, QChar('0'))
-                                .arg(startTime.getMinutes(), 2, 10, QChar('0'));
-                            QString endTimeStr = QString("%1:%2")
-                                .arg(endTime.getHours(), 2, 10, QChar('0'))
-                                .arg(endTime.getMinutes(), 2, 10, QChar('0'));
-
-                            resultsText->append(QString("Время отправления: %1\n").arg(startTimeStr));
-                            resultsText->append(QString("Время прибытия: %1\n").arg(endTimeStr));
-
-                            const auto& trips = journey.getTrips();
-                            const auto& transferPoints = journey.getTransferPoints();
-
-                            resultsText->append("\nПуть:\n");
-                            resultsText->append("  " + stopA);
-
-                            for (size_t j = 0; j < trips.size(); ++j) {
-                                const auto& trip = trips[j];
-                                const auto& route = trip->getRoute();
-                                const auto& routeStops = route->getAllStops();
-
-                                // Определяем начальную и конечную остановки для этого участка
-                                std::string segmentStart = (j == 0) ? stopA.toStdString() : transferPoints[j - 1];
-                                std::string segmentEnd = (j < transferPoints.size()) ? transferPoints[j] : stopB.toStdString();
-
-                                int startPos = route->getStopPosition(segmentStart);
-                                int endPos = route->getStopPosition(segmentEnd);
-
-                                if (startPos != -1 && endPos != -1 && startPos < endPos) {
-                                    for (int k = startPos + 1; k <= endPos; ++k) {
-                                        resultsText->append(" → " + QString::fromStdString(routeStops[k]));
-                                    }
-                                }
-
-                                resultsText->append(QString(" [Маршрут %1 (%2)]")
-                                    .arg(route->getNumber())
-                                    .arg(QString::fromStdString(route->getVehicleType())));
-
-                                if (j < transferPoints.size()) {
-                                    resultsText->append(QString("\n  Пересадка на остановке: %1\n")
-                                        .arg(QString::fromStdString(transferPoints[j])));
-                                    resultsText->append("  " + QString::fromStdString(transferPoints[j]));
-                                }
-                            }
-                            resultsText->append("\n\n");
-                        }
-                        resultsText->append("========================================\n");
+                    // Добавляем только если такой комбинации еще не было
+                    if (dayMatches && seenRoutes.find(routeKey) == seenRoutes.end()) {
+                        seenRoutes.insert(routeKey);
+                        uniqueJourneys.push_back(journey);
+                    }
+                }
+
+                if (nearest.empty() && uniqueJourneys.empty()) {
+                    resultsText->append("Маршрутов с пересадками не найдено.\n");
+                } else if (!uniqueJourneys.empty()) {
+                    resultsText->append("========================================\n");
+                    resultsText->append("Варианты маршрутов с пересадками:\n");
+                    resultsText->append("========================================\n\n");
+
+                    // Показываем до 5 уникальных вариантов
+                    int count = std::min(5, static_cast<int>(uniqueJourneys.size()));
+                    for (int i = 0; i < count; ++i) {
+                        resultsText->append(QString("--- Вариант %1 ---\n").arg(i + 1));
+                        appendJourneyDetails(resultsText, uniqueJourneys[i], startName, endName);
                     }
                 }
             } catch (const std::exception& e) {
@@ -118,8 +118,10 @@ private:
     QTableWidget* vehiclesTable;
     QTableWidget* stopsTable;
     QTableWidget* driversTable;
+    QPushButton* saveButton;
     
     void setupUI();
+    void showSaveResult(const SaveResult& result);
     void refreshRoutesTable();
     void refreshTripsTable();
     void refreshVehiclesTable();
@@ -204,6 +206,8 @@ private:
     TransportSystem* transportSystem;
     QComboBox* stopAComboBox;
     QComboBox* stopBComboBox;
+    QTimeEdit* departureTimeEdit;
+    QComboBox* weekDayComboBox;
     QTextEdit* resultsText;
     void populateStops();
 };
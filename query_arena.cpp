@@ -0,0 +1,54 @@
+#include "query_arena.h"
+#include <algorithm>
+
+// Выделяет память из текущего блока; при нехватке места переходит к следующему
+// сохраненному блоку или запрашивает новый (не меньше запрошенного размера)
+void* QueryArena::do_allocate(size_t bytes, size_t alignment) {
+    while (currentBlock < blocks.size()) {
+        Block& block = blocks[currentBlock];
+        size_t base = reinterpret_cast<size_t>(block.data.get());
+        size_t aligned = (base + offset + alignment - 1) & ~(alignment - 1);
+        size_t newOffset = aligned - base + bytes;
+        if (newOffset <= block.size) {
+            offset = newOffset;
+            return reinterpret_cast<void*>(aligned);
+        }
+        ++currentBlock;
+        offset = 0;
+    }
+
+    // Каждый следующий блок не меньше предыдущего, чтобы число блоков росло логарифмически
+    size_t blockSize = std::max(DEFAULT_BLOCK_SIZE, bytes + alignment);
+    if (!blocks.empty()) {
+        blockSize = std::max(blockSize, blocks.back().size * 2);
+    }
+    blocks.push_back({std::unique_ptr<std::byte[]>(new std::byte[blockSize]), blockSize});
+    ++upstreamAllocations;
+    currentBlock = blocks.size() - 1;
+    offset = 0;
+    return do_allocate(bytes, alignment);
+}
+
+// Освобождение отдельных объектов не выполняется: память возвращается при reset()
+void QueryArena::do_deallocate(void*, size_t, size_t) {}
+
+bool QueryArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+void QueryArena::reset() {
+    currentBlock = 0;
+    offset = 0;
+}
+
+size_t QueryArena::getUpstreamAllocationCount() const {
+    return upstreamAllocations;
+}
+
+size_t QueryArena::getReservedBytes() const {
+    size_t total = 0;
+    for (const auto& block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
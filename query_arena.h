@@ -0,0 +1,47 @@
+#ifndef QUERY_ARENA_H
+#define QUERY_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+// Монотонный распределитель памяти для временных данных одного запроса
+// Выделение - сдвиг указателя внутри блока, освобождение отдельных объектов не выполняется.
+// reset() возвращает всю память разом, но сохраняет блоки, поэтому после "прогрева"
+// запрос не обращается к системному распределителю вовсе. Используется через std::pmr-контейнеры
+class QueryArena : public std::pmr::memory_resource {
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        size_t size;
+    };
+
+    std::vector<Block> blocks;      // Блоки памяти (сохраняются между запросами)
+    size_t currentBlock = 0;        // Блок, из которого идет выделение
+    size_t offset = 0;              // Смещение свободной памяти в текущем блоке
+    size_t upstreamAllocations = 0; // Сколько раз блоки запрашивались у системы
+
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+protected:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+public:
+    QueryArena() = default;
+    QueryArena(const QueryArena&) = delete;
+    QueryArena& operator=(const QueryArena&) = delete;
+
+    // Освободить всю выделенную память (блоки остаются для следующего запроса)
+    void reset();
+
+    // Количество обращений к системному распределителю за все время жизни арены
+    size_t getUpstreamAllocationCount() const;
+
+    // Суммарный размер блоков арены в байтах
+    size_t getReservedBytes() const;
+};
+
+#endif // QUERY_ARENA_H
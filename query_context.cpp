@@ -0,0 +1,67 @@
+#include "query_context.h"
+
+void MarkedSet::reset(size_t size) {
+    clear();
+    size_t words = (size + 63) / 64;
+    if (bits.size() < words) {
+        bits.resize(words, 0);
+    }
+}
+
+bool MarkedSet::mark(int index) {
+    uint64_t& word = bits[static_cast<size_t>(index) >> 6];
+    uint64_t bit = uint64_t(1) << (index & 63);
+    if (word & bit) {
+        return false;
+    }
+    word |= bit;
+    marked.push_back(index);
+    return true;
+}
+
+bool MarkedSet::isMarked(int index) const {
+    return (bits[static_cast<size_t>(index) >> 6] >> (index & 63)) & 1;
+}
+
+const std::vector<int>& MarkedSet::getMarked() const {
+    return marked;
+}
+
+// Снимает отметки только с отмеченных остановок
+void MarkedSet::clear() {
+    for (int index : marked) {
+        bits[static_cast<size_t>(index) >> 6] = 0;
+    }
+    marked.clear();
+}
+
+bool MarkedSet::empty() const {
+    return marked.empty();
+}
+
+// Подготавливает контекст к новому запросу
+// Выделение памяти происходит только при росте сети; сброс меток - за O(1)
+void QueryContext::beginQuery(size_t labelCount, size_t stopCount, int defaultLabel) {
+    labels.reset(labelCount, defaultLabel);
+    markedStops.reset(stopCount);
+    queue.clear();
+    arena.reset();
+}
+
+// Возвращает контекст текущего потока (создается при первом обращении)
+QueryContext& QueryContext::forCurrentThread() {
+    thread_local QueryContext context;
+    return context;
+}
+
+QueryContextLease::QueryContextLease() : context(&QueryContext::forCurrentThread()) {
+    if (context->inUse) {
+        fallback = std::make_unique<QueryContext>();
+        context = fallback.get();
+    }
+    context->inUse = true;
+}
+
+QueryContextLease::~QueryContextLease() {
+    context->inUse = false;
+}
@@ -0,0 +1,130 @@
+#ifndef QUERY_CONTEXT_H
+#define QUERY_CONTEXT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "query_arena.h"
+
+// Массив меток со сбросом за O(1)
+// Каждой метке сопоставлен номер эпохи, в которой она была записана. Метка действительна,
+// только если ее эпоха совпадает с текущей, поэтому сброс всего массива - это
+// увеличение счетчика эпох, а не проход по всем элементам
+template<typename T>
+class StampedArray {
+private:
+    std::vector<T> values;          // Значения меток
+    std::vector<uint32_t> stamps;   // Эпоха, в которой записана каждая метка
+    uint32_t epoch = 1;             // Текущая эпоха (0 означает "никогда не записывалась")
+    T defaultValue{};               // Значение непроставленной метки
+
+public:
+    // Подготовить массив к новому запросу: не менее size меток, все равны defaultVal
+    void reset(size_t size, const T& defaultVal) {
+        if (values.size() < size) {
+            values.resize(size);
+            stamps.resize(size, 0);
+        }
+        defaultValue = defaultVal;
+        // При переполнении счетчика эпох один раз выполняем полную очистку
+        if (++epoch == 0) {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 1;
+        }
+    }
+
+    // Проставлена ли метка в текущем запросе
+    bool isSet(size_t index) const {
+        return stamps[index] == epoch;
+    }
+
+    // Получить метку (или значение по умолчанию, если она не проставлена)
+    const T& get(size_t index) const {
+        return stamps[index] == epoch ? values[index] : defaultValue;
+    }
+
+    // Записать метку
+    void set(size_t index, const T& value) {
+        values[index] = value;
+        stamps[index] = epoch;
+    }
+
+    size_t size() const {
+        return values.size();
+    }
+};
+
+// Множество отмеченных остановок
+// Битовая маска для проверки за O(1) и список отмеченных номеров, поэтому очистка
+// стоит O(количества отмеченных), а не O(количества остановок)
+class MarkedSet {
+private:
+    std::vector<uint64_t> bits;   // Битовая маска отмеченных остановок
+    std::vector<int> marked;      // Отмеченные остановки в порядке отметки
+
+public:
+    // Подготовить множество к сети из size остановок и очистить его
+    void reset(size_t size);
+
+    // Отметить остановку; возвращает true, если она не была отмечена ранее
+    bool mark(int index);
+
+    // Проверить, отмечена ли остановка
+    bool isMarked(int index) const;
+
+    // Список отмеченных остановок в порядке отметки
+    const std::vector<int>& getMarked() const;
+
+    // Снять все отметки
+    void clear();
+
+    bool empty() const;
+};
+
+// Рабочая память запроса к планировщику
+// Один контекст принадлежит одному потоку и переиспользуется между вызовами JourneyPlanner:
+// массивы меток, очередь и отмеченные остановки не выделяются заново для каждого запроса,
+// а сбрасываются за O(1), поэтому небольшой запрос на большой сети стоит
+// пропорционально той части сети, которую он затронул.
+// Остальные временные данные запроса (узлы поиска, кучи, списки) размещаются в арене
+class QueryContext {
+public:
+    StampedArray<int> labels;    // Метки остановок (например, время прибытия или признак посещения)
+    MarkedSet markedStops;       // Отмеченные остановки
+    std::vector<int> queue;      // Очередь номеров остановок/узлов
+    QueryArena arena;            // Арена для временных данных запроса (сбрасывается в beginQuery)
+
+    // Подготовить контекст к новому запросу
+    // labelCount - количество меток (например, остановки x раунды), stopCount - количество остановок
+    void beginQuery(size_t labelCount, size_t stopCount, int defaultLabel);
+
+    // Контекст текущего потока
+    static QueryContext& forCurrentThread();
+
+private:
+    bool inUse = false;   // Контекст занят запросом (для обнаружения вложенных вызовов)
+
+    friend class QueryContextLease;
+};
+
+// Захват контекста запроса на время вызова планировщика
+// Берет контекст текущего потока; если он уже занят (вложенный вызов планировщика
+// в том же потоке), создает временный контекст, чтобы не испортить метки внешнего запроса
+class QueryContextLease {
+private:
+    QueryContext* context;
+    std::unique_ptr<QueryContext> fallback;   // Временный контекст для вложенного вызова
+
+public:
+    QueryContextLease();
+    ~QueryContextLease();
+
+    QueryContextLease(const QueryContextLease&) = delete;
+    QueryContextLease& operator=(const QueryContextLease&) = delete;
+
+    QueryContext& operator*() const { return *context; }
+    QueryContext* operator->() const { return context; }
+};
+
+#endif // QUERY_CONTEXT_H
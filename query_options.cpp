@@ -0,0 +1,86 @@
+#include "query_options.h"
+
+// Создает токен с собственным флагом отмены
+CancellationToken CancellationToken::create() {
+    CancellationToken token;
+    token.flag = std::make_shared<std::atomic<bool>>(false);
+    return token;
+}
+
+// Запрашивает отмену запроса
+void CancellationToken::cancel() {
+    if (flag) {
+        flag->store(true, std::memory_order_relaxed);
+    }
+}
+
+// Проверяет, была ли запрошена отмена
+bool CancellationToken::isCancelled() const {
+    return flag && flag->load(std::memory_order_relaxed);
+}
+
+// Создает параметры запроса с крайним сроком через timeout от текущего момента
+QueryOptions QueryOptions::withTimeout(std::chrono::milliseconds timeout) {
+    QueryOptions options;
+    options.deadline = std::chrono::steady_clock::now() + timeout;
+    return options;
+}
+
+QueryGuard::QueryGuard(const QueryOptions& opts) : options(opts) {}
+
+// Учитывает обработку очередного узла и проверяет ограничения запроса
+bool QueryGuard::step() {
+    if (truncated) {
+        return false;
+    }
+    if (options.maxLabels != 0 && labels >= options.maxLabels) {
+        truncated = true;
+        return false;
+    }
+    if (options.cancellation.isCancelled()) {
+        truncated = true;
+        return false;
+    }
+    // Обращение к часам дороже остальных проверок, поэтому выполняется периодически
+    if (labels % CLOCK_CHECK_INTERVAL == 0 &&
+        options.deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= options.deadline) {
+        truncated = true;
+        return false;
+    }
+    ++labels;
+    return true;
+}
+
+// Учитывает обработку блока из count узлов
+// Как и step(), разрешает блок, пока бюджет не исчерпан (последний блок может его превысить)
+bool QueryGuard::step(size_t count) {
+    if (truncated) {
+        return false;
+    }
+    if (options.maxLabels != 0 && labels >= options.maxLabels) {
+        truncated = true;
+        return false;
+    }
+    if (options.cancellation.isCancelled()) {
+        truncated = true;
+        return false;
+    }
+    bool clockDue = labels == 0 || labels / CLOCK_CHECK_INTERVAL != (labels + count) / CLOCK_CHECK_INTERVAL;
+    if (clockDue &&
+        options.deadline != std::chrono::steady_clock::time_point::max() &&
+        std::chrono::steady_clock::now() >= options.deadline) {
+        truncated = true;
+        return false;
+    }
+    labels += count;
+    return true;
+}
+
+bool QueryGuard::isTruncated() const {
+    return truncated;
+}
+
+size_t QueryGuard::getLabelCount() const {
+    return labels;
+}
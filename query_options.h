@@ -0,0 +1,80 @@
+#ifndef QUERY_OPTIONS_H
+#define QUERY_OPTIONS_H
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include "list.h"
+#include "journey.h"
+
+// Токен отмены запроса
+// Копии токена разделяют один флаг: отмена через любую копию видна всем.
+// Токен, созданный конструктором по умолчанию, пуст и не может быть отменен
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool>> flag;  // Общий флаг отмены (nullptr для пустого токена)
+
+public:
+    CancellationToken() = default;
+
+    // Создать новый токен, который можно отменить
+    static CancellationToken create();
+
+    // Запросить отмену (для пустого токена ничего не делает)
+    void cancel();
+
+    // Проверить, была ли запрошена отмена
+    bool isCancelled() const;
+};
+
+// Параметры выполнения запроса к планировщику
+// Ограничивают время и объем работы одного запроса, чтобы тяжелый запрос
+// (например, к удаленной паре остановок с большим числом пересадок) не занимал ядро надолго
+struct QueryOptions {
+    // Крайний срок выполнения (по умолчанию - без ограничения)
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    // Максимальное количество обработанных узлов/меток (0 - без ограничения)
+    size_t maxLabels = 0;
+    // Токен отмены
+    CancellationToken cancellation;
+
+    // Создать параметры с крайним сроком "сейчас + timeout"
+    static QueryOptions withTimeout(std::chrono::milliseconds timeout);
+};
+
+// Контроль ограничений запроса во время поиска
+// Планировщик вызывает step() перед обработкой каждого узла и прекращает поиск,
+// если метод вернул false. Часы опрашиваются не на каждом шаге, а раз в CLOCK_CHECK_INTERVAL шагов
+class QueryGuard {
+private:
+    const QueryOptions& options;
+    size_t labels = 0;         // Количество обработанных узлов
+    bool truncated = false;    // Поиск был прерван
+    static const size_t CLOCK_CHECK_INTERVAL = 64;
+
+public:
+    explicit QueryGuard(const QueryOptions& opts);
+
+    // Учесть обработку очередного узла
+    // Возвращает false, если исчерпан бюджет, истек крайний срок или запрошена отмена
+    bool step();
+
+    // Учесть обработку сразу count узлов (например, блока соединений при сканировании)
+    // Часы опрашиваются, если счетчик перешел через границу CLOCK_CHECK_INTERVAL
+    bool step(size_t count);
+
+    // Был ли поиск прерван до завершения
+    bool isTruncated() const;
+
+    // Количество обработанных узлов
+    size_t getLabelCount() const;
+};
+
+// Результат запроса с ограничениями
+// Если truncated == true, journeys содержит лучшие маршруты, найденные до прерывания поиска
+struct QueryResult {
+    List<Journey> journeys;
+    bool truncated = false;
+};
+
+#endif // QUERY_OPTIONS_H
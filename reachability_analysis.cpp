@@ -0,0 +1,105 @@
+#include "reachability_analysis.h"
+#include "thread_pool.h"
+#include <algorithm>
+
+ReachabilityAnalysis::ReachabilityAnalysis(std::shared_ptr<const TimetableIndex> timetableIndex,
+                                           int transfersLimit,
+                                           size_t threads)
+    : index(std::move(timetableIndex)),
+      maxTransfers(std::max(transfersLimit, 0)),
+      stopCount(index->getStopCount()) {
+    size_t batchCount = (stopCount + BATCH_SIZE - 1) / BATCH_SIZE;
+    table.assign(batchCount * stopCount, 0);
+
+    size_t threadCount = threads == 0 ? ThreadPool::shared().getThreadCount() + 1 : threads;
+    if (threadCount <= 1 || batchCount <= 1) {
+        for (size_t batch = 0; batch < batchCount; ++batch) {
+            analyzeBatch(batch);
+        }
+    } else {
+        // Пачки независимы и пишут в свои части таблицы
+        ThreadPool::shared().parallelFor(batchCount, [this](size_t batch) { analyzeBatch(batch); },
+                                         threadCount);
+    }
+}
+
+// Раунд - одна поездка: вдоль каждого маршрута накапливается маска поисков, которые могут
+// сесть на него на уже пройденных остановках (новые в прошлом раунде), и она добавляется
+// ко всем следующим остановкам маршрута. Пересадка на другой маршрут возможна только
+// в пересадочном узле, а в остальных остановках других маршрутов нет, поэтому отдельная
+// проверка не нужна
+void ReachabilityAnalysis::analyzeBatch(size_t batch) {
+    uint64_t* reach = &table[batch * stopCount];
+    std::vector<uint64_t> frontier(stopCount, 0);
+    std::vector<uint64_t> next(stopCount, 0);
+
+    size_t first = batch * BATCH_SIZE;
+    size_t last = std::min(first + BATCH_SIZE, stopCount);
+    for (size_t origin = first; origin < last; ++origin) {
+        uint64_t bit = uint64_t(1) << (origin - first);
+        reach[origin] |= bit;
+        frontier[origin] |= bit;
+    }
+
+    for (int ride = 0; ride <= maxTransfers; ++ride) {
+        std::fill(next.begin(), next.end(), 0);
+        for (size_t route = 0; route < index->getRouteCount(); ++route) {
+            uint64_t carry = 0;
+            for (int stop : index->getRouteStops(static_cast<int>(route))) {
+                next[stop] |= carry;
+                carry |= frontier[stop];
+            }
+        }
+
+        bool changed = false;
+        for (size_t stop = 0; stop < stopCount; ++stop) {
+            frontier[stop] = next[stop] & ~reach[stop];
+            reach[stop] |= frontier[stop];
+            changed = changed || frontier[stop] != 0;
+        }
+        if (!changed) {
+            break;
+        }
+    }
+}
+
+int ReachabilityAnalysis::getMaxTransfers() const {
+    return maxTransfers;
+}
+
+bool ReachabilityAnalysis::canReach(int from, int to) const {
+    uint64_t mask = table[(static_cast<size_t>(from) / BATCH_SIZE) * stopCount + static_cast<size_t>(to)];
+    return (mask >> (static_cast<size_t>(from) % BATCH_SIZE)) & 1;
+}
+
+bool ReachabilityAnalysis::canReach(const std::string& from, const std::string& to) const {
+    int fromStop = index->getStopIndex(from);
+    int toStop = index->getStopIndex(to);
+    return fromStop >= 0 && toStop >= 0 && canReach(fromStop, toStop);
+}
+
+size_t ReachabilityAnalysis::getReachableCount(int from) const {
+    const uint64_t* masks = &table[(static_cast<size_t>(from) / BATCH_SIZE) * stopCount];
+    uint64_t bit = uint64_t(1) << (static_cast<size_t>(from) % BATCH_SIZE);
+    size_t count = 0;
+    for (size_t stop = 0; stop < stopCount; ++stop) {
+        if (masks[stop] & bit) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+List<std::string> ReachabilityAnalysis::getReachableStops(const std::string& from) const {
+    List<std::string> result;
+    int fromStop = index->getStopIndex(from);
+    if (fromStop < 0) {
+        return result;
+    }
+    for (size_t stop = 0; stop < stopCount; ++stop) {
+        if (canReach(fromStop, static_cast<int>(stop))) {
+            result.push_back(index->getStopName(static_cast<int>(stop)));
+        }
+    }
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef REACHABILITY_ANALYSIS_H
+#define REACHABILITY_ANALYSIS_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "list.h"
+#include "timetable_index.h"
+
+// Достижимость остановок между собой с ограничением числа пересадок (анализ сети)
+// Учитываются только последовательности остановок маршрутов, без расписания: остановка B
+// достижима из A, если из A до B можно доехать по маршрутам, сделав не больше maxTransfers
+// пересадок. Остановка достижима сама из себя.
+// Начальные остановки обрабатываются пачками по 64: для каждой остановки хранится 64-битная
+// маска начальных остановок пачки, из которых она достижима, и за один проход по маршруту
+// распространяются сразу все 64 поиска
+class ReachabilityAnalysis {
+private:
+    std::shared_ptr<const TimetableIndex> index;
+    int maxTransfers;
+    size_t stopCount;
+    // Маски достижимости: для пачки b и остановки s - слово table[b * stopCount + s],
+    // бит i которого означает, что s достижима из остановки b * 64 + i
+    std::vector<uint64_t> table;
+
+    // Обработать пачку начальных остановок
+    void analyzeBatch(size_t batch);
+
+public:
+    // Размер пачки начальных остановок (разрядность маски)
+    static const size_t BATCH_SIZE = 64;
+
+    // Построить таблицу достижимости для всех остановок индекса
+    // threads - число потоков для параллельной обработки пачек (0 - все ядра)
+    ReachabilityAnalysis(std::shared_ptr<const TimetableIndex> timetableIndex,
+                         int maxTransfers = 2,
+                         size_t threads = 1);
+
+    int getMaxTransfers() const;
+
+    // Достижима ли остановка to из остановки from
+    bool canReach(int from, int to) const;
+    bool canReach(const std::string& from, const std::string& to) const;
+
+    // Количество остановок, достижимых из from (включая саму from)
+    size_t getReachableCount(int from) const;
+
+    // Названия остановок, достижимых из from
+    List<std::string> getReachableStops(const std::string& from) const;
+};
+
+#endif // REACHABILITY_ANALYSIS_H
@@ -0,0 +1,126 @@
+#include "record_parser.h"
+#include "exceptions.h"
+#include <charconv>
+#include <string>
+#include <system_error>
+
+FieldSplitter::FieldSplitter(std::string_view data, char delimiter)
+    : rest(data), delimiter(delimiter), finished(data.empty()) {}
+
+bool FieldSplitter::next(std::string_view& field) {
+    if (finished) {
+        field = {};
+        return false;
+    }
+    size_t pos = rest.find(delimiter);
+    if (pos == std::string_view::npos) {
+        field = rest;
+        rest = {};
+        finished = true;
+    } else {
+        field = rest.substr(0, pos);
+        rest.remove_prefix(pos + 1);
+        // Разделитель в конце записи не открывает нового поля
+        finished = rest.empty();
+    }
+    return true;
+}
+
+std::string_view FieldSplitter::next() {
+    std::string_view field;
+    next(field);
+    return field;
+}
+
+std::string_view FieldSplitter::remainder() {
+    if (finished) {
+        return {};
+    }
+    std::string_view result = rest;
+    rest = {};
+    finished = true;
+    return result;
+}
+
+RecordFields::RecordFields(std::string_view record, char delimiter) {
+    FieldSplitter splitter(record, delimiter);
+    std::string_view field;
+    while (splitter.next(field)) {
+        if (count < MAX_FIELDS) {
+            fields[count] = field;
+        }
+        ++count;
+    }
+}
+
+size_t RecordFields::size() const {
+    return count;
+}
+
+std::string_view RecordFields::operator[](size_t index) const {
+    return index < count && index < MAX_FIELDS ? fields[index] : std::string_view();
+}
+
+std::string_view RecordFields::join(size_t first, size_t last) const {
+    std::string_view begin = (*this)[first];
+    std::string_view end = (*this)[last];
+    return std::string_view(begin.data(), end.data() + end.size() - begin.data());
+}
+
+std::string_view RecordParser::trim(std::string_view text, std::string_view spaces) {
+    size_t begin = text.find_first_not_of(spaces);
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(spaces);
+    return text.substr(begin, end - begin + 1);
+}
+
+// Начало числа: пропускает пробелы и знак '+', который std::from_chars не принимает
+static const char* numberStart(std::string_view text) {
+    const char* first = text.data();
+    const char* last = first + text.size();
+    while (first != last && (*first == ' ' || (*first >= '\t' && *first <= '\r'))) {
+        ++first;
+    }
+    if (first != last && *first == '+' && (first + 1 == last || first[1] != '-')) {
+        ++first;
+    }
+    return first;
+}
+
+bool RecordParser::tryParseInt(std::string_view text, int& value) {
+    int result = 0;
+    auto [ptr, error] = std::from_chars(numberStart(text), text.data() + text.size(), result);
+    if (error != std::errc()) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+bool RecordParser::tryParseDouble(std::string_view text, double& value) {
+    double result = 0.0;
+    auto [ptr, error] = std::from_chars(numberStart(text), text.data() + text.size(), result);
+    if (error != std::errc()) {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+int RecordParser::parseInt(std::string_view text) {
+    int value = 0;
+    if (!tryParseInt(text, value)) {
+        throw InputException("Некорректное целое число: " + std::string(text));
+    }
+    return value;
+}
+
+double RecordParser::parseDouble(std::string_view text) {
+    double value = 0.0;
+    if (!tryParseDouble(text, value)) {
+        throw InputException("Некорректное число: " + std::string(text));
+    }
+    return value;
+}
@@ -0,0 +1,73 @@
+#ifndef RECORD_PARSER_H
+#define RECORD_PARSER_H
+
+#include <cstddef>
+#include <string_view>
+
+// Разбор записей текстовых файлов данных без копирования строки
+// Поля - представления (std::string_view) исходной строки, числа разбираются std::from_chars,
+// поэтому память выделяется только под значения, которые сохраняются в объектах
+
+// Последовательное чтение полей записи "a|b|c"
+// Повторяет std::getline с разделителем: пустые поля внутри записи сохраняются,
+// пустое поле после последнего разделителя не возвращается
+class FieldSplitter {
+private:
+    std::string_view rest;
+    char delimiter;
+    bool finished;
+
+public:
+    FieldSplitter(std::string_view data, char delimiter);
+
+    // Следующее поле; false (и пустое поле), если поля закончились
+    bool next(std::string_view& field);
+
+    // Следующее поле или пустое представление, если поля закончились
+    std::string_view next();
+
+    // Вся оставшаяся часть записи вместе с разделителями (как std::getline без разделителя)
+    std::string_view remainder();
+};
+
+// Все поля записи с доступом по номеру (до MAX_FIELDS полей без выделения памяти)
+class RecordFields {
+public:
+    static const size_t MAX_FIELDS = 32;
+
+private:
+    std::string_view fields[MAX_FIELDS];
+    size_t count = 0;
+
+public:
+    explicit RecordFields(std::string_view record, char delimiter = '|');
+
+    // Количество полей; поля сверх MAX_FIELDS учитываются, но не сохраняются
+    size_t size() const;
+
+    // Поле по номеру; пустое представление, если такого поля нет
+    std::string_view operator[](size_t index) const;
+
+    // Часть записи от начала поля first до конца поля last включительно
+    std::string_view join(size_t first, size_t last) const;
+};
+
+// Числа и пробелы в полях
+class RecordParser {
+public:
+    // Убрать символы spaces в начале и конце
+    static std::string_view trim(std::string_view text, std::string_view spaces = " \t");
+
+    // Целое число, как std::stoi: пробелы в начале и знак допускаются, остаток после числа
+    // игнорируется. Выбрасывает InputException, если числа нет или оно вне диапазона int
+    static int parseInt(std::string_view text);
+
+    // Вещественное число по тем же правилам, что parseInt
+    static double parseDouble(std::string_view text);
+
+    // То же без исключений: false, если число не разобрано (value не меняется)
+    static bool tryParseInt(std::string_view text, int& value);
+    static bool tryParseDouble(std::string_view text, double& value);
+};
+
+#endif // RECORD_PARSER_H
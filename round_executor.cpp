@@ -0,0 +1,162 @@
+#include "round_executor.h"
+#include "exceptions.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <limits>
+
+RoundExecutor::RoundExecutor(const TimetableIndex& timetableIndex, int weekDayFilter, size_t threads)
+    : index(timetableIndex),
+      patterns(timetableIndex.getPatterns()),
+      weekDay(weekDayFilter),
+      threadCount(threads == 0 ? ThreadPool::shared().getThreadCount() + 1 : threads),
+      roundKeys(timetableIndex.getStopCount()),
+      bestBefore(timetableIndex.getStopCount(), std::numeric_limits<int>::max()),
+      boardable(timetableIndex.getStopCount(), 0),
+      firstPosition(patterns.getPatternCount(), -1) {
+    // Ограничения упаковки метки
+    if (index.getTripCount() >= (size_t(1) << 24) || index.getStopCount() >= (size_t(1) << 24)) {
+        throw ContainerException("Слишком большая сеть для поиска по маршрутам");
+    }
+    for (auto& key : roundKeys) {
+        key.store(EMPTY_KEY, std::memory_order_relaxed);
+    }
+}
+
+uint64_t RoundExecutor::packLabel(int arrival, int trip, int boardStop) {
+    return (static_cast<uint64_t>(arrival) << 48) |
+           (static_cast<uint64_t>(trip) << 24) |
+           static_cast<uint64_t>(boardStop);
+}
+
+JourneyTree::Label RoundExecutor::unpackLabel(uint64_t key) {
+    JourneyTree::Label label;
+    label.arrival = static_cast<int>(key >> 48);
+    label.trip = static_cast<int>((key >> 24) & 0xFFFFFF);
+    label.boardStop = static_cast<int>(key & 0xFFFFFF);
+    return label;
+}
+
+bool RoundExecutor::atomicMin(std::atomic<uint64_t>& target, uint64_t value) {
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current) {
+        if (target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+            return current == EMPTY_KEY;
+        }
+    }
+    return false;
+}
+
+// Просмотр шаблона
+// Едем на текущем рейсе (номер в шаблоне) и на каждой остановке:
+// 1) если рейс выбран - пробуем улучшить время прибытия на остановку;
+// 2) если с остановки можно сесть (она улучшена в прошлом раунде) - ищем более ранний рейс,
+//    на который можно успеть; рейсы шаблона не обгоняют друг друга, поэтому более ранний
+//    рейс везде прибывает не позже текущего
+void RoundExecutor::scanPattern(int pattern, int start, const JourneyTree::Label* previous,
+                                std::vector<int>& improved) {
+    auto stops = patterns.getStops(pattern);
+    auto trips = patterns.getTrips(pattern);
+    size_t current = trips.size();
+    int boardStop = -1;
+
+    for (size_t i = static_cast<size_t>(start); i < stops.size(); ++i) {
+        int stop = stops[i];
+        auto column = patterns.getTimes(pattern, static_cast<int>(i));
+
+        if (current < trips.size()) {
+            int arrival = column[current];
+            if (arrival < bestBefore[stop] &&
+                atomicMin(roundKeys[stop], packLabel(arrival, trips[current], boardStop))) {
+                improved.push_back(stop);
+            }
+        }
+
+        if (boardable[stop]) {
+            size_t candidate = RoutePatterns::findFirstTrip(column, previous[stop].arrival);
+            if (candidate < current) {
+                current = candidate;
+                boardStop = stop;
+            }
+        }
+    }
+}
+
+void RoundExecutor::run(std::vector<JourneyTree::Label>& labels, int rounds, const std::vector<int>& startStops) {
+    size_t stopCount = index.getStopCount();
+    std::vector<int> marked;
+    for (int stop : startStops) {
+        if (!boardable[stop]) {
+            boardable[stop] = 1;
+            marked.push_back(stop);
+        }
+        bestBefore[stop] = std::min(bestBefore[stop], labels[stop].arrival);
+    }
+
+    std::vector<int> queued;
+    std::vector<std::vector<int>> improved;
+
+    for (int round = 1; round < rounds && !marked.empty(); ++round) {
+        const JourneyTree::Label* previous = &labels[static_cast<size_t>(round - 1) * stopCount];
+        JourneyTree::Label* current = &labels[static_cast<size_t>(round) * stopCount];
+
+        // Шаблоны для просмотра и первая позиция каждого (самая ранняя из отмеченных остановок)
+        queued.clear();
+        for (int stop : marked) {
+            for (const auto& entry : patterns.getStopPatterns(stop)) {
+                if (weekDay != 0 && patterns.getWeekDay(entry.pattern) != weekDay) {
+                    continue;
+                }
+                int& first = firstPosition[entry.pattern];
+                if (first == -1) {
+                    queued.push_back(entry.pattern);
+                    first = entry.position;
+                } else {
+                    first = std::min(first, entry.position);
+                }
+            }
+        }
+        std::sort(queued.begin(), queued.end());
+
+        // Параллельный просмотр шаблонов; завершение parallelFor - барьер раунда
+        size_t chunkCount = (threadCount <= 1 || queued.size() < PARALLEL_MIN_PATTERNS)
+            ? 1
+            : std::min(queued.size(), threadCount * CHUNKS_PER_THREAD);
+        if (improved.size() < chunkCount) {
+            improved.resize(chunkCount);
+        }
+        auto scanChunk = [&](size_t chunk) {
+            size_t first = queued.size() * chunk / chunkCount;
+            size_t last = queued.size() * (chunk + 1) / chunkCount;
+            improved[chunk].clear();
+            for (size_t j = first; j < last; ++j) {
+                scanPattern(queued[j], firstPosition[queued[j]], previous, improved[chunk]);
+            }
+        };
+        if (chunkCount == 1) {
+            scanChunk(0);
+        } else {
+            ThreadPool::shared().parallelFor(chunkCount, scanChunk, threadCount);
+        }
+
+        // Перенос меток раунда и подготовка следующего раунда (последовательно)
+        for (int pattern : queued) {
+            firstPosition[pattern] = -1;
+        }
+        for (int stop : marked) {
+            boardable[stop] = 0;
+        }
+        marked.clear();
+        for (size_t chunk = 0; chunk < chunkCount; ++chunk) {
+            for (int stop : improved[chunk]) {
+                current[stop] = unpackLabel(roundKeys[stop].load(std::memory_order_relaxed));
+                roundKeys[stop].store(EMPTY_KEY, std::memory_order_relaxed);
+                bestBefore[stop] = current[stop].arrival;
+                // Пересесть на другой рейс можно только в пересадочном узле
+                if (index.isInterchange(stop)) {
+                    boardable[stop] = 1;
+                    marked.push_back(stop);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef ROUND_EXECUTOR_H
+#define ROUND_EXECUTOR_H
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "journey_tree.h"
+#include "timetable_index.h"
+
+// Исполнитель раундов поиска по маршрутам
+// В раунде k просматриваются шаблоны маршрутов, проходящие через остановки, улучшенные
+// в раунде k-1: по шаблону едем на самом раннем рейсе, на который можно успеть, и обновляем
+// время прибытия на последующие остановки. Шаблоны одного раунда независимы, поэтому
+// раунд может выполняться несколькими потоками: шаблоны делятся между потоками, метки
+// остановок обновляются атомарным минимумом, а завершение parallelFor служит барьером
+// между раундами. Результат не зависит от количества потоков и порядка их работы
+class RoundExecutor {
+private:
+    const TimetableIndex& index;
+    const RoutePatterns& patterns;
+    int weekDay;            // День недели (0 - все дни)
+    size_t threadCount;     // Количество потоков (1 - последовательное выполнение, 0 - все ядра)
+
+    // Шаблонов в раунде меньше этого числа - раунд выполняется одним потоком
+    static const size_t PARALLEL_MIN_PATTERNS = 32;
+    // Частей раунда на поток (для выравнивания нагрузки)
+    static const size_t CHUNKS_PER_THREAD = 4;
+
+    // Упакованная метка раунда: время прибытия (16 бит), рейс (24 бита), остановка посадки (24 бита)
+    // Сравнение упакованных значений - сравнение по времени, затем по рейсу и остановке,
+    // поэтому атомарный минимум выбирает одну и ту же метку при любом порядке обновлений
+    static const uint64_t EMPTY_KEY = ~uint64_t(0);
+    static uint64_t packLabel(int arrival, int trip, int boardStop);
+    static JourneyTree::Label unpackLabel(uint64_t key);
+
+    // Атомарно уменьшить значение; возвращает true, если значение было пустым (первое обновление)
+    static bool atomicMin(std::atomic<uint64_t>& target, uint64_t value);
+
+    // Метки текущего раунда и лучшее время прибытия по предыдущим раундам
+    std::vector<std::atomic<uint64_t>> roundKeys;
+    std::vector<int> bestBefore;
+    // Остановки, улучшенные в предыдущем раунде (с них можно сесть на рейс)
+    std::vector<unsigned char> boardable;
+    // Первая позиция, с которой нужно просматривать шаблон в текущем раунде
+    std::vector<int> firstPosition;
+
+    // Просмотр шаблона с позиции start; улучшенные впервые в раунде остановки добавляются в improved
+    void scanPattern(int pattern, int start, const JourneyTree::Label* previous,
+                     std::vector<int>& improved);
+
+public:
+    RoundExecutor(const TimetableIndex& timetableIndex, int weekDay, size_t threads);
+
+    // Выполнить раунды 1..rounds-1
+    // labels - метки (раунд * количество остановок + остановка) с заполненным раундом 0,
+    // startStops - остановки раунда 0
+    void run(std::vector<JourneyTree::Label>& labels, int rounds, const std::vector<int>& startStops);
+};
+
+#endif // ROUND_EXECUTOR_H
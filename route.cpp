@@ -1,5 +1,5 @@
 #include "route.h"
-#include <sstream>
+#include "record_parser.h"
 
 // Конструктор маршрута
 // Первая остановка становится начальной, последняя - конечной
@@ -95,34 +95,33 @@ std::string Route::serialize() const {
 
 // Десериализация маршрута из строки
 // Если дни недели не указаны, используется значение по умолчанию (все дни недели)
-std::shared_ptr<Route> Route::deserialize(const std::string& data) {
-    std::istringstream ss(data);
-    std::string numberStr, vehicleType, stopsStr, daysStr;
-    std::getline(ss, numberStr, '|');    // Номер маршрута
-    std::getline(ss, vehicleType, '|');   // Тип транспорта
-    std::getline(ss, stopsStr, '|');     // Список остановок
-    std::getline(ss, daysStr);           // Дни недели
+std::shared_ptr<Route> Route::deserialize(std::string_view data) {
+    FieldSplitter fields(data, '|');
+    std::string_view numberStr = fields.next();    // Номер маршрута
+    std::string_view vehicleType = fields.next();  // Тип транспорта
+    std::string_view stopsStr = fields.next();     // Список остановок
+    std::string_view daysStr = fields.remainder(); // Дни недели
 
     // Парсим остановки (разделены точкой с запятой)
     List<std::string> stops;
-    std::istringstream stopsStream(stopsStr);
-    std::string stop;
-    while (std::getline(stopsStream, stop, ';')) {
-        stops.push_back(stop);
+    FieldSplitter stopFields(stopsStr, ';');
+    std::string_view stop;
+    while (stopFields.next(stop)) {
+        stops.push_back(std::string(stop));
     }
 
     // Парсим дни недели (разделены запятой)
     std::set<int> weekDays;
     if (!daysStr.empty()) {
-        std::istringstream daysStream(daysStr);
-        std::string day;
-        while (std::getline(daysStream, day, ',')) {
-            weekDays.insert(std::stoi(day));
+        FieldSplitter dayFields(daysStr, ',');
+        std::string_view day;
+        while (dayFields.next(day)) {
+            weekDays.insert(RecordParser::parseInt(day));
         }
     } else {
         // По умолчанию - все дни недели
         weekDays = {1,2,3,4,5,6,7};
     }
 
-    return std::make_shared<Route>(std::stoi(numberStr), vehicleType, stops, weekDays);
+    return std::make_shared<Route>(RecordParser::parseInt(numberStr), std::string(vehicleType), stops, weekDays);
 }
\ No newline at end of file
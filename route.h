@@ -2,6 +2,7 @@
 #define ROUTE_H
 
 #include <string>
+#include <string_view>
 #include <set>
 #include <memory>
 #include <algorithm>
@@ -50,7 +51,7 @@ public:
     std::string serialize() const;
 
     // Десериализация маршрута из строки
-    static std::shared_ptr<Route> deserialize(const std::string& data);
+    static std::shared_ptr<Route> deserialize(std::string_view data);
 };
 
 #endif // ROUTE_H
\ No newline at end of file
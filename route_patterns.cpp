@@ -0,0 +1,216 @@
+#include "route_patterns.h"
+#include "timetable_index.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <map>
+#include <tuple>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ROUTE_PATTERNS_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ROUTE_PATTERNS_SSE2 1
+#endif
+
+// Построение шаблонов
+// 1. Рейсы группируются по (маршрут, день недели, остановки с известным временем).
+// 2. Внутри группы рейсы сортируются по времени на первой остановке и жадно раскладываются
+//    по шаблонам: рейс добавляется в первый шаблон, последний рейс которого ни в одной
+//    позиции не позже него; иначе создается новый шаблон
+void RoutePatterns::build(const TimetableIndex& index) {
+    using GroupKey = std::tuple<int, int, std::vector<int>>;
+    std::map<GroupKey, std::vector<int>> groups;
+    // Времена рейсов в остановках группы (для каждого рейса - в порядке его остановок)
+    std::vector<std::vector<int>> tripTimes(index.getTripCount());
+
+    for (size_t t = 0; t < index.getTripCount(); ++t) {
+        auto tripStops = index.getTripStops(static_cast<int>(t));
+        auto times = index.getTripTimes(static_cast<int>(t));
+        std::vector<int> timedStops;
+        for (size_t i = 0; i < tripStops.size(); ++i) {
+            if (times[i] != TimetableIndex::NO_TIME) {
+                timedStops.push_back(tripStops[i]);
+                tripTimes[t].push_back(times[i]);
+            }
+        }
+        // Рейс, в расписании которого меньше двух остановок маршрута, никуда не везет
+        if (timedStops.size() < 2) {
+            continue;
+        }
+        GroupKey key(index.getTripRoute(static_cast<int>(t)), index.getTripWeekDay(static_cast<int>(t)),
+                     std::move(timedStops));
+        groups[std::move(key)].push_back(static_cast<int>(t));
+    }
+
+    stopOffsets.assign(1, 0);
+    tripOffsets.assign(1, 0);
+    stops.clear();
+    trips.clear();
+    timeOffsets.clear();
+    times.clear();
+    weekDays.clear();
+    routes.clear();
+
+    for (auto& [key, groupTrips] : groups) {
+        const auto& [route, weekDay, groupStops] = key;
+
+        std::stable_sort(groupTrips.begin(), groupTrips.end(), [&](int a, int b) {
+            return tripTimes[a] < tripTimes[b];
+        });
+
+        // Раскладка рейсов по шаблонам без обгонов
+        std::vector<std::vector<int>> patterns;
+        for (int trip : groupTrips) {
+            bool placed = false;
+            for (auto& pattern : patterns) {
+                const auto& last = tripTimes[pattern.back()];
+                bool noOvertaking = true;
+                for (size_t i = 0; i < last.size(); ++i) {
+                    if (last[i] > tripTimes[trip][i]) {
+                        noOvertaking = false;
+                        break;
+                    }
+                }
+                if (noOvertaking) {
+                    pattern.push_back(trip);
+                    placed = true;
+                    break;
+                }
+            }
+            if (!placed) {
+                patterns.push_back({trip});
+            }
+        }
+
+        for (const auto& pattern : patterns) {
+            stops.insert(stops.end(), groupStops.begin(), groupStops.end());
+            stopOffsets.push_back(static_cast<int>(stops.size()));
+            trips.insert(trips.end(), pattern.begin(), pattern.end());
+            tripOffsets.push_back(static_cast<int>(trips.size()));
+            for (size_t i = 0; i < groupStops.size(); ++i) {
+                timeOffsets.push_back(times.size());
+                for (int trip : pattern) {
+                    times.push_back(static_cast<int16_t>(tripTimes[trip][i]));
+                }
+            }
+            weekDays.push_back(weekDay);
+            routes.push_back(route);
+        }
+    }
+    timeOffsets.push_back(times.size());
+
+    // Шаблоны каждой остановки
+    stopPatternOffsets.assign(index.getStopCount() + 1, 0);
+    for (int stop : stops) {
+        stopPatternOffsets[stop + 1]++;
+    }
+    for (size_t s = 0; s < index.getStopCount(); ++s) {
+        stopPatternOffsets[s + 1] += stopPatternOffsets[s];
+    }
+    stopPatterns.assign(stops.size(), StopPattern{});
+    std::vector<int> fill(stopPatternOffsets.begin(), stopPatternOffsets.end() - 1);
+    for (size_t p = 0; p < getPatternCount(); ++p) {
+        for (int i = stopOffsets[p]; i < stopOffsets[p + 1]; ++i) {
+            stopPatterns[fill[stops[i]]++] = {static_cast<int>(p), i - stopOffsets[p]};
+        }
+    }
+}
+
+size_t RoutePatterns::getPatternCount() const {
+    return weekDays.size();
+}
+
+std::span<const int> RoutePatterns::getStops(int pattern) const {
+    return std::span<const int>(stops).subspan(stopOffsets[pattern],
+                                               stopOffsets[pattern + 1] - stopOffsets[pattern]);
+}
+
+std::span<const int> RoutePatterns::getTrips(int pattern) const {
+    return std::span<const int>(trips).subspan(tripOffsets[pattern],
+                                               tripOffsets[pattern + 1] - tripOffsets[pattern]);
+}
+
+// Номер столбца шаблона - сумма позиций всех предыдущих шаблонов плюс позиция
+std::span<const int16_t> RoutePatterns::getTimes(int pattern, int position) const {
+    size_t column = static_cast<size_t>(stopOffsets[pattern] + position);
+    return std::span<const int16_t>(times).subspan(timeOffsets[column],
+                                                   tripOffsets[pattern + 1] - tripOffsets[pattern]);
+}
+
+int RoutePatterns::getWeekDay(int pattern) const {
+    return weekDays[pattern];
+}
+
+int RoutePatterns::getRoute(int pattern) const {
+    return routes[pattern];
+}
+
+std::span<const RoutePatterns::StopPattern> RoutePatterns::getStopPatterns(int stop) const {
+    return std::span<const StopPattern>(stopPatterns).subspan(
+        stopPatternOffsets[stop], stopPatternOffsets[stop + 1] - stopPatternOffsets[stop]);
+}
+
+// Короткие столбцы (типичный шаблон - несколько десятков рейсов) быстрее просмотреть
+// векторно, чем искать двоичным поиском с непредсказуемыми переходами
+size_t RoutePatterns::findFirstTrip(std::span<const int16_t> column, int time) {
+    if (column.size() <= LINEAR_SEARCH_MAX_SIZE) {
+        return findFirstTripLinear(column, time);
+    }
+    return findFirstTripBinary(column, time);
+}
+
+// Столбец упорядочен, поэтому номер первого времени не раньше time равен количеству
+// времен меньше time: сравниваем блоки целиком и останавливаемся на первом блоке,
+// в котором не все времена меньше time
+size_t RoutePatterns::findFirstTripLinear(std::span<const int16_t> column, int time) {
+    // Времена хранятся в 16 битах: время вне этого диапазона сравниваем без векторизации
+    if (time > std::numeric_limits<int16_t>::max() || time < std::numeric_limits<int16_t>::min()) {
+        return findFirstTripScalar(column, time);
+    }
+    const int16_t* data = column.data();
+    size_t size = column.size();
+    size_t i = 0;
+
+#if defined(ROUTE_PATTERNS_AVX2)
+    __m256i threshold = _mm256_set1_epi16(static_cast<short>(time));
+    for (; i + 16 <= size; i += 16) {
+        __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        // 2 бита маски на каждое 16-битное время
+        uint32_t less = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi16(threshold, block)));
+        if (less != 0xFFFFFFFFu) {
+            return i + std::countr_zero(~less) / 2;
+        }
+    }
+#elif defined(ROUTE_PATTERNS_SSE2)
+    __m128i threshold = _mm_set1_epi16(static_cast<short>(time));
+    for (; i + 8 <= size; i += 8) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        uint32_t less = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmplt_epi16(block, threshold)));
+        if (less != 0xFFFFu) {
+            return i + std::countr_zero(~less) / 2;
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if (data[i] >= time) {
+            return i;
+        }
+    }
+    return size;
+}
+
+size_t RoutePatterns::findFirstTripScalar(std::span<const int16_t> column, int time) {
+    for (size_t i = 0; i < column.size(); ++i) {
+        if (column[i] >= time) {
+            return i;
+        }
+    }
+    return column.size();
+}
+
+size_t RoutePatterns::findFirstTripBinary(std::span<const int16_t> column, int time) {
+    return std::lower_bound(column.begin(), column.end(), time) - column.begin();
+}
@@ -0,0 +1,77 @@
+#ifndef ROUTE_PATTERNS_H
+#define ROUTE_PATTERNS_H
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class TimetableIndex;
+
+// Шаблоны маршрутов для поиска по маршрутам (по раундам)
+// Шаблон - группа рейсов одного маршрута и дня недели с одинаковым набором остановок
+// в расписании, в которой рейсы не обгоняют друг друга. Поэтому в каждой позиции шаблона
+// времена рейсов упорядочены, и "первый рейс, на который можно успеть" ищется в одном
+// непрерывном столбце времен. Рейсы, обгоняющие другие, выносятся в отдельные шаблоны
+class RoutePatterns {
+public:
+    // Вхождение остановки в шаблон
+    struct StopPattern {
+        int pattern;    // Номер шаблона
+        int position;   // Позиция остановки в шаблоне
+    };
+
+private:
+    // Остановки шаблонов (CSR: stopOffsets[p]..[p+1])
+    std::vector<int> stopOffsets;
+    std::vector<int> stops;
+    // Рейсы шаблонов в порядке следования (номера рейсов в индексе, CSR: tripOffsets[p]..[p+1])
+    std::vector<int> tripOffsets;
+    std::vector<int> trips;
+    // Времена по столбцам: для шаблона p и позиции i - времена всех его рейсов подряд
+    std::vector<size_t> timeOffsets;
+    std::vector<int16_t> times;
+    // День недели и маршрут (номер в индексе) каждого шаблона
+    std::vector<int> weekDays;
+    std::vector<int> routes;
+    // Шаблоны, проходящие через остановку (CSR: stopPatternOffsets[s]..[s+1])
+    std::vector<int> stopPatternOffsets;
+    std::vector<StopPattern> stopPatterns;
+
+public:
+    // Построить шаблоны по индексу сети
+    void build(const TimetableIndex& index);
+
+    size_t getPatternCount() const;
+
+    // Остановки шаблона в порядке следования
+    std::span<const int> getStops(int pattern) const;
+
+    // Рейсы шаблона (номера в индексе) в порядке следования
+    std::span<const int> getTrips(int pattern) const;
+
+    // Времена всех рейсов шаблона в позиции (по неубыванию)
+    std::span<const int16_t> getTimes(int pattern, int position) const;
+
+    int getWeekDay(int pattern) const;
+    int getRoute(int pattern) const;
+
+    // Шаблоны, проходящие через остановку
+    std::span<const StopPattern> getStopPatterns(int stop) const;
+
+    // Столбцы не длиннее этого размера просматриваются линейно (векторно), длиннее - двоичным поиском
+    // Значение подобрано по benchmarks/catchable_trip_benchmark.cpp
+    static const size_t LINEAR_SEARCH_MAX_SIZE = 256;
+
+    // Номер первого рейса в столбце с временем не раньше time (или размер столбца, если такого нет)
+    static size_t findFirstTrip(std::span<const int16_t> column, int time);
+
+    // Варианты поиска (используются findFirstTrip и замерами производительности):
+    // линейный с AVX2 (16 времен за сравнение) или SSE2 (8 времен), если доступны, иначе скалярный
+    static size_t findFirstTripLinear(std::span<const int16_t> column, int time);
+    // Скалярный линейный поиск (эталон и запасной вариант без SIMD)
+    static size_t findFirstTripScalar(std::span<const int16_t> column, int time);
+    // Двоичный поиск
+    static size_t findFirstTripBinary(std::span<const int16_t> column, int time);
+};
+
+#endif // ROUTE_PATTERNS_H
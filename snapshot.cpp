@@ -0,0 +1,721 @@
+#include "snapshot.h"
+#include "transport_system.h"
+#include "system_state.h"
+#include "bus.h"
+#include "tram.h"
+#include "trolleybus.h"
+#include "exceptions.h"
+#include "timetable_index.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+static const char SNAPSHOT_MAGIC[4] = {'T', 'S', 'N', 'P'};
+
+// Таблица строк снимка: каждая различная строка хранится один раз
+class SnapshotStringTable {
+private:
+    std::unordered_map<std::string, uint32_t> ids;
+    std::vector<uint32_t> offsets{0};
+    std::string bytes;
+
+public:
+    uint32_t intern(const std::string& value) {
+        auto [it, inserted] = ids.emplace(value, static_cast<uint32_t>(ids.size()));
+        if (inserted) {
+            bytes += value;
+            offsets.push_back(static_cast<uint32_t>(bytes.size()));
+        }
+        return it->second;
+    }
+
+    size_t getCount() const { return ids.size(); }
+    const std::vector<uint32_t>& getOffsets() const { return offsets; }
+    const std::string& getBytes() const { return bytes; }
+};
+
+// Сборщик файла снимка: заголовок, таблица разделов и выровненные разделы
+class SnapshotBuilder {
+private:
+    std::vector<char> buffer;
+    std::vector<SnapshotSection> sections;
+
+public:
+    void addSection(SnapshotSectionId id, uint32_t count, const void* bytes, size_t size) {
+        sections.push_back({static_cast<uint32_t>(id), count, 0, size});
+        size_t offset = (buffer.size() + SNAPSHOT_ALIGNMENT - 1) / SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+        buffer.resize(offset, 0);
+        sections.back().offset = offset;
+        const char* begin = static_cast<const char*>(bytes);
+        buffer.insert(buffer.end(), begin, begin + size);
+    }
+
+    template<typename T>
+    void addSection(SnapshotSectionId id, std::span<const T> items) {
+        addSection(id, static_cast<uint32_t>(items.size()), items.data(), items.size() * sizeof(T));
+    }
+
+    template<typename T>
+    void addSection(SnapshotSectionId id, const std::vector<T>& items) {
+        addSection(id, std::span<const T>(items));
+    }
+
+    // Собрать файл: смещения разделов отсчитываются от начала файла
+    std::vector<char> finish() {
+        size_t tableSize = sections.size() * sizeof(SnapshotSection);
+        size_t dataStart = (sizeof(SnapshotHeader) + tableSize + SNAPSHOT_ALIGNMENT - 1) /
+                           SNAPSHOT_ALIGNMENT * SNAPSHOT_ALIGNMENT;
+        for (auto& section : sections) {
+            section.offset += dataStart;
+        }
+
+        std::vector<char> file(dataStart + buffer.size(), 0);
+        std::memcpy(file.data() + sizeof(SnapshotHeader), sections.data(), tableSize);
+        std::copy(buffer.begin(), buffer.end(), file.begin() + dataStart);
+
+        SnapshotHeader header{};
+        std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+        header.version = SNAPSHOT_VERSION;
+        header.sectionCount = static_cast<uint32_t>(sections.size());
+        header.fileSize = file.size();
+        header.checksum = SnapshotView::checksum(file.data() + sizeof(SnapshotHeader),
+                                                 file.size() - sizeof(SnapshotHeader));
+        std::memcpy(file.data(), &header, sizeof(header));
+        return file;
+    }
+};
+
+uint64_t SnapshotView::checksum(const char* bytes, size_t byteCount) {
+    const uint64_t prime = 1099511628211ULL;
+    uint64_t hash = 1469598103934665603ULL;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= byteCount; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < byteCount; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(bytes[i])) * prime;
+    }
+    return hash;
+}
+
+SnapshotView::SnapshotView(const char* bytes, size_t byteCount, bool verify)
+    : data(bytes), size(byteCount), sections(nullptr), sectionCount(0), stringData(nullptr) {
+    if (reinterpret_cast<uintptr_t>(data) % SNAPSHOT_ALIGNMENT != 0) {
+        throw FileException("снимок данных", "буфер не выровнен");
+    }
+    if (size < sizeof(SnapshotHeader)) {
+        throw FileException("снимок данных", "файл слишком короткий");
+    }
+    const auto* header = reinterpret_cast<const SnapshotHeader*>(data);
+    if (std::memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        throw FileException("снимок данных", "неверная сигнатура");
+    }
+    if (header->version != SNAPSHOT_VERSION) {
+        throw FileException("снимок данных", "неподдерживаемая версия " + std::to_string(header->version));
+    }
+    if (header->fileSize != size ||
+        header->sectionCount > (size - sizeof(SnapshotHeader)) / sizeof(SnapshotSection)) {
+        throw FileException("снимок данных", "неверный размер файла");
+    }
+    if (verify && checksum(data + sizeof(SnapshotHeader), size - sizeof(SnapshotHeader)) != header->checksum) {
+        throw FileException("снимок данных", "неверная контрольная сумма");
+    }
+    sections = reinterpret_cast<const SnapshotSection*>(data + sizeof(SnapshotHeader));
+    sectionCount = header->sectionCount;
+    validate(verify);
+}
+
+const SnapshotSection* SnapshotView::findSection(SnapshotSectionId id) const {
+    for (uint32_t i = 0; i < sectionCount; ++i) {
+        if (sections[i].id == static_cast<uint32_t>(id)) {
+            return &sections[i];
+        }
+    }
+    return nullptr;
+}
+
+bool SnapshotView::hasSection(SnapshotSectionId id) const {
+    return findSection(id) != nullptr;
+}
+
+// Проверка границ разделов и всех ссылок между записями, чтобы при загрузке
+// можно было обращаться к ним без проверок
+void SnapshotView::validate(bool verify) {
+    auto fail = [](const std::string& what) {
+        throw FileException("снимок данных", what);
+    };
+
+    size_t headerEnd = sizeof(SnapshotHeader) + sectionCount * sizeof(SnapshotSection);
+    for (uint32_t i = 0; i < sectionCount; ++i) {
+        const SnapshotSection& section = sections[i];
+        size_t elementSize = 0;
+        size_t elementCount = section.count;
+        switch (static_cast<SnapshotSectionId>(section.id)) {
+            case SnapshotSectionId::StringOffsets:
+                elementSize = sizeof(uint32_t);
+                elementCount = static_cast<size_t>(section.count) + 1;
+                break;
+            case SnapshotSectionId::StringData: elementSize = 1; break;
+            case SnapshotSectionId::Stops: elementSize = sizeof(SnapshotStop); break;
+            case SnapshotSectionId::Vehicles: elementSize = sizeof(SnapshotVehicle); break;
+            case SnapshotSectionId::Drivers: elementSize = sizeof(SnapshotDriver); break;
+            case SnapshotSectionId::Routes: elementSize = sizeof(SnapshotRoute); break;
+            case SnapshotSectionId::RouteStops: elementSize = sizeof(uint32_t); break;
+            case SnapshotSectionId::Trips: elementSize = sizeof(SnapshotTrip); break;
+            case SnapshotSectionId::TripSchedule: elementSize = sizeof(SnapshotScheduleEntry); break;
+            case SnapshotSectionId::Admins: elementSize = sizeof(SnapshotAdmin); break;
+            case SnapshotSectionId::PlannerStops:
+            case SnapshotSectionId::PlannerStopOrder:
+            case SnapshotSectionId::PlannerTrips: elementSize = sizeof(uint32_t); break;
+            case SnapshotSectionId::PlannerInterchange: elementSize = sizeof(uint8_t); break;
+            case SnapshotSectionId::ConnectionDepTimes:
+            case SnapshotSectionId::ConnectionArrTimes:
+            case SnapshotSectionId::ConnectionDepStops:
+            case SnapshotSectionId::ConnectionArrStops:
+            case SnapshotSectionId::ConnectionTrips:
+            case SnapshotSectionId::ConnectionWeekDays: elementSize = sizeof(int32_t); break;
+            case SnapshotSectionId::JournalCheckpoint: elementSize = sizeof(uint64_t); break;
+            default:
+                // Неизвестные разделы пропускаются, но их границы все равно проверяются
+                elementSize = 1;
+                elementCount = section.size;
+                break;
+        }
+        if (section.offset % SNAPSHOT_ALIGNMENT != 0 || section.offset < headerEnd ||
+            section.offset > size || section.size > size - section.offset ||
+            section.size != elementCount * elementSize) {
+            fail("поврежден раздел " + std::to_string(section.id));
+        }
+    }
+
+    const SnapshotSection* offsetSection = findSection(SnapshotSectionId::StringOffsets);
+    const SnapshotSection* stringSection = findSection(SnapshotSectionId::StringData);
+    if (!offsetSection || !stringSection) {
+        fail("нет таблицы строк");
+    }
+    stringOffsets = {reinterpret_cast<const uint32_t*>(data + offsetSection->offset),
+                     static_cast<size_t>(offsetSection->count) + 1};
+    stringData = data + stringSection->offset;
+    if (stringOffsets.front() != 0 || stringOffsets.back() != stringSection->size) {
+        fail("повреждена таблица строк");
+    }
+
+    // Индекс планировщика: либо все его разделы, либо ни одного
+    // Длины разделов сверяются и без verify: планировщик обращается ко всем массивам
+    // соединений и остановок по общим номерам и без этой проверки читал бы за их границами
+    bool hasPlanner = hasSection(SnapshotSectionId::PlannerStops);
+    auto plannerStops = getSection<uint32_t>(SnapshotSectionId::PlannerStops);
+    auto stopOrder = getSection<uint32_t>(SnapshotSectionId::PlannerStopOrder);
+    auto interchange = getSection<uint8_t>(SnapshotSectionId::PlannerInterchange);
+    auto plannerTrips = getSection<uint32_t>(SnapshotSectionId::PlannerTrips);
+    auto depTimes = getSection<int32_t>(SnapshotSectionId::ConnectionDepTimes);
+    auto arrTimes = getSection<int32_t>(SnapshotSectionId::ConnectionArrTimes);
+    auto depStops = getSection<int32_t>(SnapshotSectionId::ConnectionDepStops);
+    auto arrStops = getSection<int32_t>(SnapshotSectionId::ConnectionArrStops);
+    auto connectionTrips = getSection<int32_t>(SnapshotSectionId::ConnectionTrips);
+    auto weekDays = getSection<int32_t>(SnapshotSectionId::ConnectionWeekDays);
+    size_t connectionCount = depTimes.size();
+    if (hasPlanner &&
+        (stopOrder.size() != plannerStops.size() || interchange.size() != plannerStops.size() ||
+         arrTimes.size() != connectionCount || depStops.size() != connectionCount ||
+         arrStops.size() != connectionCount || connectionTrips.size() != connectionCount ||
+         weekDays.size() != connectionCount)) {
+        fail("неполный индекс планировщика");
+    }
+
+    // Дальше - просмотр всех записей (ссылки и порядок), только при verify
+    if (!verify) {
+        return;
+    }
+    if (!std::is_sorted(stringOffsets.begin(), stringOffsets.end())) {
+        fail("повреждена таблица строк");
+    }
+
+    uint32_t stringCount = offsetSection->count;
+    auto checkString = [&](uint32_t index) {
+        if (index >= stringCount) {
+            fail("неверная ссылка на строку");
+        }
+    };
+
+    for (const auto& stop : getSection<SnapshotStop>(SnapshotSectionId::Stops)) {
+        checkString(stop.name);
+    }
+    auto vehicles = getSection<SnapshotVehicle>(SnapshotSectionId::Vehicles);
+    for (const auto& vehicle : vehicles) {
+        if (vehicle.kind > static_cast<uint32_t>(SnapshotVehicleKind::Trolleybus)) {
+            fail("неизвестный вид транспорта");
+        }
+        checkString(vehicle.type);
+        checkString(vehicle.model);
+        checkString(vehicle.licensePlate);
+        checkString(vehicle.fuelType);
+    }
+    auto drivers = getSection<SnapshotDriver>(SnapshotSectionId::Drivers);
+    for (const auto& driver : drivers) {
+        checkString(driver.firstName);
+        checkString(driver.lastName);
+        checkString(driver.middleName);
+        checkString(driver.category);
+    }
+    auto routeStops = getSection<uint32_t>(SnapshotSectionId::RouteStops);
+    for (uint32_t stop : routeStops) {
+        checkString(stop);
+    }
+    auto routes = getSection<SnapshotRoute>(SnapshotSectionId::Routes);
+    for (const auto& route : routes) {
+        checkString(route.vehicleType);
+        if (route.stopCount == 0 || route.firstStop > routeStops.size() ||
+            route.stopCount > routeStops.size() - route.firstStop) {
+            fail("неверные остановки маршрута " + std::to_string(route.number));
+        }
+    }
+    auto schedule = getSection<SnapshotScheduleEntry>(SnapshotSectionId::TripSchedule);
+    for (const auto& entry : schedule) {
+        checkString(entry.stop);
+    }
+    for (const auto& trip : getSection<SnapshotTrip>(SnapshotSectionId::Trips)) {
+        if (trip.route >= routes.size() ||
+            (trip.vehicle != SNAPSHOT_NONE && trip.vehicle >= vehicles.size()) ||
+            (trip.driver != SNAPSHOT_NONE && trip.driver >= drivers.size()) ||
+            trip.weekDay < 1 || trip.weekDay > 7 ||
+            trip.firstEntry > schedule.size() || trip.entryCount > schedule.size() - trip.firstEntry) {
+            fail("неверные данные рейса " + std::to_string(trip.id));
+        }
+    }
+    for (const auto& admin : getSection<SnapshotAdmin>(SnapshotSectionId::Admins)) {
+        checkString(admin.username);
+        checkString(admin.password);
+    }
+
+    if (!hasPlanner) {
+        return;
+    }
+    for (uint32_t name : plannerStops) {
+        checkString(name);
+    }
+    for (size_t i = 0; i < stopOrder.size(); ++i) {
+        if (stopOrder[i] >= plannerStops.size() ||
+            (i > 0 && getString(plannerStops[stopOrder[i - 1]]) >= getString(plannerStops[stopOrder[i]]))) {
+            fail("неверный порядок остановок индекса");
+        }
+    }
+    size_t tripRecords = getSection<SnapshotTrip>(SnapshotSectionId::Trips).size();
+    for (uint32_t trip : plannerTrips) {
+        if (trip != SNAPSHOT_NONE && trip >= tripRecords) {
+            fail("неверная ссылка рейса индекса");
+        }
+    }
+    for (size_t c = 0; c < connectionCount; ++c) {
+        if (depStops[c] < 0 || static_cast<size_t>(depStops[c]) >= plannerStops.size() ||
+            arrStops[c] < 0 || static_cast<size_t>(arrStops[c]) >= plannerStops.size() ||
+            connectionTrips[c] < 0 || static_cast<size_t>(connectionTrips[c]) >= plannerTrips.size() ||
+            (c > 0 && depTimes[c - 1] > depTimes[c])) {
+            fail("неверное соединение " + std::to_string(c));
+        }
+    }
+}
+
+size_t SnapshotView::getStringCount() const {
+    return stringOffsets.size() - 1;
+}
+
+std::string_view SnapshotView::getString(uint32_t index) const {
+    return {stringData + stringOffsets[index], stringOffsets[index + 1] - stringOffsets[index]};
+}
+
+void BinarySnapshot::write(const SystemState& system, const std::string& filePath, uint64_t journalCheckpoint) {
+    SnapshotStringTable strings;
+
+    std::vector<SnapshotStop> stops;
+    for (const auto& stop : system.getStops()) {
+        stops.push_back({stop.getId(), strings.intern(stop.getName())});
+    }
+
+    // Рейсы могут ссылаться на объекты, которых нет в списках системы; они дописываются
+    // в конец таблиц, чтобы ссылки рейсов всегда указывали на запись
+    std::vector<SnapshotVehicle> vehicles;
+    std::unordered_map<const Vehicle*, uint32_t> vehicleIndex;
+    auto addVehicle = [&](const std::shared_ptr<Vehicle>& vehicle) {
+        auto [it, inserted] = vehicleIndex.emplace(vehicle.get(), static_cast<uint32_t>(vehicles.size()));
+        if (!inserted) {
+            return it->second;
+        }
+        SnapshotVehicle record{};
+        record.kind = static_cast<uint32_t>(SnapshotVehicleKind::Plain);
+        record.type = strings.intern(vehicle->getType());
+        record.model = strings.intern(vehicle->getModel());
+        record.licensePlate = strings.intern(vehicle->getLicensePlate());
+        record.fuelType = strings.intern("");
+        if (auto bus = std::dynamic_pointer_cast<Bus>(vehicle)) {
+            record.kind = static_cast<uint32_t>(SnapshotVehicleKind::Bus);
+            record.capacity = bus->getCapacity();
+            record.fuelType = strings.intern(bus->getFuelType());
+        } else if (auto tram = std::dynamic_pointer_cast<Tram>(vehicle)) {
+            record.kind = static_cast<uint32_t>(SnapshotVehicleKind::Tram);
+            record.capacity = tram->getCapacity();
+            record.voltage = tram->getVoltage();
+        } else if (auto trolleybus = std::dynamic_pointer_cast<Trolleybus>(vehicle)) {
+            record.kind = static_cast<uint32_t>(SnapshotVehicleKind::Trolleybus);
+            record.capacity = trolleybus->getCapacity();
+            record.voltage = trolleybus->getVoltage();
+        }
+        vehicles.push_back(record);
+        return it->second;
+    };
+
+    std::vector<SnapshotDriver> drivers;
+    std::unordered_map<const Driver*, uint32_t> driverIndex;
+    auto addDriver = [&](const std::shared_ptr<Driver>& driver) {
+        auto [it, inserted] = driverIndex.emplace(driver.get(), static_cast<uint32_t>(drivers.size()));
+        if (inserted) {
+            drivers.push_back({strings.intern(driver->getFirstName()), strings.intern(driver->getLastName()),
+                               strings.intern(driver->getMiddleName()), strings.intern(driver->getCategory())});
+        }
+        return it->second;
+    };
+
+    std::vector<SnapshotRoute> routes;
+    std::vector<uint32_t> routeStops;
+    std::unordered_map<const Route*, uint32_t> routeIndex;
+    auto addRoute = [&](const std::shared_ptr<Route>& route) {
+        auto [it, inserted] = routeIndex.emplace(route.get(), static_cast<uint32_t>(routes.size()));
+        if (inserted) {
+            SnapshotRoute record{};
+            record.number = route->getNumber();
+            record.vehicleType = strings.intern(route->getVehicleType());
+            record.firstStop = static_cast<uint32_t>(routeStops.size());
+            for (const auto& stop : route->getAllStops()) {
+                routeStops.push_back(strings.intern(stop));
+            }
+            record.stopCount = static_cast<uint32_t>(routeStops.size()) - record.firstStop;
+            // Те же дни, что в routes.txt: загрузка из снимка и из текста дает один маршрут
+            for (int day : system.getRouteWeekDays(route)) {
+                if (day >= 0 && day < 32) {
+                    record.weekDays |= 1u << day;
+                }
+            }
+            routes.push_back(record);
+        }
+        return it->second;
+    };
+
+    for (const auto& vehicle : system.getVehicles()) {
+        addVehicle(vehicle);
+    }
+    for (const auto& driver : system.getDrivers()) {
+        addDriver(driver);
+    }
+    for (const auto& route : system.getRoutes()) {
+        addRoute(route);
+    }
+
+    std::vector<SnapshotTrip> trips;
+    std::vector<SnapshotScheduleEntry> schedule;
+    for (const auto& trip : system.getTrips()) {
+        if (!trip->getRoute()) {
+            continue;  // Как и в текстовых файлах, рейсы без маршрута не сохраняются
+        }
+        SnapshotTrip record{};
+        record.id = trip->getTripId();
+        record.route = addRoute(trip->getRoute());
+        record.vehicle = trip->getVehicle() ? addVehicle(trip->getVehicle()) : SNAPSHOT_NONE;
+        record.driver = trip->getDriver() ? addDriver(trip->getDriver()) : SNAPSHOT_NONE;
+        record.startTime = trip->getStartTime().getTotalMinutes();
+        record.weekDay = trip->getWeekDay();
+        record.firstEntry = static_cast<uint32_t>(schedule.size());
+        for (const auto& [stop, arrival] : trip->getSchedule()) {
+            schedule.push_back({strings.intern(stop), arrival.getTotalMinutes()});
+        }
+        record.entryCount = static_cast<uint32_t>(schedule.size()) - record.firstEntry;
+        trips.push_back(record);
+    }
+
+    // Порядок учетных записей фиксируется, чтобы одинаковое состояние давало одинаковый файл
+    std::vector<std::pair<std::string, std::string>> credentials(system.getAdminCredentials().begin(),
+                                                                 system.getAdminCredentials().end());
+    std::sort(credentials.begin(), credentials.end());
+    std::vector<SnapshotAdmin> admins;
+    for (const auto& [username, password] : credentials) {
+        admins.push_back({strings.intern(username), strings.intern(password)});
+    }
+
+    // Индекс планировщика строится так же, как для поиска в самой системе
+    // (готовый индекс планировщика переиспользуется, если копия снята с актуальным индексом)
+    auto indexPointer = system.getTimetableIndex();
+    const TimetableIndex& index = *indexPointer;
+    std::unordered_map<const Trip*, uint32_t> tripRecords;
+    {
+        uint32_t record = 0;
+        for (const auto& trip : system.getTrips()) {
+            if (trip->getRoute()) {
+                tripRecords.emplace(trip.get(), record++);
+            }
+        }
+    }
+    std::vector<uint32_t> plannerStops(index.getStopCount());
+    std::vector<uint32_t> stopOrder(index.getStopCount());
+    std::vector<uint8_t> interchange(index.getStopCount());
+    for (size_t stop = 0; stop < index.getStopCount(); ++stop) {
+        plannerStops[stop] = strings.intern(index.getStopName(static_cast<int>(stop)));
+        stopOrder[stop] = static_cast<uint32_t>(stop);
+        interchange[stop] = index.isInterchange(static_cast<int>(stop)) ? 1 : 0;
+    }
+    std::sort(stopOrder.begin(), stopOrder.end(), [&index](uint32_t a, uint32_t b) {
+        return index.getStopName(static_cast<int>(a)) < index.getStopName(static_cast<int>(b));
+    });
+    std::vector<uint32_t> plannerTrips(index.getTripCount(), SNAPSHOT_NONE);
+    for (size_t trip = 0; trip < index.getTripCount(); ++trip) {
+        auto it = tripRecords.find(index.getTrip(static_cast<int>(trip)).get());
+        if (it != tripRecords.end()) {
+            plannerTrips[trip] = it->second;
+        }
+    }
+    ConnectionTable::Arrays connections = index.getConnections().getArrays();
+
+    SnapshotBuilder builder;
+    builder.addSection(SnapshotSectionId::StringOffsets, static_cast<uint32_t>(strings.getCount()),
+                       strings.getOffsets().data(), strings.getOffsets().size() * sizeof(uint32_t));
+    builder.addSection(SnapshotSectionId::StringData, static_cast<uint32_t>(strings.getBytes().size()),
+                       strings.getBytes().data(), strings.getBytes().size());
+    builder.addSection(SnapshotSectionId::Stops, stops);
+    builder.addSection(SnapshotSectionId::Vehicles, vehicles);
+    builder.addSection(SnapshotSectionId::Drivers, drivers);
+    builder.addSection(SnapshotSectionId::Routes, routes);
+    builder.addSection(SnapshotSectionId::RouteStops, routeStops);
+    builder.addSection(SnapshotSectionId::Trips, trips);
+    builder.addSection(SnapshotSectionId::TripSchedule, schedule);
+    builder.addSection(SnapshotSectionId::Admins, admins);
+    builder.addSection(SnapshotSectionId::PlannerStops, plannerStops);
+    builder.addSection(SnapshotSectionId::PlannerStopOrder, stopOrder);
+    builder.addSection(SnapshotSectionId::PlannerInterchange, interchange);
+    builder.addSection(SnapshotSectionId::PlannerTrips, plannerTrips);
+    builder.addSection(SnapshotSectionId::ConnectionDepTimes, connections.depTimes);
+    builder.addSection(SnapshotSectionId::ConnectionArrTimes, connections.arrTimes);
+    builder.addSection(SnapshotSectionId::ConnectionDepStops, connections.depStops);
+    builder.addSection(SnapshotSectionId::ConnectionArrStops, connections.arrStops);
+    builder.addSection(SnapshotSectionId::ConnectionTrips, connections.trips);
+    builder.addSection(SnapshotSectionId::ConnectionWeekDays, connections.weekDays);
+    if (journalCheckpoint != 0) {
+        builder.addSection(SnapshotSectionId::JournalCheckpoint, 1, &journalCheckpoint, sizeof(journalCheckpoint));
+    }
+    std::vector<char> file = builder.finish();
+
+    std::string tempPath = filePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            throw FileException(tempPath, "открытие для записи");
+        }
+        out.write(file.data(), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            throw FileException(tempPath, "запись");
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, filePath, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        throw FileException(filePath, "замена файла снимка");
+    }
+}
+
+void BinarySnapshot::write(TransportSystem& system, const std::string& filePath) {
+    write(SystemState(system), filePath);
+}
+
+void BinarySnapshot::read(TransportSystem& system, const std::string& filePath) {
+    std::ifstream in(filePath, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) {
+        throw FileException(filePath, "открытие для чтения");
+    }
+    std::streamsize byteCount = in.tellg();
+    in.seekg(0);
+    // Буфер из 64-битных слов, чтобы записи снимка были выровнены
+    std::vector<uint64_t> buffer((static_cast<size_t>(byteCount) + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    if (!in.read(reinterpret_cast<char*>(buffer.data()), byteCount)) {
+        throw FileException(filePath, "чтение");
+    }
+    read(system, reinterpret_cast<const char*>(buffer.data()), static_cast<size_t>(byteCount));
+}
+
+uint64_t BinarySnapshot::readChecksum(const std::string& filePath) {
+    std::ifstream in(filePath, std::ios::binary);
+    SnapshotHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != SNAPSHOT_VERSION) {
+        return 0;
+    }
+    return header.checksum;
+}
+
+uint64_t BinarySnapshot::readJournalCheckpoint(const std::string& filePath) {
+    std::ifstream in(filePath, std::ios::binary);
+    SnapshotHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || header.version != SNAPSHOT_VERSION) {
+        return 0;
+    }
+    // Таблица разделов идет сразу за заголовком
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SnapshotSection section;
+        if (!in.read(reinterpret_cast<char*>(&section), sizeof(section))) {
+            return 0;
+        }
+        if (section.id == static_cast<uint32_t>(SnapshotSectionId::JournalCheckpoint)) {
+            uint64_t checkpoint = 0;
+            if (section.size != sizeof(checkpoint) || !in.seekg(static_cast<std::streamoff>(section.offset)) ||
+                !in.read(reinterpret_cast<char*>(&checkpoint), sizeof(checkpoint))) {
+                return 0;
+            }
+            return checkpoint;
+        }
+    }
+    return 0;
+}
+
+// Все объекты сначала создаются и только потом добавляются в систему, поэтому
+// ошибка в середине снимка не оставляет систему загруженной наполовину
+void BinarySnapshot::read(TransportSystem& system, const char* bytes, size_t byteCount) {
+    SnapshotView view(bytes, byteCount);
+    // Каждая строка таблицы создается один раз, объекты получают копии
+    std::vector<std::string> strings(view.getStringCount());
+    for (size_t i = 0; i < strings.size(); ++i) {
+        strings[i] = view.getString(static_cast<uint32_t>(i));
+    }
+    auto text = [&strings](uint32_t index) -> const std::string& { return strings[index]; };
+
+    List<Stop> newStops;
+    std::unordered_set<int> stopIds;
+    for (const auto& record : view.getSection<SnapshotStop>(SnapshotSectionId::Stops)) {
+        if (!system.hasStop(record.id) && stopIds.insert(record.id).second) {
+            newStops.push_back(Stop(record.id, text(record.name)));
+        }
+    }
+
+    // Для каждой записи - объект, на который будут ссылаться рейсы: уже существующий
+    // в системе с тем же ключом или новый
+    auto vehicleRecords = view.getSection<SnapshotVehicle>(SnapshotSectionId::Vehicles);
+    std::vector<std::shared_ptr<Vehicle>> vehicles(vehicleRecords.size());
+    List<std::shared_ptr<Vehicle>> newVehicles;
+    std::unordered_map<std::string, std::shared_ptr<Vehicle>> newVehiclesByPlate;
+    for (size_t i = 0; i < vehicleRecords.size(); ++i) {
+        const SnapshotVehicle& record = vehicleRecords[i];
+        const std::string& plate = text(record.licensePlate);
+        if (auto existing = system.findVehicleByLicensePlate(plate)) {
+            vehicles[i] = existing;
+            continue;
+        }
+        auto& vehicle = newVehiclesByPlate[plate];
+        if (!vehicle) {
+            switch (static_cast<SnapshotVehicleKind>(record.kind)) {
+                case SnapshotVehicleKind::Bus:
+                    vehicle = std::make_shared<Bus>(text(record.model), plate, record.capacity, text(record.fuelType));
+                    break;
+                case SnapshotVehicleKind::Tram:
+                    vehicle = std::make_shared<Tram>(text(record.model), plate, record.capacity, record.voltage);
+                    break;
+                case SnapshotVehicleKind::Trolleybus:
+                    vehicle = std::make_shared<Trolleybus>(text(record.model), plate, record.capacity, record.voltage);
+                    break;
+                default:
+                    vehicle = std::make_shared<Vehicle>(text(record.type), text(record.model), plate);
+                    break;
+            }
+            newVehicles.push_back(vehicle);
+        }
+        vehicles[i] = vehicle;
+    }
+
+    auto driverRecords = view.getSection<SnapshotDriver>(SnapshotSectionId::Drivers);
+    std::vector<std::shared_ptr<Driver>> drivers(driverRecords.size());
+    List<std::shared_ptr<Driver>> newDrivers;
+    std::unordered_map<std::string, std::shared_ptr<Driver>> newDriversByName;
+    for (size_t i = 0; i < driverRecords.size(); ++i) {
+        const SnapshotDriver& record = driverRecords[i];
+        const std::string& firstName = text(record.firstName);
+        const std::string& lastName = text(record.lastName);
+        const std::string& middleName = text(record.middleName);
+        if (system.hasDriver(firstName, lastName, middleName)) {
+            drivers[i] = system.findDriverByName(firstName, lastName, middleName);
+            continue;
+        }
+        auto& driver = newDriversByName[lastName + '\x1f' + firstName + '\x1f' + middleName];
+        if (!driver) {
+            driver = std::make_shared<Driver>(firstName, lastName, middleName, text(record.category));
+            newDrivers.push_back(driver);
+        }
+        drivers[i] = driver;
+    }
+
+    auto routeRecords = view.getSection<SnapshotRoute>(SnapshotSectionId::Routes);
+    auto routeStops = view.getSection<uint32_t>(SnapshotSectionId::RouteStops);
+    std::vector<std::shared_ptr<Route>> routes(routeRecords.size());
+    List<std::shared_ptr<Route>> newRoutes;
+    std::unordered_map<int, std::shared_ptr<Route>> newRoutesByNumber;
+    for (size_t i = 0; i < routeRecords.size(); ++i) {
+        const SnapshotRoute& record = routeRecords[i];
+        if (auto existing = system.findRouteByNumber(record.number)) {
+            routes[i] = existing;
+            continue;
+        }
+        auto& route = newRoutesByNumber[record.number];
+        if (!route) {
+            List<std::string> stops;
+            for (uint32_t k = 0; k < record.stopCount; ++k) {
+                stops.push_back(text(routeStops[record.firstStop + k]));
+            }
+            std::set<int> weekDays;
+            for (int day = 0; day < 32; ++day) {
+                if (record.weekDays & (1u << day)) {
+                    weekDays.insert(day);
+                }
+            }
+            route = std::make_shared<Route>(record.number, text(record.vehicleType), stops, weekDays);
+            newRoutes.push_back(route);
+        }
+        routes[i] = route;
+    }
+
+    auto schedule = view.getSection<SnapshotScheduleEntry>(SnapshotSectionId::TripSchedule);
+    List<std::shared_ptr<Trip>> newTrips;
+    std::unordered_set<int> tripIds;
+    for (const auto& record : view.getSection<SnapshotTrip>(SnapshotSectionId::Trips)) {
+        if (system.getTripById(record.id) || !tripIds.insert(record.id).second) {
+            continue;
+        }
+        auto trip = std::make_shared<Trip>(record.id, routes[record.route],
+                                           record.vehicle == SNAPSHOT_NONE ? nullptr : vehicles[record.vehicle],
+                                           record.driver == SNAPSHOT_NONE ? nullptr : drivers[record.driver],
+                                           Time(0, record.startTime), record.weekDay);
+        for (uint32_t k = 0; k < record.entryCount; ++k) {
+            const SnapshotScheduleEntry& entry = schedule[record.firstEntry + k];
+            trip->setArrivalTime(text(entry.stop), Time(0, entry.arrival));
+        }
+        newTrips.push_back(trip);
+    }
+
+    std::unordered_map<std::string, std::string> credentials;
+    for (const auto& record : view.getSection<SnapshotAdmin>(SnapshotSectionId::Admins)) {
+        credentials[text(record.username)] = text(record.password);
+    }
+
+    for (const auto& stop : newStops) {
+        system.addStopDirect(stop);
+    }
+    system.addVehiclesDirect(newVehicles);
+    system.addDriversDirect(newDrivers);
+    for (const auto& route : newRoutes) {
+        system.addRouteDirect(route);
+    }
+    system.addTripsDirect(newTrips);
+    if (!credentials.empty()) {
+        system.setAdminCredentials(credentials);
+    }
+}
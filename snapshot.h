@@ -0,0 +1,202 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+
+class TransportSystem;
+class SystemState;
+
+// Двоичный снимок всего состояния транспортной системы (файл snapshot.bin)
+// Загружается вместо разбора текстовых файлов: все записи лежат упакованными массивами
+// фиксированного размера, строки хранятся один раз в общей таблице строк и в записях
+// заменены номерами. Ссылки рейсов на маршрут, транспорт и водителя - номера записей.
+//
+// Формат (порядок байтов - как у машины, записавшей снимок):
+//   SnapshotHeader
+//   SnapshotSection[sectionCount] - таблица разделов
+//   данные разделов, каждый выровнен на SNAPSHOT_ALIGNMENT байт
+// Контрольная сумма считается по всем байтам после заголовка
+//
+// Разделы Planner* и Connection* - готовый индекс для планировщика (номера остановок и
+// рейсов как в TimetableIndex и массивы таблицы соединений). Загрузка объектов их не
+// использует; по ним MappedDataset отвечает на запросы прямо из отображенного файла
+
+// Версия формата; при несовпадении снимок игнорируется
+const uint32_t SNAPSHOT_VERSION = 2;
+const size_t SNAPSHOT_ALIGNMENT = 8;
+// Нет ссылки (рейс без транспорта или водителя)
+const uint32_t SNAPSHOT_NONE = 0xFFFFFFFFu;
+
+struct SnapshotHeader {
+    char magic[4];          // "TSNP"
+    uint32_t version;       // SNAPSHOT_VERSION
+    uint32_t sectionCount;  // Количество записей в таблице разделов
+    uint32_t reserved;
+    uint64_t fileSize;      // Полный размер файла
+    uint64_t checksum;      // Контрольная сумма байтов после заголовка
+};
+
+// Разделы снимка
+enum class SnapshotSectionId : uint32_t {
+    StringOffsets = 1,  // uint32_t[count + 1] - начало каждой строки в StringData
+    StringData,         // Байты всех строк подряд
+    Stops,              // SnapshotStop
+    Vehicles,           // SnapshotVehicle
+    Drivers,            // SnapshotDriver
+    Routes,             // SnapshotRoute
+    RouteStops,         // uint32_t - номера строк остановок маршрутов подряд
+    Trips,              // SnapshotTrip
+    TripSchedule,       // SnapshotScheduleEntry - расписания рейсов подряд
+    Admins,             // SnapshotAdmin
+    PlannerStops,       // uint32_t - номер строки названия для каждой остановки индекса
+    PlannerStopOrder,   // uint32_t - остановки индекса, упорядоченные по названию
+    PlannerInterchange, // uint8_t - пересадочный ли узел остановка индекса
+    PlannerTrips,       // uint32_t - запись в Trips для каждого рейса индекса
+    ConnectionDepTimes, // int32_t - массивы таблицы соединений (ConnectionTable::Arrays)
+    ConnectionArrTimes,
+    ConnectionDepStops,
+    ConnectionArrStops,
+    ConnectionTrips,
+    ConnectionWeekDays,
+    JournalCheckpoint   // uint64_t - отметка журнала изменений, на которой снята копия (необязательный)
+};
+
+struct SnapshotSection {
+    uint32_t id;       // SnapshotSectionId
+    uint32_t count;    // Количество элементов
+    uint64_t offset;   // Смещение от начала файла
+    uint64_t size;     // Размер в байтах
+};
+
+struct SnapshotStop {
+    int32_t id;
+    uint32_t name;
+};
+
+// Вид транспортного средства (класс, который нужно создать при загрузке)
+enum class SnapshotVehicleKind : uint32_t {
+    Plain = 0,   // Vehicle
+    Bus,
+    Tram,
+    Trolleybus
+};
+
+struct SnapshotVehicle {
+    uint32_t kind;       // SnapshotVehicleKind
+    uint32_t type;
+    uint32_t model;
+    uint32_t licensePlate;
+    int32_t capacity;
+    uint32_t fuelType;   // Только для автобуса
+    double voltage;      // Только для трамвая и троллейбуса
+};
+
+struct SnapshotDriver {
+    uint32_t firstName;
+    uint32_t lastName;
+    uint32_t middleName;
+    uint32_t category;
+};
+
+struct SnapshotRoute {
+    int32_t number;
+    uint32_t vehicleType;
+    uint32_t firstStop;   // Начало остановок в RouteStops
+    uint32_t stopCount;
+    uint32_t weekDays;    // Бит d - маршрут работает в день d (1-7)
+};
+
+struct SnapshotTrip {
+    int32_t id;
+    uint32_t route;          // Номер записи в Routes
+    uint32_t vehicle;        // Номер записи в Vehicles или SNAPSHOT_NONE
+    uint32_t driver;         // Номер записи в Drivers или SNAPSHOT_NONE
+    int32_t startTime;       // Минуты от начала суток
+    int32_t weekDay;
+    uint32_t firstEntry;     // Начало расписания в TripSchedule
+    uint32_t entryCount;
+};
+
+struct SnapshotScheduleEntry {
+    uint32_t stop;           // Номер строки названия остановки
+    int32_t arrival;         // Минуты от начала суток
+};
+
+struct SnapshotAdmin {
+    uint32_t username;
+    uint32_t password;
+};
+
+// Проверенное представление снимка поверх байтов в памяти (без копирования)
+// Конструктор проверяет заголовок, версию, границы разделов и согласованность длин разделов
+// индекса планировщика, а при verify - еще контрольную сумму и все ссылки между записями;
+// при ошибке выбрасывает FileException.
+// Без verify не читается ничего, кроме заголовка, таблицы разделов и границ таблицы строк:
+// так открываются заранее проверенные файлы, страницы которых подгружаются только при обращении
+class SnapshotView {
+private:
+    const char* data;
+    size_t size;
+    const SnapshotSection* sections;
+    uint32_t sectionCount;
+    std::span<const uint32_t> stringOffsets;
+    const char* stringData;
+
+    const SnapshotSection* findSection(SnapshotSectionId id) const;
+    void validate(bool verify);
+
+public:
+    SnapshotView(const char* bytes, size_t byteCount, bool verify = true);
+
+    // Элементы раздела; пустой span, если раздела нет
+    template<typename T>
+    std::span<const T> getSection(SnapshotSectionId id) const {
+        const SnapshotSection* section = findSection(id);
+        if (!section) {
+            return {};
+        }
+        return {reinterpret_cast<const T*>(data + section->offset), section->count};
+    }
+
+    bool hasSection(SnapshotSectionId id) const;
+
+    size_t getStringCount() const;
+    std::string_view getString(uint32_t index) const;
+
+    // Контрольная сумма байтов (FNV-1a по 64-битным словам, хвост - побайтно)
+    static uint64_t checksum(const char* bytes, size_t byteCount);
+};
+
+// Запись и загрузка снимка
+class BinarySnapshot {
+public:
+    // Записать снимок копии состояния системы в файл
+    // Пишется во временный файл, который затем переименовывается, поэтому прерванная
+    // запись не портит предыдущий снимок. journalCheckpoint - отметка журнала изменений
+    // (CommandJournal::checkpoint), на момент которой снята копия; 0 - без отметки
+    static void write(const SystemState& state, const std::string& filePath, uint64_t journalCheckpoint = 0);
+
+    // Записать снимок текущего состояния системы
+    static void write(TransportSystem& system, const std::string& filePath);
+
+    // Загрузить снимок в систему; объекты с уже существующими ключами пропускаются,
+    // как при загрузке из текстовых файлов. Выбрасывает FileException, если файл
+    // не читается или поврежден (тогда система не изменяется)
+    static void read(TransportSystem& system, const std::string& filePath);
+
+    // Загрузить снимок из байтов в памяти
+    static void read(TransportSystem& system, const char* bytes, size_t byteCount);
+
+    // Контрольная сумма из заголовка снимка (читается только заголовок) или 0, если
+    // файла нет или это не снимок текущей версии. Отличает снимки друг от друга
+    static uint64_t readChecksum(const std::string& filePath);
+
+    // Отметка журнала изменений из снимка или 0, если ее нет (читаются заголовок и таблица разделов)
+    static uint64_t readJournalCheckpoint(const std::string& filePath);
+};
+
+#endif // SNAPSHOT_H
@@ -1,5 +1,5 @@
 #include "stop.h"
-#include <sstream>
+#include "record_parser.h"
 
 // Конструктор: инициализирует остановку с заданным ID и названием
 Stop::Stop(int stopId, std::string stopName) : id(stopId), name(std::move(stopName)) {}
@@ -25,11 +25,10 @@ std::string Stop::serialize() const {
 }
 
 // Создает объект остановки из строки формата "id|name"
-Stop Stop::deserialize(const std::string& data) {
-    std::istringstream ss(data);
-    std::string idStr, name;
-    std::getline(ss, idStr, '|');  // Читаем ID до разделителя
-    std::getline(ss, name);         // Читаем название до конца строки
-    return Stop(std::stoi(idStr), name);
+Stop Stop::deserialize(std::string_view data) {
+    FieldSplitter fields(data, '|');
+    std::string_view idStr = fields.next();      // ID до разделителя
+    std::string_view name = fields.remainder();  // Название до конца строки
+    return Stop(RecordParser::parseInt(idStr), std::string(name));
 }
 
@@ -2,6 +2,7 @@
 #define STOP_H
 
 #include <string>
+#include <string_view>
 
 // Класс, представляющий остановку общественного транспорта
 // Хранит информацию об остановке: уникальный идентификатор и название.
@@ -25,7 +26,7 @@ public:
     std::string serialize() const;
 
     // Десериализация остановки из строки формата "id|name"
-    static Stop deserialize(const std::string& data);
+    static Stop deserialize(std::string_view data);
 };
 
 #endif // STOP_H
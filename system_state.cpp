@@ -0,0 +1,64 @@
+#include "system_state.h"
+#include "transport_system.h"
+#include "timetable_index.h"
+#include "route.h"
+#include "trip.h"
+
+SystemState::SystemState(TransportSystem& system)
+    : timetableVersion(system.getTimetableVersion()),
+      stops(system.getStops()),
+      vehicles(system.getVehicles()),
+      drivers(system.getDrivers()),
+      routes(system.getRoutes()),
+      trips(system.getTrips()),
+      adminCredentials(system.getAdminCredentials()),
+      timetableIndex(system.getJourneyPlanner().findCurrentTimetableIndex()) {}
+
+unsigned long long SystemState::getTimetableVersion() const {
+    return timetableVersion;
+}
+
+const List<Stop>& SystemState::getStops() const {
+    return stops;
+}
+
+const List<std::shared_ptr<Vehicle>>& SystemState::getVehicles() const {
+    return vehicles;
+}
+
+const List<std::shared_ptr<Driver>>& SystemState::getDrivers() const {
+    return drivers;
+}
+
+const List<std::shared_ptr<Route>>& SystemState::getRoutes() const {
+    return routes;
+}
+
+const List<std::shared_ptr<Trip>>& SystemState::getTrips() const {
+    return trips;
+}
+
+const std::unordered_map<std::string, std::string>& SystemState::getAdminCredentials() const {
+    return adminCredentials;
+}
+
+std::shared_ptr<const TimetableIndex> SystemState::getTimetableIndex() const {
+    if (!timetableIndex) {
+        timetableIndex = std::make_shared<const TimetableIndex>(*this);
+    }
+    return timetableIndex;
+}
+
+std::set<int> SystemState::getRouteWeekDays(const std::shared_ptr<Route>& route) const {
+    if (!tripWeekDaysReady) {
+        for (const auto& trip : trips) {
+            tripWeekDays[trip->getRoute().get()].insert(trip->getWeekDay());
+        }
+        tripWeekDaysReady = true;
+    }
+    auto it = tripWeekDays.find(route.get());
+    if (it == tripWeekDays.end() || it->second.empty()) {
+        return route->getWeekDays();
+    }
+    return it->second;
+}
@@ -0,0 +1,61 @@
+#ifndef SYSTEM_STATE_H
+#define SYSTEM_STATE_H
+
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include "list.h"
+#include "stop.h"
+
+class TransportSystem;
+class Vehicle;
+class Driver;
+class Route;
+class Trip;
+class TimetableIndex;
+
+// Копия состояния транспортной системы для фонового сохранения
+// Копируются списки - указатели на объекты, а не сами объекты, поэтому копия снимается
+// за миллисекунды и не меняется, когда система добавляет и удаляет объекты.
+// Объекты остаются общими с системой: пока копия используется, их нельзя изменять на месте
+// (TransportSystem::calculateArrivalTimes дожидается окончания фонового сохранения).
+// Методы чтения повторяют TransportSystem, поэтому индекс сети и снимок строятся по копии
+// так же, как по самой системе
+class SystemState {
+private:
+    unsigned long long timetableVersion;
+    List<Stop> stops;
+    List<std::shared_ptr<Vehicle>> vehicles;
+    List<std::shared_ptr<Driver>> drivers;
+    List<std::shared_ptr<Route>> routes;
+    List<std::shared_ptr<Trip>> trips;
+    std::unordered_map<std::string, std::string> adminCredentials;
+    // Индекс сети этой версии расписания (nullptr, пока не построен)
+    mutable std::shared_ptr<const TimetableIndex> timetableIndex;
+    // Дни недели рейсов каждого маршрута (заполняется при первом обращении)
+    mutable std::unordered_map<const Route*, std::set<int>> tripWeekDays;
+    mutable bool tripWeekDaysReady = false;
+
+public:
+    // Снять копию состояния системы; индекс сети берется готовый, если он актуален
+    explicit SystemState(TransportSystem& system);
+
+    unsigned long long getTimetableVersion() const;
+    const List<Stop>& getStops() const;
+    const List<std::shared_ptr<Vehicle>>& getVehicles() const;
+    const List<std::shared_ptr<Driver>>& getDrivers() const;
+    const List<std::shared_ptr<Route>>& getRoutes() const;
+    const List<std::shared_ptr<Trip>>& getTrips() const;
+    const std::unordered_map<std::string, std::string>& getAdminCredentials() const;
+
+    // Индекс сети копии: готовый или построенный по копии при первом обращении
+    // Не потокобезопасен: копией пользуется один поток сохранения
+    std::shared_ptr<const TimetableIndex> getTimetableIndex() const;
+
+    // Дни недели маршрута для сохранения: дни его рейсов, а если рейсов нет - дни самого
+    // маршрута. По ним пишутся и routes.txt, и снимок, поэтому оба дают один и тот же маршрут
+    std::set<int> getRouteWeekDays(const std::shared_ptr<Route>& route) const;
+};
+
+#endif // SYSTEM_STATE_H
@@ -0,0 +1,134 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    if (threadCount == 0) {
+        size_t cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+    workers.reserve(threadCount);
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+bool ThreadPool::runPendingTask() {
+    std::function<void()> task;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (tasks.empty()) {
+            return false;
+        }
+        task = std::move(tasks.front());
+        tasks.pop_front();
+    }
+    task();
+    return true;
+}
+
+size_t ThreadPool::getThreadCount() const {
+    return workers.size();
+}
+
+// Раздача индексов через общий атомарный счетчик: потоки, закончившие раньше,
+// забирают оставшиеся индексы, поэтому неравные по стоимости задачи распределяются сами.
+// Ожидающий поток выполняет задачи из очереди, поэтому вложенный parallelFor
+// из задачи пула не приводит к взаимной блокировке
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& task, size_t maxThreads) {
+    if (count == 0) {
+        return;
+    }
+
+    size_t threads = workers.size() + 1;
+    if (maxThreads != 0) {
+        threads = std::min(threads, maxThreads);
+    }
+    threads = std::min(threads, count);
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            task(i);
+        }
+        return;
+    }
+
+    // Общее состояние вызова; разделяется с задачами пула
+    struct SharedState {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> remaining{0};
+        std::mutex errorMutex;
+        std::exception_ptr error;
+    };
+    auto state = std::make_shared<SharedState>();
+    state->remaining = threads - 1;
+
+    auto runner = [state, count, &task]() {
+        size_t i;
+        while ((i = state->next.fetch_add(1)) < count) {
+            try {
+                task(i);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(state->errorMutex);
+                if (!state->error) {
+                    state->error = std::current_exception();
+                }
+            }
+        }
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t t = 0; t + 1 < threads; ++t) {
+            tasks.push_back([state, runner]() {
+                runner();
+                state->remaining.fetch_sub(1);
+            });
+        }
+    }
+    taskAvailable.notify_all();
+
+    runner();
+    while (state->remaining.load() != 0) {
+        if (!runPendingTask()) {
+            std::this_thread::yield();
+        }
+    }
+
+    if (state->error) {
+        std::rethrow_exception(state->error);
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool pool;
+    return pool;
+}
@@ -0,0 +1,50 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул рабочих потоков для параллельных частей планировщиков
+// Потоки создаются один раз и ждут задач, поэтому параллельный шаг поиска
+// не тратит время на создание потоков. Основная операция - parallelFor:
+// индексы 0..count-1 раздаются потокам пула, вызывающий поток тоже участвует в работе
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;           // Рабочие потоки
+    std::deque<std::function<void()>> tasks;    // Очередь задач
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    bool stopping = false;
+
+    // Цикл рабочего потока
+    void workerLoop();
+
+    // Выполнить одну задачу из очереди, если она есть (используется при ожидании)
+    bool runPendingTask();
+
+public:
+    // Создать пул из threadCount рабочих потоков (0 - по числу ядер минус вызывающий поток)
+    explicit ThreadPool(size_t threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Количество рабочих потоков пула (без вызывающего)
+    size_t getThreadCount() const;
+
+    // Выполнить task(i) для всех i из [0, count), используя не более maxThreads потоков
+    // (включая вызывающий). Возвращает управление после завершения всех вызовов;
+    // первое исключение, выброшенное задачей, передается вызывающему
+    void parallelFor(size_t count, const std::function<void(size_t)>& task, size_t maxThreads = 0);
+
+    // Общий пул приложения
+    static ThreadPool& shared();
+};
+
+#endif // THREAD_POOL_H
@@ -1,5 +1,6 @@
 #include "time.h"
-#include <sstream>
+#include <charconv>
+#include <system_error>
 
 // Нормализует время, приводя его к диапазону 00:00 - 23:59
 // Приводит время к 24-часовому формату, обрабатывая переполнения и отрицательные значения
@@ -17,21 +18,7 @@ Time::Time(int h, int m) {
 }
 
 // Конструктор из строки формата "HH:MM"
-Time::Time(const std::string& timeStr) {
-    std::stringstream ss(timeStr);
-    char colon;
-    int h, m;
-    // Парсим строку: ожидаем формат "HH:MM"
-    if (!(ss >> h >> colon >> m) || colon != ':' || ss.fail() || !ss.eof()) {
-        throw InputException("Неверный формат времени: " + timeStr);
-    }
-    // Проверяем корректность диапазонов
-    if (h < 0 || h > 23 || m < 0 || m > 59) {
-        throw InputException("Некорректное время: " + timeStr);
-    }
-    hours = h;
-    minutes = m;
-}
+Time::Time(const std::string& timeStr) : Time(deserialize(timeStr)) {}
 
 // Возвращает общее количество минут с начала суток (0-1439)
 int Time::getTotalMinutes() const {
@@ -109,7 +96,47 @@ std::string Time::serialize() const {
            (minutes < 10 ? "0" : "") + std::to_string(minutes);
 }
 
+// Разбор "HH:MM" без создания потока: пробелы допускаются перед числами и двоеточием,
+// после минут - нет (как при прежнем чтении ss >> h >> colon >> m)
+static bool parseClock(std::string_view text, int& h, int& m) {
+    const char* pos = text.data();
+    const char* end = pos + text.size();
+    auto skipSpaces = [&]() {
+        while (pos != end && (*pos == ' ' || (*pos >= '\t' && *pos <= '\r'))) {
+            ++pos;
+        }
+    };
+    auto readNumber = [&](int& value) {
+        skipSpaces();
+        if (pos != end && *pos == '+' && pos + 1 != end && pos[1] != '-') {
+            ++pos;
+        }
+        auto [next, error] = std::from_chars(pos, end, value);
+        pos = next;
+        return error == std::errc();
+    };
+    if (!readNumber(h)) {
+        return false;
+    }
+    skipSpaces();
+    if (pos == end || *pos != ':') {
+        return false;
+    }
+    ++pos;
+    return readNumber(m) && pos == end;
+}
+
 // Десериализация времени из строки формата "HH:MM"
-Time Time::deserialize(const std::string& data) {
-    return Time(data);
+// Выбрасывает InputException, если формат или диапазоны некорректны
+Time Time::deserialize(std::string_view data) {
+    int h, m;
+    // Парсим строку: ожидаем формат "HH:MM"
+    if (!parseClock(data, h, m)) {
+        throw InputException("Неверный формат времени: " + std::string(data));
+    }
+    // Проверяем корректность диапазонов
+    if (h < 0 || h > 23 || m < 0 || m > 59) {
+        throw InputException("Некорректное время: " + std::string(data));
+    }
+    return Time(h, m);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define TIME_H
 
 #include <string>
+#include <string_view>
 #include <iostream>
 #include "exceptions.h"
 
@@ -52,7 +53,7 @@ public:
 
     // Сериализация
     std::string serialize() const;                          // В строку "HH:MM"
-    static Time deserialize(const std::string& data);       // Из строки "HH:MM"
+    static Time deserialize(std::string_view data);         // Из строки "HH:MM"
 };
 
 #endif // TIME_H
\ No newline at end of file
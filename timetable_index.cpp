@@ -0,0 +1,291 @@
+#include "timetable_index.h"
+#include "transport_system.h"
+#include "system_state.h"
+#include <algorithm>
+#include <queue>
+#include <tuple>
+
+// Построение индекса
+// Остановки берутся из списка остановок системы, из маршрутов и из расписаний рейсов:
+// в данных встречаются рейсы и маршруты с остановками, которых нет в stops.txt
+template<typename Source>
+void TimetableIndex::build(const Source& system) {
+    for (const auto& stop : system.getStops()) {
+        internStop(stop.getName());
+    }
+    // Номер маршрута в индексе (маршрут рейса может отсутствовать в списке маршрутов системы)
+    std::unordered_map<const Route*, int> routeIndices;
+    auto internRoute = [&](const std::shared_ptr<Route>& route) {
+        auto [it, inserted] = routeIndices.emplace(route.get(), static_cast<int>(routes.size()));
+        if (inserted) {
+            routes.push_back(route);
+        }
+        return it->second;
+    };
+    for (const auto& route : system.getRoutes()) {
+        internRoute(route);
+        for (const auto& stopName : route->getAllStops()) {
+            internStop(stopName);
+        }
+    }
+    for (const auto& trip : system.getTrips()) {
+        trips.push_back(trip);
+        tripWeekDays.push_back(trip->getWeekDay());
+        tripRoutes.push_back(internRoute(trip->getRoute()));
+        for (const auto& stopName : trip->getRoute()->getAllStops()) {
+            internStop(stopName);
+        }
+        for (const auto& [stopName, time] : trip->getSchedule()) {
+            internStop(stopName);
+        }
+    }
+
+    // Остановки маршрута каждого рейса с временем прибытия
+    tripStopOffsets.reserve(trips.size() + 1);
+    tripStopOffsets.push_back(0);
+    std::vector<int> visitCounts(stopNames.size(), 0);
+    for (const auto& trip : trips) {
+        const auto& schedule = trip->getSchedule();
+        for (const auto& stopName : trip->getRoute()->getAllStops()) {
+            auto it = schedule.find(stopName);
+            tripStops.push_back(stopIndices.at(stopName));
+            tripTimes.push_back(it != schedule.end() ? it->second.getTotalMinutes() : NO_TIME);
+        }
+        tripStopOffsets.push_back(static_cast<int>(tripStops.size()));
+        for (const auto& [stopName, time] : schedule) {
+            visitCounts[stopIndices.at(stopName)]++;
+        }
+    }
+
+    // Посещения остановок рейсами (для каждой остановки - в порядке рейсов)
+    stopVisitOffsets.assign(stopNames.size() + 1, 0);
+    for (size_t s = 0; s < stopNames.size(); ++s) {
+        stopVisitOffsets[s + 1] = stopVisitOffsets[s] + visitCounts[s];
+    }
+    stopVisits.resize(stopVisitOffsets.back());
+    std::vector<int> fill(stopVisitOffsets.begin(), stopVisitOffsets.end() - 1);
+    for (size_t t = 0; t < trips.size(); ++t) {
+        auto routeStops = getTripStops(static_cast<int>(t));
+        for (const auto& [stopName, time] : trips[t]->getSchedule()) {
+            int stop = stopIndices.at(stopName);
+            // Позиция - первое вхождение остановки в маршрут, как в Route::getStopPosition
+            int position = -1;
+            for (size_t i = 0; i < routeStops.size(); ++i) {
+                if (routeStops[i] == stop) {
+                    position = static_cast<int>(i);
+                    break;
+                }
+            }
+            stopVisits[fill[stop]++] = {static_cast<int>(t), position, time.getTotalMinutes()};
+        }
+    }
+
+    // Остановки маршрутов
+    routeStopOffsets.reserve(routes.size() + 1);
+    routeStopOffsets.push_back(0);
+    for (const auto& route : routes) {
+        for (const auto& stopName : route->getAllStops()) {
+            routeStops.push_back(stopIndices.at(stopName));
+        }
+        routeStopOffsets.push_back(static_cast<int>(routeStops.size()));
+    }
+
+    buildSegmentGraph();
+    patterns.build(*this);
+    buildInterchanges();
+    connections.build(*this);
+}
+
+TimetableIndex::TimetableIndex(const TransportSystem& system)
+    : version(system.getTimetableVersion()) {
+    build(system);
+}
+
+TimetableIndex::TimetableIndex(const SystemState& state)
+    : version(state.getTimetableVersion()) {
+    build(state);
+}
+
+int TimetableIndex::internStop(const std::string& name) {
+    auto [it, inserted] = stopIndices.emplace(name, static_cast<int>(stopNames.size()));
+    if (inserted) {
+        stopNames.push_back(name);
+    }
+    return it->second;
+}
+
+size_t TimetableIndex::getStopCount() const {
+    return stopNames.size();
+}
+
+int TimetableIndex::getStopIndex(const std::string& name) const {
+    auto it = stopIndices.find(name);
+    return it != stopIndices.end() ? it->second : -1;
+}
+
+const std::string& TimetableIndex::getStopName(int index) const {
+    return stopNames[index];
+}
+
+unsigned long long TimetableIndex::getVersion() const {
+    return version;
+}
+
+size_t TimetableIndex::getTripCount() const {
+    return trips.size();
+}
+
+const std::shared_ptr<Trip>& TimetableIndex::getTrip(int trip) const {
+    return trips[trip];
+}
+
+size_t TimetableIndex::getRouteCount() const {
+    return routes.size();
+}
+
+int TimetableIndex::getTripRoute(int trip) const {
+    return tripRoutes[trip];
+}
+
+bool TimetableIndex::isInterchange(int stop) const {
+    return interchangeFlags[stop] != 0;
+}
+
+std::span<const int> TimetableIndex::getRouteStops(int route) const {
+    return std::span<const int>(routeStops).subspan(
+        routeStopOffsets[route], routeStopOffsets[route + 1] - routeStopOffsets[route]);
+}
+
+const RoutePatterns& TimetableIndex::getPatterns() const {
+    return patterns;
+}
+
+const ConnectionTable& TimetableIndex::getConnections() const {
+    return connections;
+}
+
+int TimetableIndex::getTripWeekDay(int trip) const {
+    return tripWeekDays[trip];
+}
+
+std::span<const int> TimetableIndex::getTripStops(int trip) const {
+    return std::span<const int>(tripStops).subspan(tripStopOffsets[trip],
+                                                   tripStopOffsets[trip + 1] - tripStopOffsets[trip]);
+}
+
+std::span<const int> TimetableIndex::getTripTimes(int trip) const {
+    return std::span<const int>(tripTimes).subspan(tripStopOffsets[trip],
+                                                   tripStopOffsets[trip + 1] - tripStopOffsets[trip]);
+}
+
+std::span<const TimetableIndex::StopVisit> TimetableIndex::getStopVisits(int stop) const {
+    return std::span<const StopVisit>(stopVisits).subspan(stopVisitOffsets[stop],
+                                                          stopVisitOffsets[stop + 1] - stopVisitOffsets[stop]);
+}
+
+// Построение графа минимальных времен перегонов
+// Перегон - пара соседних остановок рейса, для которых известно время прибытия
+// (остановки без времени пропускаются так же, как при поиске). Отрицательная разница
+// времен (переход через полночь) считается нулевой, чтобы оценка оставалась неотрицательной
+void TimetableIndex::buildSegmentGraph() {
+    // (конечная остановка, начальная остановка, время в пути)
+    std::vector<std::tuple<int, int, int>> segments;
+    for (size_t t = 0; t < trips.size(); ++t) {
+        auto stops = getTripStops(static_cast<int>(t));
+        auto times = getTripTimes(static_cast<int>(t));
+        int previous = -1;
+        for (size_t i = 0; i < stops.size(); ++i) {
+            if (times[i] == NO_TIME) {
+                continue;
+            }
+            if (previous != -1 && stops[previous] != stops[i]) {
+                segments.emplace_back(stops[i], stops[previous], std::max(times[i] - times[previous], 0));
+            }
+            previous = static_cast<int>(i);
+        }
+    }
+
+    // После сортировки первый перегон каждой пары остановок - самый быстрый
+    std::sort(segments.begin(), segments.end());
+    segmentOffsets.assign(stopNames.size() + 1, 0);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        auto [to, from, time] = segments[i];
+        if (i > 0 && std::get<0>(segments[i - 1]) == to && std::get<1>(segments[i - 1]) == from) {
+            continue;
+        }
+        segmentSources.push_back(from);
+        segmentMinTimes.push_back(time);
+        segmentOffsets[to + 1]++;
+    }
+    for (size_t s = 0; s < stopNames.size(); ++s) {
+        segmentOffsets[s + 1] += segmentOffsets[s];
+    }
+}
+
+void TimetableIndex::computeLowerBounds(int target, std::vector<int>& bounds) const {
+    bounds.assign(stopNames.size(), UNREACHABLE);
+    if (target < 0 || target >= static_cast<int>(stopNames.size())) {
+        return;
+    }
+
+    // Дейкстра от цели по обратным перегонам: (оценка, остановка)
+    std::priority_queue<std::pair<int, int>, std::vector<std::pair<int, int>>,
+                        std::greater<std::pair<int, int>>> queue;
+    bounds[target] = 0;
+    queue.push({0, target});
+    while (!queue.empty()) {
+        auto [bound, stop] = queue.top();
+        queue.pop();
+        if (bound > bounds[stop]) {
+            continue;
+        }
+        for (int i = segmentOffsets[stop]; i < segmentOffsets[stop + 1]; ++i) {
+            int from = segmentSources[i];
+            int candidate = bound + segmentMinTimes[i];
+            if (candidate < bounds[from]) {
+                bounds[from] = candidate;
+                queue.push({candidate, from});
+            }
+        }
+    }
+}
+
+// Поиск пересадочных узлов
+// Для каждой остановки считается число различных маршрутов, проходящих через нее
+// (повторное появление остановки в кольцевом маршруте не учитывается).
+// Остановка одного маршрута тоже считается пересадочной, если рейсы маршрута одного дня недели
+// через нее разбиты на несколько шаблонов: у рейсов своя скорость, и более поздний рейс
+// может обогнать более ранний, поэтому пересадка на него дает более раннее прибытие.
+// Шаблоны разных дней недели не учитываются: пересадка между ними не дает настоящей поездки
+void TimetableIndex::buildInterchanges() {
+    std::vector<int> routeCounts(stopNames.size(), 0);
+    std::vector<int> lastRoute(stopNames.size(), -1);
+    for (size_t r = 0; r < routes.size(); ++r) {
+        for (const auto& stopName : routes[r]->getAllStops()) {
+            int stop = stopIndices.at(stopName);
+            if (lastRoute[stop] != static_cast<int>(r)) {
+                lastRoute[stop] = static_cast<int>(r);
+                routeCounts[stop]++;
+            }
+        }
+    }
+
+    interchangeFlags.assign(stopNames.size(), 0);
+    for (size_t s = 0; s < stopNames.size(); ++s) {
+        if (routeCounts[s] >= 2) {
+            interchangeFlags[s] = 1;
+            continue;
+        }
+        // Шаблоны одного дня недели (в кольцевом маршруте шаблон встречается дважды)
+        std::vector<std::pair<int, int>> dayPatterns;
+        for (const auto& stopPattern : patterns.getStopPatterns(static_cast<int>(s))) {
+            int weekDay = patterns.getWeekDay(stopPattern.pattern);
+            for (const auto& [day, pattern] : dayPatterns) {
+                if (day == weekDay && pattern != stopPattern.pattern) {
+                    interchangeFlags[s] = 1;
+                }
+            }
+            dayPatterns.emplace_back(weekDay, stopPattern.pattern);
+        }
+    }
+}
@@ -0,0 +1,141 @@
+#ifndef TIMETABLE_INDEX_H
+#define TIMETABLE_INDEX_H
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <limits>
+#include "route_patterns.h"
+#include "connection_scan.h"
+
+class TransportSystem;
+class SystemState;
+class Trip;
+class Route;
+
+// Плотный индекс транспортной сети для планировщиков
+// Сопоставляет названиям остановок номера 0..N-1, чтобы планировщики могли хранить
+// метки в массивах, а не в контейнерах с ключами-строками. Индекс строится по снимку
+// системы и помечается версией расписания, по которой планировщик определяет устаревание
+class TimetableIndex {
+public:
+    // Посещение остановки рейсом
+    struct StopVisit {
+        int trip;       // Номер рейса в индексе
+        int position;   // Первая позиция остановки в маршруте рейса (-1, если остановки нет в маршруте)
+        int time;       // Время прибытия по расписанию рейса (минуты от начала суток)
+    };
+
+    // Время для остановки маршрута, отсутствующей в расписании рейса
+    static const int NO_TIME = -1;
+
+    // Нижняя оценка для остановки, из которой цель недостижима
+    static constexpr int UNREACHABLE = std::numeric_limits<int>::max();
+
+private:
+    std::vector<std::string> stopNames;                 // Номер остановки -> название
+    std::unordered_map<std::string, int> stopIndices;   // Название -> номер остановки
+    unsigned long long version;                         // Версия расписания на момент построения
+
+    // Рейсы в порядке хранения в системе
+    std::vector<std::shared_ptr<Trip>> trips;
+    // Остановки маршрута каждого рейса и время прибытия на них (CSR: tripStopOffsets[t]..[t+1])
+    std::vector<int> tripStopOffsets;
+    std::vector<int> tripStops;
+    std::vector<int> tripTimes;
+    // День недели каждого рейса (1-понедельник, ..., 7-воскресенье)
+    std::vector<int> tripWeekDays;
+    // Рейсы, в расписании которых есть остановка (CSR: stopVisitOffsets[s]..[s+1]), в порядке рейсов
+    std::vector<int> stopVisitOffsets;
+    std::vector<StopVisit> stopVisits;
+    // Маршруты (из системы и из рейсов) и маршрут каждого рейса
+    std::vector<std::shared_ptr<Route>> routes;
+    std::vector<int> tripRoutes;
+    // Остановки каждого маршрута в порядке следования (CSR: routeStopOffsets[r]..[r+1])
+    std::vector<int> routeStopOffsets;
+    std::vector<int> routeStops;
+    // Пересадочные узлы - остановки, через которые проходят два и более маршрута
+    std::vector<unsigned char> interchangeFlags;
+    // Шаблоны маршрутов для поиска по маршрутам
+    RoutePatterns patterns;
+    // Соединения рейсов для поиска сканированием соединений
+    ConnectionTable connections;
+    // Граф минимальных времен перегонов в обратном направлении (CSR по конечной остановке):
+    // для каждой пары соседних остановок рейсов - наименьшее время в пути между ними
+    std::vector<int> segmentOffsets;
+    std::vector<int> segmentSources;
+    std::vector<int> segmentMinTimes;
+
+    // Построить граф минимальных времен перегонов
+    void buildSegmentGraph();
+
+    // Найти пересадочные узлы (вызывается после построения шаблонов маршрутов)
+    void buildInterchanges();
+
+    // Добавить остановку в индекс (если ее еще нет) и вернуть ее номер
+    int internStop(const std::string& name);
+
+    // Построить индекс по остановкам, маршрутам и рейсам источника (система или ее копия)
+    template<typename Source>
+    void build(const Source& source);
+
+public:
+    // Построить индекс по текущему состоянию транспортной системы
+    explicit TimetableIndex(const TransportSystem& system);
+
+    // Построить индекс по копии состояния системы (для фонового сохранения)
+    explicit TimetableIndex(const SystemState& state);
+
+    // Количество остановок в индексе
+    size_t getStopCount() const;
+
+    // Получить номер остановки по названию или -1, если остановка неизвестна
+    int getStopIndex(const std::string& name) const;
+
+    // Получить название остановки по номеру
+    const std::string& getStopName(int index) const;
+
+    // Версия расписания, по которой построен индекс
+    unsigned long long getVersion() const;
+
+    // Количество рейсов и доступ к рейсу по номеру
+    size_t getTripCount() const;
+    const std::shared_ptr<Trip>& getTrip(int trip) const;
+    int getTripWeekDay(int trip) const;
+
+    // Остановки маршрута рейса в порядке следования и время прибытия на них (NO_TIME, если не задано)
+    std::span<const int> getTripStops(int trip) const;
+    std::span<const int> getTripTimes(int trip) const;
+
+    // Рейсы, проходящие через остановку (аналог TransportSystem::getTripsThroughStop)
+    std::span<const StopVisit> getStopVisits(int stop) const;
+
+    // Количество маршрутов и маршрут рейса (номер в индексе)
+    size_t getRouteCount() const;
+    int getTripRoute(int trip) const;
+
+    // Является ли остановка пересадочным узлом: ее обслуживают два и более маршрута
+    // или рейсы ее единственного маршрута одного дня недели разбиты на несколько шаблонов
+    // (есть обгоны). В остальных остановках пересадка бесполезна: более поздний рейс
+    // того же шаблона не может приехать раньше, потому что рейсы шаблона не обгоняют друг друга.
+    // При weekDay = 0 пересадки между рейсами маршрута разных дней здесь не рассматриваются
+    bool isInterchange(int stop) const;
+
+    // Остановки маршрута (номер в индексе) в порядке следования
+    std::span<const int> getRouteStops(int route) const;
+
+    // Шаблоны маршрутов (рейсы без обгонов со столбцами времен по позициям)
+    const RoutePatterns& getPatterns() const;
+
+    // Соединения всех рейсов в порядке отправления
+    const ConnectionTable& getConnections() const;
+
+    // Нижние оценки времени в пути от каждой остановки до target (UNREACHABLE, если цель недостижима)
+    // Считаются алгоритмом Дейкстры по графу минимальных времен перегонов: никакая поездка
+    // не может доехать от остановки до цели быстрее, чем по самым быстрым перегонам без ожидания
+    void computeLowerBounds(int target, std::vector<int>& bounds) const;
+};
+
+#endif // TIMETABLE_INDEX_H
@@ -13,6 +13,36 @@ TransportSystem::TransportSystem()
     // Учетные данные администраторов по умолчанию
     adminCredentials["admin"] = "admin123";
     adminCredentials["manager"] = "manager123";
+    commandHistory.setJournal(&dataManager.getJournal());
+}
+
+// Отмечает время выполнения команды: изменения *Direct внутри нее записываются в журнал
+class CommandScope {
+private:
+    bool& flag;
+
+public:
+    explicit CommandScope(bool& applyingCommand) : flag(applyingCommand) { flag = true; }
+    ~CommandScope() { flag = false; }
+};
+
+void TransportSystem::executeCommand(std::unique_ptr<Command> cmd) {
+    CommandScope scope(applyingCommand);
+    commandHistory.executeCommand(std::move(cmd));
+}
+
+void TransportSystem::noteDirectChange() {
+    if (!bulkLoading && !applyingCommand) {
+        dataManager.markUnjournaled();
+    }
+}
+
+void TransportSystem::markTripDirty(const Trip& trip) {
+    if (auto route = trip.getRoute()) {
+        dataManager.markDirty(DataManager::getTripFile(route->getVehicleType()));
+    }
+    // Дни недели в файле маршрутов собираются по рейсам
+    dataManager.markDirty(DataFile::Routes);
 }
 
 // Проверяет, можно ли отменить последнее действие
@@ -25,7 +55,10 @@ void TransportSystem::undo() {
     if (!canUndo()) {
         throw ContainerException("Нет действий для отмены");
     }
-    commandHistory.undo();
+    {
+        CommandScope scope(applyingCommand);
+        commandHistory.undo();
+    }
     std::cout << "Действие отменено.\n";
 }
 
@@ -39,7 +72,10 @@ void TransportSystem::redo() {
     if (!canRedo()) {
         throw ContainerException("Нет действий для повтора");
     }
-    commandHistory.redo();
+    {
+        CommandScope scope(applyingCommand);
+        commandHistory.redo();
+    }
     std::cout << "Действие повторено.\n";
 }
 
@@ -60,6 +96,10 @@ bool TransportSystem::authenticateAdmin(const std::string& username, const std::
 // Добавляет нового администратора в систему
 void TransportSystem::addAdmin(const std::string& username, const std::string& password) {
     adminCredentials[username] = password;
+    dataManager.markDirty(DataFile::Admins);
+    if (!bulkLoading) {
+        dataManager.getJournal().append(JournalAction::Execute, {CommandKind::AddAdmin, username + "|" + password});
+    }
 }
 
 const std::unordered_map<std::string, std::string>& TransportSystem::getAdminCredentials() const {
@@ -68,14 +108,47 @@ const std::unordered_map<std::string, std::string>& TransportSystem::getAdminCre
 
 void TransportSystem::setAdminCredentials(const std::unordered_map<std::string, std::string>& creds) {
     adminCredentials = creds;
+    noteDirectChange();
+    dataManager.markDirty(DataFile::Admins);
 }
 
 void TransportSystem::saveData() {
-    dataManager.saveAllData(*this);
+    lastSaveTime = std::chrono::steady_clock::now();
+    dataManager.saveChanges(*this);
 }
 
+std::shared_future<SaveResult> TransportSystem::saveDataAsync(std::function<void(const SaveResult&)> onComplete) {
+    lastSaveTime = std::chrono::steady_clock::now();
+    return dataManager.saveChangesAsync(*this, std::move(onComplete));
+}
+
+void TransportSystem::setAutosaveInterval(std::chrono::seconds interval) {
+    autosaveInterval = interval;
+}
+
+std::shared_future<SaveResult> TransportSystem::autosaveIfDue(std::function<void(const SaveResult&)> onComplete) {
+    if (autosaveInterval.count() <= 0 || bulkLoading || dataManager.isSaving() ||
+        std::chrono::steady_clock::now() - lastSaveTime < autosaveInterval) {
+        return {};
+    }
+    if (!dataManager.hasUnsavedChanges()) {
+        return {};
+    }
+    return saveDataAsync(std::move(onComplete));
+}
+
+// Загрузка идет в режиме массовой загрузки: без команд и записей в истории отмены,
+// индекс сети строится один раз после чтения всех файлов
 void TransportSystem::loadData() {
-    dataManager.loadAllData(*this);
+    beginBulkLoad();
+    lastSaveTime = std::chrono::steady_clock::now();
+    try {
+        dataManager.loadAllData(*this);
+    } catch (...) {
+        endBulkLoad();
+        throw;
+    }
+    endBulkLoad();
 }
 
 // Поиск маршрутов между двумя остановками
@@ -152,8 +225,16 @@ void TransportSystem::getStopTimetableAll(const std::string& stopName) {
 // Делегирует расчет времени прибытия алгоритму расчета времени.
 // Время рассчитывается на основе средней скорости и расстояния между остановками
 void TransportSystem::calculateArrivalTimes(int tripId, double averageSpeed) {
+    // Расписание рейса меняется на месте, а фоновое сохранение читает те же объекты рейсов
+    dataManager.waitForSave();
     // Используем алгоритм расчета времени прибытия
     arrivalTimeAlgorithm->calculateArrivalTimes(tripId, averageSpeed);
+    ++timetableVersion;
+    // Пересчет идет в обход команд: новое расписание записывается в журнал отдельно
+    if (auto trip = getTripById(tripId)) {
+        markTripDirty(*trip);
+        dataManager.getJournal().append(JournalAction::Execute, {CommandKind::UpdateTrip, trip->serialize()});
+    }
 }
 
 ArrivalTimeCalculationAlgorithm* TransportSystem::getArrivalTimeAlgorithm() const {
@@ -169,13 +250,15 @@ RouteSearchAlgorithm* TransportSystem::getRouteSearchAlgorithm() const {
 // (для возможности отмены операции)
 void TransportSystem::addRoute(std::shared_ptr<Route> route) {
     // Проверяем, что маршрут с таким номером еще не существует
-    for (const auto& existingRoute : routes) {
-        if (existingRoute->getNumber() == route->getNumber()) {
-            throw ContainerException("Маршрут с номером " + std::to_string(route->getNumber()) + " уже существует");
-        }
+    if (routesByNumber.count(route->getNumber())) {
+        throw ContainerException("Маршрут с номером " + std::to_string(route->getNumber()) + " уже существует");
+    }
+    if (bulkLoading) {
+        addRouteDirect(route);
+        return;
     }
     // Добавляем через систему команд (для поддержки undo/redo)
-    commandHistory.executeCommand(std::make_unique<AddRouteCommand>(this, route));
+    executeCommand(std::make_unique<AddRouteCommand>(this, route));
 }
 
 // Добавление рейса в систему
@@ -184,88 +267,78 @@ void TransportSystem::addRoute(std::shared_ptr<Route> route) {
 // Затем добавляет рейс через систему команд
 void TransportSystem::addTrip(std::shared_ptr<Trip> trip) {
     // Проверяем уникальность ID рейса
-    for (const auto& existingTrip : trips) {
-        if (existingTrip->getTripId() == trip->getTripId()) {
-            throw ContainerException("Рейс с ID " + std::to_string(trip->getTripId()) + " уже существует");
-        }
+    if (tripsById.count(trip->getTripId())) {
+        throw ContainerException("Рейс с ID " + std::to_string(trip->getTripId()) + " уже существует");
     }
 
     // Проверяем и добавляем водителя, если его еще нет в системе
-    bool driverExists = false;
     const auto& tripDriver = trip->getDriver();
-    for (const auto& existingDriver : drivers) {
-        if (existingDriver->getFirstName() == tripDriver->getFirstName() &&
-            existingDriver->getLastName() == tripDriver->getLastName() &&
-            existingDriver->getMiddleName() == tripDriver->getMiddleName()) {
-            driverExists = true;
-            break;
-        }
-    }
-    if (!driverExists) {
+    if (!driversByFullName.count(driverKey(tripDriver->getFirstName(), tripDriver->getLastName(),
+                                           tripDriver->getMiddleName()))) {
         addDriver(trip->getDriver());
     }
 
     // Проверяем и добавляем транспортное средство, если его еще нет в системе
-    bool vehicleExists = false;
-    const auto& tripVehicle = trip->getVehicle();
-    for (const auto& existingVehicle : vehicles) {
-        if (existingVehicle->getLicensePlate() == tripVehicle->getLicensePlate()) {
-            vehicleExists = true;
-            break;
-        }
-    }
-    if (!vehicleExists) {
+    if (!vehiclesByPlate.count(trip->getVehicle()->getLicensePlate())) {
         addVehicle(trip->getVehicle());
     }
 
+    if (bulkLoading) {
+        addTripDirect(trip);
+        return;
+    }
     // Добавляем рейс через систему команд
-    commandHistory.executeCommand(std::make_unique<AddTripCommand>(this, trip));
+    executeCommand(std::make_unique<AddTripCommand>(this, trip));
 }
 
 // Добавляет транспортное средство в систему (с проверкой уникальности номера)
 void TransportSystem::addVehicle(std::shared_ptr<Vehicle> vehicle) {
-    for (const auto& existingVehicle : vehicles) {
-        if (existingVehicle->getLicensePlate() == vehicle->getLicensePlate()) {
-            throw ContainerException("Транспортное средство с номером " + vehicle->getLicensePlate() + " уже существует");
-        }
+    if (vehiclesByPlate.count(vehicle->getLicensePlate())) {
+        throw ContainerException("Транспортное средство с номером " + vehicle->getLicensePlate() + " уже существует");
     }
-    commandHistory.executeCommand(std::make_unique<AddVehicleCommand>(this, vehicle));
+    if (bulkLoading) {
+        addVehicleDirect(vehicle);
+        return;
+    }
+    executeCommand(std::make_unique<AddVehicleCommand>(this, vehicle));
 }
 
 // Добавляет водителя в систему через систему команд
 void TransportSystem::addDriver(std::shared_ptr<Driver> driver) {
-    commandHistory.executeCommand(std::make_unique<AddDriverCommand>(this, driver));
+    if (bulkLoading) {
+        addDriverDirect(driver);
+        return;
+    }
+    executeCommand(std::make_unique<AddDriverCommand>(this, driver));
 }
 
 // Добавляет остановку в систему (с проверкой уникальности ID)
 void TransportSystem::addStop(const Stop& stop) {
-    for (const auto& existingStop : stops) {
-        if (existingStop.getId() == stop.getId()) {
-            throw ContainerException("Остановка с ID " + std::to_string(stop.getId()) + " уже существует");
-        }
+    if (stopsById.count(stop.getId())) {
+        throw ContainerException("Остановка с ID " + std::to_string(stop.getId()) + " уже существует");
     }
-    commandHistory.executeCommand(std::make_unique<AddStopCommand>(this, stop));
+    if (bulkLoading) {
+        addStopDirect(stop);
+        return;
+    }
+    executeCommand(std::make_unique<AddStopCommand>(this, stop));
 }
 
 // Удаляет маршрут из системы (с проверкой существования)
 void TransportSystem::removeRoute(int routeNumber) {
-    auto it = std::find_if(routes.begin(), routes.end(),
-                          [routeNumber](const auto& r) { return r->getNumber() == routeNumber; });
-    if (it == routes.end()) {
+    if (!routesByNumber.count(routeNumber)) {
         throw ContainerException("Маршрут с номером " + std::to_string(routeNumber) + " не найден");
     }
-    commandHistory.executeCommand(std::make_unique<RemoveRouteCommand>(this, routeNumber));
+    executeCommand(std::make_unique<RemoveRouteCommand>(this, routeNumber));
     std::cout << "Маршрут " << routeNumber << " удален.\n";
 }
 
 // Удаляет рейс из системы (с проверкой существования)
 void TransportSystem::removeTrip(int tripId) {
-    auto it = std::find_if(trips.begin(), trips.end(),
-                          [tripId](const auto& t) { return t->getTripId() == tripId; });
-    if (it == trips.end()) {
+    if (!tripsById.count(tripId)) {
         throw ContainerException("Рейс с ID " + std::to_string(tripId) + " не найден");
     }
-    commandHistory.executeCommand(std::make_unique<RemoveTripCommand>(this, tripId));
+    executeCommand(std::make_unique<RemoveTripCommand>(this, tripId));
     std::cout << "Рейс " << tripId << " удален.\n";
 }
 
@@ -337,34 +410,22 @@ DriverSchedule& TransportSystem::getDriverSchedule() {
 std::shared_ptr<Driver> TransportSystem::findDriverByName(const std::string& firstName,
                                         const std::string& lastName,
                                         const std::string& middleName) const {
-    for (const auto& driver : drivers) {
-        if (driver->getFirstName() == firstName &&
-            driver->getLastName() == lastName &&
-            (middleName.empty() || driver->getMiddleName() == middleName)) {
-            return driver;
-        }
-    }
-    return nullptr;  // Водитель не найден
+    const auto& index = middleName.empty() ? driversByShortName : driversByFullName;
+    auto it = index.find(middleName.empty() ? driverKey(firstName, lastName)
+                                            : driverKey(firstName, lastName, middleName));
+    return it != index.end() ? it->second : nullptr;  // nullptr - водитель не найден
 }
 
 // Находит транспортное средство по государственному номеру
 std::shared_ptr<Vehicle> TransportSystem::findVehicleByLicensePlate(const std::string& licensePlate) const {
-    for (const auto& vehicle : vehicles) {
-        if (vehicle->getLicensePlate() == licensePlate) {
-            return vehicle;
-        }
-    }
-    return nullptr;  // Транспортное средство не найдено
+    auto it = vehiclesByPlate.find(licensePlate);
+    return it != vehiclesByPlate.end() ? it->second : nullptr;  // nullptr - транспортное средство не найдено
 }
 
 // Находит маршрут по номеру
 std::shared_ptr<Route> TransportSystem::findRouteByNumber(int number) const {
-    for (const auto& route : routes) {
-        if (route->getNumber() == number) {
-            return route;
-        }
-    }
-    return nullptr;  // Маршрут не найден
+    auto it = routesByNumber.find(number);
+    return it != routesByNumber.end() ? it->second : nullptr;  // nullptr - маршрут не найден
 }
 
 // Получает список всех рейсов, проходящих через указанную остановку
@@ -386,99 +447,229 @@ std::string TransportSystem::getStopNameById(int id) const {
     return "";
 }
 
+unsigned long long TransportSystem::getTimetableVersion() const {
+    return timetableVersion;
+}
+
 std::shared_ptr<Route> TransportSystem::getRouteByNumber(int number) {
-    for (const auto& route : routes) {
-        if (route->getNumber() == number) {
-            return route;
-        }
-    }
-    return nullptr;
+    return findRouteByNumber(number);
 }
 
 std::shared_ptr<Trip> TransportSystem::getTripById(int id) {
-    for (const auto& trip : trips) {
-        if (trip->getTripId() == id) {
-            return trip;
-        }
-    }
-    return nullptr;
+    auto it = tripsById.find(id);
+    return it != tripsById.end() ? it->second : nullptr;
 }
 
 std::shared_ptr<Vehicle> TransportSystem::getVehicleByLicensePlate(const std::string& licensePlate) {
-    for (const auto& vehicle : vehicles) {
-        if (vehicle->getLicensePlate() == licensePlate) {
-            return vehicle;
-        }
-    }
-    return nullptr;
+    return findVehicleByLicensePlate(licensePlate);
 }
 
 Stop TransportSystem::getStopById(int id) {
-    for (const auto& stop : stops) {
-        if (stop.getId() == id) {
-            return stop;
-        }
+    auto it = stopsById.find(id);
+    if (it != stopsById.end()) {
+        return it->second;
     }
     throw ContainerException("Остановка с ID " + std::to_string(id) + " не найдена");
 }
 
+void TransportSystem::beginBulkLoad() {
+    bulkLoading = true;
+}
+
+// Загрузка не должна отменяться, поэтому история начинается с чистого листа
+void TransportSystem::endBulkLoad() {
+    bulkLoading = false;
+    ++timetableVersion;
+    commandHistory.clear();
+    journeyPlanner.getTimetableIndex();
+}
+
+bool TransportSystem::isBulkLoading() const {
+    return bulkLoading;
+}
+
+void TransportSystem::addVehiclesDirect(const List<std::shared_ptr<Vehicle>>& batch) {
+    vehiclesByPlate.reserve(vehiclesByPlate.size() + batch.size());
+    for (const auto& vehicle : batch) {
+        addVehicleDirect(vehicle);
+    }
+}
+
+void TransportSystem::addDriversDirect(const List<std::shared_ptr<Driver>>& batch) {
+    driversByFullName.reserve(driversByFullName.size() + batch.size());
+    driversByShortName.reserve(driversByShortName.size() + batch.size());
+    for (const auto& driver : batch) {
+        addDriverDirect(driver);
+    }
+}
+
+void TransportSystem::addTripsDirect(const List<std::shared_ptr<Trip>>& batch) {
+    noteDirectChange();
+    tripsById.reserve(tripsById.size() + batch.size());
+    for (const auto& trip : batch) {
+        tripsById.emplace(trip->getTripId(), trip);
+        trips.push_back(trip);
+        markTripDirty(*trip);
+    }
+    ++timetableVersion;
+}
+
+bool TransportSystem::hasStop(int id) const {
+    return stopsById.count(id) != 0;
+}
+
+bool TransportSystem::hasDriver(const std::string& firstName, const std::string& lastName,
+                                const std::string& middleName) const {
+    return driversByFullName.count(driverKey(firstName, lastName, middleName)) != 0;
+}
+
+// Методы *Direct изменяют списки и поддерживают хеш-индексы
+// Индекс указывает на первый элемент списка с данным ключом (как прежний линейный поиск),
+// поэтому при удалении индекс переключается на следующий элемент с тем же ключом, если он есть.
+// Удаление и так требует прохода по списку, поэтому поиск замены не меняет его сложности
 void TransportSystem::addRouteDirect(std::shared_ptr<Route> route) {
+    noteDirectChange();
+    dataManager.markDirty(DataFile::Routes);
+    routesByNumber.emplace(route->getNumber(), route);
     routes.push_back(std::move(route));
+    ++timetableVersion;
 }
 
 void TransportSystem::removeRouteDirect(int routeNumber) {
+    noteDirectChange();
     auto it = std::find_if(routes.begin(), routes.end(),
                           [routeNumber](const auto& r) { return r->getNumber() == routeNumber; });
     if (it != routes.end()) {
         routes.erase(it);
+        dataManager.markDirty(DataFile::Routes);
+        routesByNumber.erase(routeNumber);
+        for (const auto& route : routes) {
+            if (route->getNumber() == routeNumber) {
+                routesByNumber.emplace(routeNumber, route);
+                break;
+            }
+        }
+        ++timetableVersion;
     }
 }
 
 void TransportSystem::addTripDirect(std::shared_ptr<Trip> trip) {
+    noteDirectChange();
+    markTripDirty(*trip);
+    tripsById.emplace(trip->getTripId(), trip);
     trips.push_back(std::move(trip));
+    ++timetableVersion;
 }
 
 void TransportSystem::removeTripDirect(int tripId) {
+    noteDirectChange();
     auto it = std::find_if(trips.begin(), trips.end(),
                           [tripId](const auto& t) { return t->getTripId() == tripId; });
     if (it != trips.end()) {
+        markTripDirty(**it);
         trips.erase(it);
+        tripsById.erase(tripId);
+        for (const auto& trip : trips) {
+            if (trip->getTripId() == tripId) {
+                tripsById.emplace(tripId, trip);
+                break;
+            }
+        }
+        ++timetableVersion;
+    }
+}
+
+// Расписание меняется на месте, как при calculateArrivalTimes: ждем фоновое сохранение,
+// отмечаем файлы рейса и маршрутов, чтобы следующее сохранение записало новое расписание
+void TransportSystem::updateTripScheduleDirect(int tripId, const std::map<std::string, Time>& schedule) {
+    auto trip = getTripById(tripId);
+    if (!trip) {
+        return;
+    }
+    dataManager.waitForSave();
+    noteDirectChange();
+    markTripDirty(*trip);
+    for (const auto& [stop, time] : schedule) {
+        trip->setArrivalTime(stop, time);
     }
+    ++timetableVersion;
 }
 
 void TransportSystem::addVehicleDirect(std::shared_ptr<Vehicle> vehicle) {
+    noteDirectChange();
+    dataManager.markDirty(DataManager::getVehicleFile(vehicle->getType()));
+    vehiclesByPlate.emplace(vehicle->getLicensePlate(), vehicle);
     vehicles.push_back(std::move(vehicle));
 }
 
 void TransportSystem::removeVehicleDirect(const std::string& licensePlate) {
+    noteDirectChange();
     auto it = std::find_if(vehicles.begin(), vehicles.end(),
                           [&licensePlate](const auto& v) {
                               return v->getLicensePlate() == licensePlate;
                           });
     if (it != vehicles.end()) {
+        dataManager.markDirty(DataManager::getVehicleFile((*it)->getType()));
         vehicles.erase(it);
+        vehiclesByPlate.erase(licensePlate);
+        for (const auto& vehicle : vehicles) {
+            if (vehicle->getLicensePlate() == licensePlate) {
+                vehiclesByPlate.emplace(licensePlate, vehicle);
+                break;
+            }
+        }
     }
 }
 
 void TransportSystem::addStopDirect(const Stop& stop) {
+    noteDirectChange();
+    dataManager.markDirty(DataFile::Stops);
     stops.push_back(stop);
     stopIdToName[stop.getId()] = stop.getName();
+    stopsById.emplace(stop.getId(), stop);
+    ++timetableVersion;
 }
 
 void TransportSystem::removeStopDirect(int stopId) {
+    noteDirectChange();
     auto it = std::find_if(stops.begin(), stops.end(),
                           [stopId](const auto& s) { return s.getId() == stopId; });
     if (it != stops.end()) {
         stopIdToName.erase(stopId);
         stops.erase(it);
+        dataManager.markDirty(DataFile::Stops);
+        stopsById.erase(stopId);
+        for (const auto& stop : stops) {
+            if (stop.getId() == stopId) {
+                stopsById.emplace(stopId, stop);
+                break;
+            }
+        }
+        ++timetableVersion;
     }
 }
 
+std::string TransportSystem::driverKey(const std::string& firstName, const std::string& lastName) {
+    // Разделитель не встречается в именах
+    return lastName + '\x1f' + firstName;
+}
+
+std::string TransportSystem::driverKey(const std::string& firstName, const std::string& lastName,
+                                       const std::string& middleName) {
+    return driverKey(firstName, lastName) + '\x1f' + middleName;
+}
+
 void TransportSystem::addDriverDirect(std::shared_ptr<Driver> driver) {
+    noteDirectChange();
+    dataManager.markDirty(DataFile::Drivers);
+    driversByFullName.emplace(driverKey(driver->getFirstName(), driver->getLastName(), driver->getMiddleName()),
+                              driver);
+    driversByShortName.emplace(driverKey(driver->getFirstName(), driver->getLastName()), driver);
     drivers.push_back(std::move(driver));
 }
 
 void TransportSystem::removeDriverDirect(std::shared_ptr<Driver> driver) {
+    noteDirectChange();
     auto it = std::find_if(drivers.begin(), drivers.end(),
                           [&driver](const auto& d) {
                               return d->getFirstName() == driver->getFirstName() &&
@@ -487,6 +678,20 @@ void TransportSystem::removeDriverDirect(std::shared_ptr<Driver> driver) {
                           });
     if (it != drivers.end()) {
         drivers.erase(it);
+        dataManager.markDirty(DataFile::Drivers);
+        std::string fullKey = driverKey(driver->getFirstName(), driver->getLastName(), driver->getMiddleName());
+        std::string shortKey = driverKey(driver->getFirstName(), driver->getLastName());
+        driversByFullName.erase(fullKey);
+        driversByShortName.erase(shortKey);
+        for (const auto& d : drivers) {
+            if (d->getFirstName() == driver->getFirstName() && d->getLastName() == driver->getLastName()) {
+                driversByShortName.emplace(shortKey, d);
+                if (d->getMiddleName() == driver->getMiddleName()) {
+                    driversByFullName.emplace(fullKey, d);
+                    break;
+                }
+            }
+        }
     }
 }
 
@@ -3,6 +3,10 @@
 
 #include <string>
 #include <memory>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
 #include <unordered_map>
 #include "list.h"
 #include "stop.h"
@@ -30,13 +34,39 @@ private:
     List<std::shared_ptr<Driver>> drivers;
     List<Stop> stops;
     std::unordered_map<int, std::string> stopIdToName;
+    // Хеш-индексы для поиска по ключу за O(1); поддерживаются методами *Direct
+    // При повторяющихся ключах индекс указывает на первый по порядку элемент списка
+    std::unordered_map<int, std::shared_ptr<Route>> routesByNumber;
+    std::unordered_map<int, std::shared_ptr<Trip>> tripsById;
+    std::unordered_map<std::string, std::shared_ptr<Vehicle>> vehiclesByPlate;
+    std::unordered_map<std::string, std::shared_ptr<Driver>> driversByFullName;   // Фамилия, имя, отчество
+    std::unordered_map<std::string, std::shared_ptr<Driver>> driversByShortName;  // Фамилия и имя
+    std::unordered_map<int, Stop> stopsById;
     std::unordered_map<std::string, std::string> adminCredentials;
+    unsigned long long timetableVersion = 0;  // Увеличивается при каждом изменении сети или расписания
+    bool bulkLoading = false;                 // Идет массовая загрузка (без команд и истории отмены)
+    bool applyingCommand = false;             // Изменения вносит команда (они попадают в журнал)
+    std::chrono::seconds autosaveInterval{0};             // Период автосохранения (0 - выключено)
+    std::chrono::steady_clock::time_point lastSaveTime;   // Начало последнего сохранения или загрузки
 
     JourneyPlanner journeyPlanner;
     DriverSchedule driverSchedule;
     DataManager dataManager;
     CommandHistory commandHistory;
     
+    // Выполнить команду через историю (с записью в журнал изменений)
+    void executeCommand(std::unique_ptr<Command> cmd);
+    // Отметить изменение методом *Direct: вне загрузки и команд его нет в журнале,
+    // поэтому следующее сохранение запишет файлы данных, а не только журнал
+    void noteDirectChange();
+    // Отметить файлы рейса и маршрутов как измененные для выборочного сохранения
+    void markTripDirty(const Trip& trip);
+
+    // Ключи индекса водителей
+    static std::string driverKey(const std::string& firstName, const std::string& lastName);
+    static std::string driverKey(const std::string& firstName, const std::string& lastName,
+                                 const std::string& middleName);
+
     // Алгоритмы (Strategy pattern)
     std::unique_ptr<ArrivalTimeCalculationAlgorithm> arrivalTimeAlgorithm;
     std::unique_ptr<RouteSearchAlgorithm> routeSearchAlgorithm;
@@ -56,9 +86,21 @@ public:
     const std::unordered_map<std::string, std::string>& getAdminCredentials() const;
     void setAdminCredentials(const std::unordered_map<std::string, std::string>& creds);
 
+    // Сохранить изменения (обычно дописыванием журнала, см. DataManager::saveChanges)
     void saveData();
+    // То же без ожидания записи файлов: копия состояния пишется в фоне, а система может
+    // изменяться дальше. Сообщения не печатаются, а приходят в SaveResult; onComplete
+    // вызывается в потоке записи (или сразу, если сохранение не понадобилось запускать в фоне)
+    std::shared_future<SaveResult> saveDataAsync(std::function<void(const SaveResult&)> onComplete = nullptr);
     void loadData();
 
+    // Автосохранение раз в interval (0 - выключить)
+    void setAutosaveInterval(std::chrono::seconds interval);
+    // Начать фоновое сохранение, если период автосохранения прошел и есть несохраненные
+    // изменения. Вызывается из цикла интерфейса (меню, таймер окна). Возвращает ожидание
+    // начатого сохранения или пустой future (valid() == false), если сохранять не нужно
+    std::shared_future<SaveResult> autosaveIfDue(std::function<void(const SaveResult&)> onComplete = nullptr);
+
     List<std::shared_ptr<Route>> findRoutes(const std::string& stopA, const std::string& stopB);
     void getStopTimetable(int stopId, const Time& startTime, const Time& endTime);
     void getStopTimetableAll(const std::string& stopName);
@@ -98,15 +140,38 @@ public:
     List<std::shared_ptr<Trip>> getTripsThroughStop(const std::string& stopName) const;
     std::string getStopNameById(int id) const;
 
+    // Версия расписания: меняется при добавлении/удалении маршрутов, рейсов, остановок
+    // и при пересчете времени прибытия. Используется для сброса кэшей планировщика
+    unsigned long long getTimetableVersion() const;
+
     std::shared_ptr<Route> getRouteByNumber(int number);
     std::shared_ptr<Trip> getTripById(int id);
     std::shared_ptr<Vehicle> getVehicleByLicensePlate(const std::string& licensePlate);
     Stop getStopById(int id);
 
+    // Массовая загрузка данных
+    // Между beginBulkLoad и endBulkLoad методы add* добавляют объекты напрямую, без команд
+    // и записей в истории отмены. endBulkLoad один раз строит индекс сети и очищает историю
+    void beginBulkLoad();
+    void endBulkLoad();
+    bool isBulkLoading() const;
+
+    // Пакетное добавление без проверки дубликатов (вызывающий код проверяет их сам)
+    void addVehiclesDirect(const List<std::shared_ptr<Vehicle>>& batch);
+    void addDriversDirect(const List<std::shared_ptr<Driver>>& batch);
+    void addTripsDirect(const List<std::shared_ptr<Trip>>& batch);
+
+    // Проверка наличия по ключу (точное совпадение ФИО)
+    bool hasStop(int id) const;
+    bool hasDriver(const std::string& firstName, const std::string& lastName,
+                   const std::string& middleName) const;
+
     void addRouteDirect(std::shared_ptr<Route> route);
     void removeRouteDirect(int routeNumber);
     void addTripDirect(std::shared_ptr<Trip> trip);
     void removeTripDirect(int tripId);
+    // Установить времена прибытия рейса (например, при воспроизведении пересчета из журнала)
+    void updateTripScheduleDirect(int tripId, const std::map<std::string, Time>& schedule);
     void addVehicleDirect(std::shared_ptr<Vehicle> vehicle);
     void removeVehicleDirect(const std::string& licensePlate);
     void addStopDirect(const Stop& stop);
@@ -3,7 +3,7 @@
 #include "bus.h"
 #include "tram.h"
 #include "trolleybus.h"
-#include <sstream>
+#include "record_parser.h"
 
 // Конструктор рейса
 // Расписание прибытия на остановки устанавливается отдельно через setArrivalTime
@@ -94,24 +94,19 @@ std::string Trip::serialize() const {
     return result;
 }
 
-std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem* system) {
+std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem* system, bool registerMissing) {
     // Парсим строку
     // Новый формат: tripId|route_number|vehicle(5)|driver(4)|time|weekDay|schedule = 13 токенов
     // Старый формат: tripId|route(4)|vehicle(5)|driver(4)|time|weekDay|schedule = 17 токенов
 
-    std::istringstream ss(data);
-    std::string token;
-    List<std::string> tokens;
-
-    while (std::getline(ss, token, '|')) {
-        tokens.push_back(token);
-    }
+    // Поля - представления строки data, копируются только сохраняемые значения
+    RecordFields tokens(data);
 
     if (tokens.size() < 6) {
         throw InputException("Некорректные данные рейса");
     }
 
-    int tripId = std::stoi(tokens[0]);
+    int tripId = RecordParser::parseInt(tokens[0]);
 
     std::shared_ptr<Route> route;
     int vehicleTokenIndex, driverTokenIndex, timeTokenIndex, scheduleTokenIndex;
@@ -127,7 +122,7 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
         // В старом формате: tokens[1] = route_number, tokens[2] = route_vehicleType
         // В новом формате: tokens[1] = route_number, tokens[2] = vehicle_type
         // Проверяем tokens[3]: если это список остановок (содержит ';'), то это старый формат
-        if (tokens.size() > 3 && tokens[3].find(';') != std::string::npos) {
+        if (tokens.size() > 3 && tokens[3].find(';') != std::string_view::npos) {
             // Это старый формат - tokens[3] содержит остановки маршрута
             isNewFormat = false;
         } else {
@@ -145,7 +140,7 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
             throw InputException("Для загрузки рейса требуется система (для поиска маршрута по номеру)");
         }
 
-        int routeNumber = std::stoi(tokens[1]);
+        int routeNumber = RecordParser::parseInt(tokens[1]);
         route = system->getRouteByNumber(routeNumber);
         if (!route) {
             throw ContainerException("Маршрут с номером " + std::to_string(routeNumber) + " не найден");
@@ -157,7 +152,7 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
         // Для Bus, Tram, Trolleybus всегда 5 токенов (type|model|licensePlate|capacity|fuelType/voltage)
         // Для базового Vehicle - 3 токена (type|model|licensePlate)
         // Проверяем тип vehicle (tokens[2]) - если это "Автобус", "Трамвай" или "Троллейбус", то vehicle имеет 5 токенов
-        std::string vehicleType = tokens[2];
+        std::string_view vehicleType = tokens[2];
         bool vehicleHasCapacity = (vehicleType == "Автобус" || vehicleType == "Трамвай" || vehicleType == "Троллейбус");
         int vehicleTokenCount = vehicleHasCapacity ? 5 : 3;
 
@@ -167,7 +162,7 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
     } else {
         // Старый формат: полная сериализация маршрута
         // Проверяем наличие weekDays в route (токен с запятыми)
-        bool hasRouteWeekDays = (tokens.size() > 4 && tokens[4].find(',') != std::string::npos);
+        bool hasRouteWeekDays = (tokens.size() > 4 && tokens[4].find(',') != std::string_view::npos);
 
     int routeTokenCount = hasRouteWeekDays ? 4 : 3;
     int routeEndIndex = 1 + routeTokenCount;  // Индекс после route
@@ -186,16 +181,14 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
 
     if (hasRouteWeekDays) {
         // Route с weekDays (4 токена)
-        std::string routeData = tokens[1] + "|" + tokens[2] + "|" + tokens[3] + "|" + tokens[4];
-        route = Route::deserialize(routeData);
+        route = Route::deserialize(tokens.join(1, 4));
         vehicleTokenIndex = routeEndIndex;  // vehicle начинается сразу после route (индекс 5)
         driverTokenIndex = routeEndIndex + vehicleTokenCount;  // driver после vehicle (индекс 10)
         timeTokenIndex = driverTokenIndex + 4;  // time после driver (4 токена) (индекс 14)
         scheduleTokenIndex = timeTokenIndex + 2;  // schedule после time и weekDay (индекс 16)
-    } else if (tokens.size() > 3 && tokens[3].find(';') != std::string::npos) {
+    } else if (tokens.size() > 3 && tokens[3].find(';') != std::string_view::npos) {
         // Route без weekDays (3 токена)
-        std::string routeData = tokens[1] + "|" + tokens[2] + "|" + tokens[3];
-        route = Route::deserialize(routeData);
+        route = Route::deserialize(tokens.join(1, 3));
         vehicleTokenIndex = routeEndIndex;  // vehicle начинается сразу после route (индекс 4)
         driverTokenIndex = routeEndIndex + vehicleTokenCount;  // driver после vehicle
         timeTokenIndex = driverTokenIndex + 4;  // time после driver (4 токена)
@@ -212,7 +205,7 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
 
     std::shared_ptr<Vehicle> vehicle = nullptr;
     if (system) {
-        std::string type, model, licensePlate;
+        std::string_view type, model, plate;
 
         if (tokens.size() >= 11) {
             // Новый формат - vehicle разбит на отдельные токены
@@ -220,60 +213,55 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
             if (vehicleTokenIndex + 2 < tokens.size()) {
                 type = tokens[vehicleTokenIndex];
                 model = tokens[vehicleTokenIndex + 1];
-                licensePlate = tokens[vehicleTokenIndex + 2];
+                plate = tokens[vehicleTokenIndex + 2];
                 // capacity и fuelType/voltage игнорируем при поиске vehicle по licensePlate
             } else {
                 throw InputException("Недостаточно токенов для vehicle");
             }
         } else {
             // Старый формат - vehicle в одном токене
-            std::istringstream vehicleStream(tokens[vehicleTokenIndex]);
-            std::getline(vehicleStream, type, '|');
-            std::getline(vehicleStream, model, '|');
-            std::getline(vehicleStream, licensePlate);
+            FieldSplitter vehicleFields(tokens[vehicleTokenIndex], '|');
+            type = vehicleFields.next();
+            model = vehicleFields.next();
+            plate = vehicleFields.remainder();
         }
 
+        std::string licensePlate(plate);
         vehicle = system->findVehicleByLicensePlate(licensePlate);
 
         if (!vehicle && tokens.size() >= 11) {
+            if (!registerMissing) {
+                return nullptr;
+            }
             std::shared_ptr<Vehicle> newVehicle;
             if (type == "Автобус") {
                 // Пытаемся получить capacity и fuelType, если они есть
                 int capacity = 50;
                 std::string fuelType = "дизель";
-                if (vehicleTokenIndex + 4 < tokens.size()) {
-                    try {
-                        capacity = std::stoi(tokens[vehicleTokenIndex + 3]);
-                        fuelType = tokens[vehicleTokenIndex + 4];
-                    } catch (...) {
-                        // Используем значения по умолчанию
-                    }
+                // Если capacity не число, используем значения по умолчанию
+                if (vehicleTokenIndex + 4 < tokens.size() &&
+                    RecordParser::tryParseInt(tokens[vehicleTokenIndex + 3], capacity)) {
+                    fuelType = tokens[vehicleTokenIndex + 4];
                 }
-                newVehicle = std::make_shared<Bus>(model, licensePlate, capacity, fuelType);
+                newVehicle = std::make_shared<Bus>(std::string(model), licensePlate, capacity, fuelType);
             } else if (type == "Трамвай") {
                 int capacity = 50;
                 double voltage = 600.0;
-                if (vehicleTokenIndex + 4 < tokens.size()) {
-                    try {
-                        capacity = std::stoi(tokens[vehicleTokenIndex + 3]);
-                        voltage = std::stod(tokens[vehicleTokenIndex + 4]);
-                    } catch (...) {
-                        // Используем значения по умолчанию
-                    }
+                // Значения, которые не удалось разобрать, остаются по умолчанию
+                if (vehicleTokenIndex + 4 < tokens.size() &&
+                    RecordParser::tryParseInt(tokens[vehicleTokenIndex + 3], capacity)) {
+                    RecordParser::tryParseDouble(tokens[vehicleTokenIndex + 4], voltage);
                 }
-                newVehicle = std::make_shared<Tram>(model, licensePlate, capacity, voltage);
+                newVehicle = std::make_shared<Tram>(std::string(model), licensePlate, capacity, voltage);
             } else if (type == "Троллейбус") {
                 int capacity = 50;
                 double voltage = 600.0;
-                if (vehicleTokenIndex + 4 < tokens.size()) {
-                    try {
-                        capacity = std::stoi(tokens[vehicleTokenIndex + 3]);
-                        voltage = std::stod(tokens[vehicleTokenIndex + 4]);
-                    } catch (...) {
-                        // Используем значения по умолчанию
-                    }
+                // Значения, которые не удалось разобрать, остаются по умолчанию
+                if (vehicleTokenIndex + 4 < tokens.size() &&
+                    RecordParser::tryParseInt(tokens[vehicleTokenIndex + 3], capacity)) {
+                    RecordParser::tryParseDouble(tokens[vehicleTokenIndex + 4], voltage);
                 }
-                newVehicle = std::make_shared<Trolleybus>(model, licensePlate, capacity, voltage);
+                newVehicle = std::make_shared<Trolleybus>(std::string(model), licensePlate, capacity, voltage);
             }
             if (newVehicle) {
                 try {
@@ -290,15 +278,18 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
     if (tokens.size() >= 11) {
         // Новый формат - driver разбит на отдельные токены
         if (driverTokenIndex + 3 < tokens.size()) {
-            std::string firstName = tokens[driverTokenIndex];
-            std::string lastName = tokens[driverTokenIndex + 1];
-            std::string middleName = tokens[driverTokenIndex + 2];
-            std::string category = tokens[driverTokenIndex + 3];
+            std::string firstName(tokens[driverTokenIndex]);
+            std::string lastName(tokens[driverTokenIndex + 1]);
+            std::string middleName(tokens[driverTokenIndex + 2]);
 
             driver = system ? system->findDriverByName(firstName, lastName, middleName) : nullptr;
 
             if (!driver) {
-                driver = std::make_shared<Driver>(firstName, lastName, middleName, category);
+                if (system && !registerMissing) {
+                    return nullptr;
+                }
+                driver = std::make_shared<Driver>(firstName, lastName, middleName,
+                                                  std::string(tokens[driverTokenIndex + 3]));
                 if (system) {
                     try {
                         system->addDriver(driver);
@@ -320,6 +311,8 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
                 driver->getMiddleName());
             if (existingDriver) {
                 driver = existingDriver;
+            } else if (!registerMissing) {
+                return nullptr;
             } else {
                 try {
                     system->addDriver(driver);
@@ -337,14 +330,13 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
     int weekDay = 1;
     // weekDay находится сразу после startTime
     if (timeTokenIndex + 1 < tokens.size()) {
-        try {
-            weekDay = std::stoi(tokens[timeTokenIndex + 1]);
+        if (RecordParser::tryParseInt(tokens[timeTokenIndex + 1], weekDay)) {
             if (weekDay < 1 || weekDay > 7) weekDay = 1;
             // schedule начинается после weekDay
             if (scheduleTokenIndex <= timeTokenIndex + 1) {
                 scheduleTokenIndex = timeTokenIndex + 2;
             }
-        } catch (...) {
+        } else {
             // Если не удалось распарсить weekDay, используем значение по умолчанию
             if (scheduleTokenIndex <= timeTokenIndex + 1) {
                 scheduleTokenIndex = timeTokenIndex + 1;
@@ -364,14 +356,13 @@ std::shared_ptr<Trip> Trip::deserialize(const std::string& data, TransportSystem
     auto trip = std::make_shared<Trip>(tripId, route, vehicle, driver, startTime, weekDay);
 
     if (scheduleTokenIndex < tokens.size() && !tokens[scheduleTokenIndex].empty()) {
-        std::istringstream scheduleStream(tokens[scheduleTokenIndex]);
-        std::string stopTimePair;
-        while (std::getline(scheduleStream, stopTimePair, ';')) {
+        FieldSplitter scheduleFields(tokens[scheduleTokenIndex], ';');
+        std::string_view stopTimePair;
+        while (scheduleFields.next(stopTimePair)) {
             size_t eqPos = stopTimePair.find('=');
-            if (eqPos != std::string::npos) {
-                std::string stop = stopTimePair.substr(0, eqPos);
-                std::string timeStr = stopTimePair.substr(eqPos + 1);
-                trip->setArrivalTime(stop, Time::deserialize(timeStr));
+            if (eqPos != std::string_view::npos) {
+                std::string stop(stopTimePair.substr(0, eqPos));
+                trip->setArrivalTime(stop, Time::deserialize(stopTimePair.substr(eqPos + 1)));
             }
         }
     }
@@ -55,7 +55,12 @@ public:
 
     // Сериализация
     std::string serialize() const;
-    static std::shared_ptr<Trip> deserialize(const std::string& data, TransportSystem* system = nullptr);
+    // Транспорт и водитель рейса ищутся в system; отсутствующие создаются и добавляются
+    // в систему. При registerMissing = false система не изменяется (можно вызывать из
+    // нескольких потоков одновременно), а если рейсу нужен новый транспорт или водитель,
+    // возвращается nullptr - такую строку нужно разобрать повторно с registerMissing = true
+    static std::shared_ptr<Trip> deserialize(const std::string& data, TransportSystem* system = nullptr,
+                                             bool registerMissing = true);
 };
 
 #endif // TRIP_H
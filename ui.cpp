@@ -9,8 +9,11 @@
 #include "trip.h"
 #include "time.h"
 #include "stop.h"
+#include "mapped_dataset.h"
 #include <iostream>
 #include <limits>
+#include <chrono>
+#include <future>
 #include <algorithm>
 #include <string>
 #include <cctype>
@@ -192,6 +195,14 @@ void displayGuestMenu() {
     std::cout << "Выберите опцию: ";
 }
 
+void displayReplicaMenu() {
+    std::cout << "\n=== РЕЖИМ РЕПЛИКИ (ТОЛЬКО ЧТЕНИЕ) ===\n";
+    std::cout << "1. Поиск маршрута с самым ранним прибытием\n";
+    std::cout << "2. Отправления с остановки\n";
+    std::cout << "0. Выход\n";
+    std::cout << "Выберите опцию: ";
+}
+
 void displayAdminMenu() {
     std::cout << "\n=== АДМИНИСТРАТИВНЫЙ РЕЖИМ ===\n";
     std::cout << "1. Просмотр расписания транспорта\n";
@@ -1039,6 +1050,119 @@ void runGuestMode(TransportSystem& system) {
     }
 }
 
+// Ввод дня недели для запросов реплики (0 - все дни)
+static int readWeekDay() {
+    std::cout << "Введите день недели (1-7, 0 - любой): ";
+    int weekDay;
+    if (!(std::cin >> weekDay)) {
+        std::cin.clear();
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+        throw InputException("Неверный формат ввода дня недели");
+    }
+    std::cin.ignore();
+    if (weekDay < 0 || weekDay > 7) {
+        throw InputException("Неверный день недели. Допустимые значения: 0-7");
+    }
+    return weekDay;
+}
+
+static void replicaFindJourney(const MappedDataset& dataset) {
+    std::string start, end, time;
+    std::cout << "Введите начальную остановку: ";
+    std::getline(std::cin, start);
+    std::cout << "Введите конечную остановку: ";
+    std::getline(std::cin, end);
+    std::cout << "Введите время отправления (ЧЧ:ММ): ";
+    std::getline(std::cin, time);
+    Time departure(time);
+    int weekDay = readWeekDay();
+
+    auto journey = dataset.findEarliestJourney(start, end, departure, weekDay);
+    if (!journey) {
+        std::cout << "Маршрут не найден.\n";
+        return;
+    }
+    std::cout << "\nПрибытие: " << Time(0, journey->arrival)
+              << ", пересадок: " << journey->getTransferCount() << "\n";
+    for (const auto& leg : journey->legs) {
+        std::cout << "  Маршрут " << leg.routeNumber << " (рейс " << leg.tripId << "): "
+                  << dataset.getStopName(leg.fromStop) << " " << Time(0, leg.departure) << " -> "
+                  << dataset.getStopName(leg.toStop) << " " << Time(0, leg.arrival) << "\n";
+    }
+}
+
+static void replicaShowDepartures(const MappedDataset& dataset) {
+    std::string stop, from, to;
+    std::cout << "Введите остановку: ";
+    std::getline(std::cin, stop);
+    std::cout << "Введите начало интервала (ЧЧ:ММ): ";
+    std::getline(std::cin, from);
+    std::cout << "Введите конец интервала (ЧЧ:ММ): ";
+    std::getline(std::cin, to);
+    Time fromTime(from);
+    Time toTime(to);
+    int weekDay = readWeekDay();
+
+    if (dataset.getStopIndex(stop) < 0) {
+        throw InputException("Остановка не найдена: " + stop);
+    }
+    auto departures = dataset.getDepartures(stop, fromTime, toTime, weekDay);
+    if (departures.empty()) {
+        std::cout << "Отправлений в этом интервале нет.\n";
+        return;
+    }
+    for (const auto& departure : departures) {
+        std::cout << "  " << Time(0, departure.time) << " маршрут " << departure.routeNumber
+                  << " (рейс " << departure.tripId << "), далее: "
+                  << dataset.getStopName(departure.nextStop) << "\n";
+    }
+}
+
+void runReplicaMode(const MappedDataset& dataset) {
+    std::cout << "Снимок открыт: " << dataset.getStopCount() << " остановок, "
+              << dataset.getConnectionCount() << " соединений\n";
+
+    int choice;
+    bool running = true;
+
+    while (running) {
+        displayReplicaMenu();
+        if (!(std::cin >> choice)) {
+            std::cin.clear();
+            std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+            std::cout << "Ошибка: ожидается число. Пожалуйста, введите только цифры.\n";
+            continue;
+        }
+        std::cin.ignore();
+
+        try {
+            switch (choice) {
+                case 0: running = false; break;
+                case 1: replicaFindJourney(dataset); break;
+                case 2: replicaShowDepartures(dataset); break;
+                default: std::cout << "Неверный выбор.\n";
+            }
+        } catch (const InputException& e) {
+            std::cout << e.what() << '\n';
+        } catch (const std::exception& e) {
+            std::cout << "Неожиданная ошибка: " << e.what() << '\n';
+        }
+    }
+}
+
+// Напечатать итог фонового сохранения, если оно закончилось (wait - дождаться его)
+// Итоги печатаются только здесь, между вводами меню, а не потоком записи
+static void reportSave(std::shared_future<SaveResult>& save, bool wait) {
+    if (!save.valid()) {
+        return;
+    }
+    if (!wait && save.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+        return;
+    }
+    std::cout << save.get().messages;
+    save = {};
+}
+
 void runAdminMode(TransportSystem& system) {
     std::string username, password;
 
@@ -1056,8 +1180,14 @@ void runAdminMode(TransportSystem& system) {
 
     int choice;
     bool running = true;
+    std::shared_future<SaveResult> pendingSave;  // Фоновое сохранение, итог которого еще не напечатан
 
     while (running) {
+        // Автосохранение в фоне, если с последнего сохранения прошло достаточно времени
+        if (!pendingSave.valid()) {
+            pendingSave = system.autosaveIfDue();
+        }
+        reportSave(pendingSave, false);
         displayAdminMenu();
         if (!(std::cin >> choice)) {
             std::cin.clear();
@@ -1151,7 +1281,16 @@ void runAdminMode(TransportSystem& system) {
                     system.displayAllStops();
                     break;
                 }
-                case 13: system.saveData(); break;
+                case 13:
+                    // Файлы пишутся в фоне из копии данных, работу можно продолжать
+                    reportSave(pendingSave, true);
+                    pendingSave = system.saveDataAsync();
+                    if (pendingSave.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                        reportSave(pendingSave, true);
+                    } else {
+                        std::cout << "Сохранение запущено в фоне.\n";
+                    }
+                    break;
                 case 14: {
                     if (system.canUndo()) {
                         std::string lastAction = system.getLastCommandDescription();
@@ -1163,6 +1302,7 @@ void runAdminMode(TransportSystem& system) {
                     break;
                 }
                 case 15:
+                    reportSave(pendingSave, true);
                     system.saveData();
                     std::cout << "Данные сохранены. Выход из административного режима.\n";
                     running = false;
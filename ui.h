@@ -4,6 +4,8 @@
 #include "transport_system.h"
 #include <string>
 
+class MappedDataset;
+
 // Функции валидации ввода
 bool isValidNumber(const std::string& str);
 bool isValidText(const std::string& str);
@@ -16,6 +18,7 @@ bool isValidLicensePlate(const std::string& str);
 bool isValidDriverCategory(const std::string& str);
 
 void displayGuestMenu();
+void displayReplicaMenu();
 void displayAdminMenu();
 void displayLoginMenu();
 void displayAllStopsForSelection(const TransportSystem& system);
@@ -36,6 +39,8 @@ void showAllTrips(const TransportSystem& system);
 
 void runGuestMode(TransportSystem& system);
 void runAdminMode(TransportSystem& system);
+// Режим реплики: только запросы к отображенному в память снимку (см. MappedDataset)
+void runReplicaMode(const MappedDataset& dataset);
 
 void initializeTestData(TransportSystem& system);
 